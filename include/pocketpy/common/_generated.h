@@ -2,6 +2,8 @@
 // generated by prebuild.py
 
 const char* load_kPythonLib(const char* name);
+// precompiled code of a bundled module, see `python prebuild.py --precompile`
+const char* load_kPythonLibCode(const char* name, int* size);
 
 extern const char kPythonLibs_bisect[];
 extern const char kPythonLibs_builtins[];
@@ -10,6 +12,5 @@ extern const char kPythonLibs_collections[];
 extern const char kPythonLibs_dataclasses[];
 extern const char kPythonLibs_datetime[];
 extern const char kPythonLibs_functools[];
-extern const char kPythonLibs_heapq[];
 extern const char kPythonLibs_operator[];
 extern const char kPythonLibs_typing[];
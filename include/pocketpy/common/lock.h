@@ -0,0 +1,20 @@
+#pragma once
+
+// A lock for short critical sections on process-wide state, e.g. the name table.
+#ifdef _MSC_VER
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef SRWLOCK c11_lock;
+#define C11_LOCK_INIT SRWLOCK_INIT
+#define c11_lock__acquire(self) AcquireSRWLockExclusive(self)
+#define c11_lock__release(self) ReleaseSRWLockExclusive(self)
+#else
+#include <stdatomic.h>
+
+typedef atomic_flag c11_lock;
+#define C11_LOCK_INIT ATOMIC_FLAG_INIT
+#define c11_lock__acquire(self)                                                                    \
+    while(atomic_flag_test_and_set_explicit(self, memory_order_acquire))
+#define c11_lock__release(self) atomic_flag_clear_explicit(self, memory_order_release)
+#endif
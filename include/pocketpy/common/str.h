@@ -8,9 +8,10 @@
 
 /* string */
 typedef struct c11_string {
-    // int size | char[] | '\0'
+    // int size | uint32_t hash | char[] | '\0'
     int size;
-    char data[];  // flexible array member
+    uint32_t hash;  // cached `c11_sv__hash`, 0 if not computed yet
+    char data[];    // flexible array member
 } c11_string;
 
 /* bytes */
@@ -23,6 +24,8 @@ bool c11_bytes__eq(c11_bytes* self, c11_bytes* other);
 
 int c11_sv__cmp(c11_sv self, c11_sv other);
 int c11_sv__cmp2(c11_sv self, const char* other);
+/// Hash of `str` objects, never 0.
+uint32_t c11_sv__hash(c11_sv self);
 
 bool c11__streq(const char* a, const char* b);
 bool c11__sveq(c11_sv a, c11_sv b);
@@ -37,6 +40,9 @@ void c11_string__ctor3(c11_string* self, int size);
 c11_string* c11_string__copy(c11_string* self);
 void c11_string__delete(c11_string* self);
 c11_sv c11_string__sv(c11_string* self);
+/// Same as `c11_sv__hash`, computed once.
+uint32_t c11_string__hash(c11_string* self);
+bool c11_string__eq(c11_string* self, c11_string* other);
 
 int c11_sv__u8_length(c11_sv self);
 c11_sv c11_sv__u8_getitem(c11_sv self, int i);
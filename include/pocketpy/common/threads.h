@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "pocketpy/config.h"
+
+#if PK_ENABLE_THREADS
+
+// Minimal threads, mutexes and condition variables on top of Win32 or pthreads.
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef HANDLE c11_thrd;
+typedef SRWLOCK c11_mutex;
+typedef CONDITION_VARIABLE c11_cond;
+#else
+#include <pthread.h>
+
+typedef pthread_t c11_thrd;
+typedef pthread_mutex_t c11_mutex;
+typedef pthread_cond_t c11_cond;
+#endif
+
+typedef void (*c11_thrd_func)(void* arg);
+
+/// Start `func(arg)` on a new thread. Return false if the thread cannot be created.
+bool c11_thrd__create(c11_thrd* self, c11_thrd_func func, void* arg);
+void c11_thrd__join(c11_thrd* self);
+
+void c11_mutex__ctor(c11_mutex* self);
+void c11_mutex__dtor(c11_mutex* self);
+void c11_mutex__lock(c11_mutex* self);
+void c11_mutex__unlock(c11_mutex* self);
+
+void c11_cond__ctor(c11_cond* self);
+void c11_cond__dtor(c11_cond* self);
+/// Release `mutex`, wait for a signal and lock `mutex` again. It may wake up spuriously.
+void c11_cond__wait(c11_cond* self, c11_mutex* mutex);
+void c11_cond__signal(c11_cond* self);
+void c11_cond__broadcast(c11_cond* self);
+
+#endif
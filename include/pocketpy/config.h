@@ -18,6 +18,25 @@
 #define PK_ENABLE_OS                1
 #endif
 
+// Whether to support worker threads, i.e. `py_vmpool_new()` and `pkpy.executor`
+#ifndef PK_ENABLE_THREADS           // can be overridden by cmake
+    #ifdef __EMSCRIPTEN__
+        #define PK_ENABLE_THREADS       0
+    #else
+        #define PK_ENABLE_THREADS       1
+    #endif
+#endif
+
+// Whether to use computed goto (labels as values) for opcode dispatch
+// Falls back to a plain `switch` if the compiler does not support it
+#ifndef PK_ENABLE_COMPUTED_GOTO     // can be overridden by cmake
+    #if defined(__GNUC__) || defined(__clang__)
+        #define PK_ENABLE_COMPUTED_GOTO     1
+    #else
+        #define PK_ENABLE_COMPUTED_GOTO     0
+    #endif
+#endif
+
 // GC min threshold
 #ifndef PK_GC_MIN_THRESHOLD         // can be overridden by cmake
     #if PK_LOW_MEMORY_MODE
@@ -27,11 +46,19 @@
     #endif
 #endif
 
+// Objects traced by an incremental gc step for each allocated object
+#ifndef PK_GC_STEP_RATIO
+    #define PK_GC_STEP_RATIO            4
+#endif
+
 // Memory allocation functions
 #ifndef PK_MALLOC
 #define PK_MALLOC(size)             malloc(size)
 #define PK_REALLOC(ptr, size)       realloc(ptr, size)
 #define PK_FREE(ptr)                free(ptr)
+#define PK_SYSTEM_MALLOC            1
+#else
+#define PK_SYSTEM_MALLOC            0
 #endif
 
 // This is the maximum size of the value stack in py_TValue units
@@ -44,6 +71,12 @@
     #endif
 #endif
 
+// This is the initial size of the value stack in py_TValue units
+// The stack grows by segments up to `PK_VM_STACK_SIZE`, see `py_setstacksize()`
+#ifndef PK_VM_STACK_INIT_SIZE       // can be overridden by cmake
+#define PK_VM_STACK_INIT_SIZE       256
+#endif
+
 // This is the maximum number of local variables in a function
 // (not recommended to change this)
 #ifndef PK_MAX_CO_VARNAMES          // can be overridden by cmake
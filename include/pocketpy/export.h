@@ -55,3 +55,19 @@
 #else
     #define PK_IS_DESKTOP_PLATFORM 0
 #endif
+
+#if defined(__cplusplus)
+    #define PK_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+    #define PK_THREAD_LOCAL __declspec(thread)
+#else
+    #define PK_THREAD_LOCAL _Thread_local
+#endif
+
+// A thread-local read on the hot path. On ELF this avoids a `__tls_get_addr` call per access
+// when pocketpy is built as a shared library.
+#if defined(__GNUC__) && defined(__ELF__)
+    #define PK_THREAD_LOCAL_FAST PK_THREAD_LOCAL __attribute__((tls_model("initial-exec")))
+#else
+    #define PK_THREAD_LOCAL_FAST PK_THREAD_LOCAL
+#endif
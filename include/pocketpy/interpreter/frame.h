@@ -10,15 +10,36 @@
 py_TValue* FastLocals__try_get_by_name(py_TValue* locals, const CodeObject* co, py_Name name);
 NameDict* FastLocals__to_namedict(py_TValue* locals, const CodeObject* co);
 
+typedef struct ValueStackSegment {
+    struct ValueStackSegment* prev;
+    py_TValue* prev_sp;  // `sp` in `prev` when this segment was entered
+    int capacity;
+    // We allocate extra places to keep `_sp` valid to detect stack overflow
+    py_TValue begin[];
+} ValueStackSegment;
+
 typedef struct ValueStack {
     py_TValue* sp;
     py_TValue* end;
-    // We allocate extra places to keep `_sp` valid to detect stack overflow
-    py_TValue begin[PK_VM_STACK_SIZE + PK_MAX_CO_VARNAMES * 2];
+    ValueStackSegment* segment;  // the segment `sp` points into
+    ValueStackSegment* spare;    // the last segment left, reused by the next split
+    int size;                    // total capacity of the segments in use
+    int initial_size;
+    int max_size;
+    bool is_overflowing;  // raising `StackOverflowError`
 } ValueStack;
 
-void ValueStack__ctor(ValueStack* self);
-void ValueStack__clear(ValueStack* self);
+void ValueStack__ctor(ValueStack* self, int initial_size, int max_size);
+void ValueStack__dtor(ValueStack* self);
+/// Move the values in `[p0, sp)` to a new segment with room for at least `reserve` more values,
+/// and return the new `p0`. The values are copied, so pointers to them must be fixed up.
+/// Raise `StackOverflowError` and return `NULL` if the stack would exceed `max_size`, or return
+/// `p0` unchanged while the error itself is being raised.
+py_TValue* ValueStack__split(ValueStack* self, py_TValue* p0, int reserve);
+/// Set `sp` to `p0`, leaving the current segment if `p0` is where it was split.
+void ValueStack__reset(ValueStack* self, py_TValue* p0);
+/// Release the spare segment.
+int ValueStack__trim(ValueStack* self);
 
 typedef struct UnwindTarget {
     struct UnwindTarget* next;
@@ -1,26 +1,78 @@
+#pragma once
+
 #include "pocketpy/objects/object.h"
 #include "pocketpy/interpreter/objectpool.h"
 
+/* Objects are born in the young generation (the nursery). A minor collection only traces
+ * the nursery from the roots and the remembered set, then promotes the survivors into the
+ * old generation, whose marks stay set until the next full collection. An object is marked
+ * if its `gc_mark` equals `mark_epoch`.
+ * Storing a value into an old object must go through a write barrier, see `pk__gc_barrier`.
+ *
+ * The old generation is collected incrementally. A cycle unmarks every object by flipping
+ * `mark_epoch`, then traces a bounded number of gray objects per step. Marked objects written
+ * during a cycle are re-grayed by the same write barrier, so the tri-color invariant holds
+ * between steps. The last step rescans the roots. No minor collection happens during a cycle.
+ * Dead small objects are then swept lazily, arena by arena, see `MultiPool__begin_sweep`. */
+typedef enum ManagedHeapPhase {
+    GC_PHASE_IDLE,
+    GC_PHASE_MARK,  // an incremental cycle is tracing the heap
+} ManagedHeapPhase;
+
+typedef struct ManagedHeapStats {
+    int collections;       // minor collections
+    int full_collections;  // full collections
+    int last_traced;       // objects marked by the last collection
+    int last_freed;        // objects freed by the last collection
+    int64_t last_mark_ns;
+    int64_t last_sweep_ns;
+    int64_t total_mark_ns;
+    int64_t total_sweep_ns;
+} ManagedHeapStats;
+
 typedef struct ManagedHeap {
     MultiPool small_objects;
-    c11_vector /* PyObject* */ large_objects;
+    c11_vector /* PyObject* */ large_objects;  // old generation only
+    c11_vector /* PyObject* */ young_objects;
+    c11_vector /* PyObject* */ remembered;  // old objects written since the last collection
+    c11_vector /* PyObject* */ gray_objects;  // marked objects whose children are not traced yet
 
     int freed_ma[3];
     int gc_threshold;  // threshold for gc_counter
     int gc_counter;    // objects created since last gc
+    int old_threshold;  // threshold for old_count
+    int old_count;      // objects in the old generation, including dead ones
     bool gc_enabled;
+    ManagedHeapPhase phase;
+    int64_t cycle_mark_ns;  // mark time of the incremental cycle in progress
+    uint8_t mark_epoch;
+    ManagedHeapStats stats;
 } ManagedHeap;
 
 void ManagedHeap__ctor(ManagedHeap* self);
 void ManagedHeap__dtor(ManagedHeap* self);
 
 void ManagedHeap__collect_if_needed(ManagedHeap* self);
+/// Full collection of both generations, after finishing any incremental cycle.
 int ManagedHeap__collect(ManagedHeap* self);
-int ManagedHeap__sweep(ManagedHeap* self);
+/// Full collection, then release the free memory of the heap.
+/// Returns the number of bytes released by the pools and the worklist.
+int ManagedHeap__trim(ManagedHeap* self);
+/// Minor collection of the young generation, or the end of the incremental cycle in progress.
+int ManagedHeap__collect_young(ManagedHeap* self);
+/// Do incremental work for about `budget_ns` nanoseconds.
+/// Returns `true` if no incremental cycle or sweep is in progress afterwards.
+bool ManagedHeap__step(ManagedHeap* self, int64_t budget_ns);
+
+void ManagedHeap__remember(ManagedHeap* self, PyObject* obj);
 
 #define ManagedHeap__new(self, type, slots, udsize)                                                \
     ManagedHeap__gcnew((self), (type), (slots), (udsize))
 PyObject* ManagedHeap__gcnew(ManagedHeap* self, py_Type type, int slots, int udsize);
+/// Allocate a young object with the same size as `src`, which may belong to another heap, and
+/// copy its bytes. Its slots and userdata still have to be relocated, see `VM__clone()`.
+PyObject* ManagedHeap__gcclone(ManagedHeap* self, const PyObject* src);
 
 // external implementation
-void ManagedHeap__mark(ManagedHeap* self);
+void ManagedHeap__mark_roots(ManagedHeap* self);
+int64_t time_ns();
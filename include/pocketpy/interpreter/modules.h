@@ -16,14 +16,19 @@ void pk__add_module_enum();
 void pk__add_module_inspect();
 void pk__add_module_pickle();
 void pk__add_module_importlib();
+void pk__add_module_py_compile();
 
 void pk__add_module_linalg();
 void pk__add_module_array2d();
 void pk__add_module_colorcvt();
+void pk__add_module_collections();
+void pk__add_module_heapq();
+void pk__add_module_functools();
 
 void pk__add_module_conio();
 void pk__add_module_lz4();
 void pk__add_module_pkpy();
+void pk__add_module_executor();
 
 #ifdef PK_BUILD_MODULE_LIBHV
 void pk__add_module_libhv();
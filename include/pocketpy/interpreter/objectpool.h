@@ -3,30 +3,50 @@
 #include "pocketpy/common/vector.h"
 #include "pocketpy/common/str.h"
 
+#include <stdint.h>
+
 #define kPoolArenaSize (120 * 1024)
 #define kMultiPoolCount 5
 #define kPoolMaxBlockSize (32*kMultiPoolCount)
+#define kPoolArenaBitmapLength (kPoolArenaSize / 32 / 64)
 
 typedef struct PoolArena {
     int block_size;
     int block_count;
-    int unused_length;
-    int* unused;
+    int used_length;  // allocated blocks, including the ones in `Pool::free_blocks`
+    int cursor;       // words of `used` before it have no free bit
+    uint64_t used[kPoolArenaBitmapLength];  // allocation bitmap, padding bits are always set
     char data[kPoolArenaSize];
 } PoolArena;
 
+/* Arenas are swept lazily. After a collection every arena goes to `unswept_arenas`, and it is
+ * swept the first time the allocator needs blocks from it, or by an incremental gc step. */
 typedef struct Pool {
-    c11_vector /* PoolArena* */ arenas;
+    c11_vector /* PoolArena* */ arenas;  // swept arenas with free blocks, the last one is in use
     c11_vector /* PoolArena* */ no_free_arenas;
+    c11_vector /* PoolArena* */ unswept_arenas;
     int block_size;
+    // blocks freed by minor collections, reused before the arenas
+    void* free_blocks;
+    int free_blocks_length;
 } Pool;
 
 typedef struct MultiPool {
     Pool pools[kMultiPoolCount];
+    uint8_t live_mark;  // `gc_mark` of the live objects in unswept arenas
 } MultiPool;
 
 void* MultiPool__alloc(MultiPool* self, int size);
-int MultiPool__sweep_dealloc(MultiPool* self);
+/// Return a single block whose object is already destructed. `size_class` is `(size - 1) >> 5`.
+void MultiPool__dealloc(MultiPool* self, void* p, int size_class);
+/// Mark every arena as unswept. Objects whose `gc_mark` is not `live_mark` are dead.
+void MultiPool__begin_sweep(MultiPool* self, uint8_t live_mark);
+/// Sweep unswept arenas until about `work` blocks are visited.
+/// Returns `true` if every arena is swept.
+bool MultiPool__sweep_step(MultiPool* self, int work);
+/// Release the empty arenas and the free pages of a fully swept pool.
+/// Returns the number of released bytes.
+int MultiPool__trim(MultiPool* self);
 void MultiPool__ctor(MultiPool* self);
 void MultiPool__dtor(MultiPool* self);
-c11_string* MultiPool__summary(MultiPool* self);
\ No newline at end of file
+c11_string* MultiPool__summary(MultiPool* self);
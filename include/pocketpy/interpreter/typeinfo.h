@@ -18,12 +18,16 @@ typedef struct py_TypeInfo {
     bool is_python;  // is it a python class? (not derived from c object)
     bool is_sealed;  // can it be subclassed?
 
+    InstanceShape* shape;  // root shape of its instances, python classes only
+    int slots;             // number of slots of its instances declared by `__slots__`, or -1
+
     void (*dtor)(void*);
 
     py_TValue annotations;  // type annotations
 
     void (*on_end_subclass)(struct py_TypeInfo*);  // backdoor for enum module
     void (*gc_mark)(void* ud);
+    bool (*clone)(void* ud);  // relocate the userdata of a copied instance, see `VM__clone()`
 
     /* Magic Slots */
     py_TValue magic_0[PK_MAGIC_SLOTS_COMMON_LENGTH];  // common magic slots
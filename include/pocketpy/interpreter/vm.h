@@ -2,6 +2,7 @@
 
 #include "pocketpy/common/memorypool.h"
 #include "pocketpy/objects/codeobject.h"
+#include "pocketpy/objects/dict.h"
 #include "pocketpy/pocketpy.h"
 #include "pocketpy/interpreter/heap.h"
 #include "pocketpy/interpreter/frame.h"
@@ -34,6 +35,9 @@ typedef struct VM {
     volatile bool is_signal_interrupted;
     bool is_curr_exc_handled;  // handled by try-except block but not cleared yet
 
+    uint32_t type_version;    // bumped whenever a type's `__dict__` is mutated
+    uint32_t module_version;  // source of unique module versions, see `pk__module_version`
+
     py_TValue reg[8];  // users' registers
     void* ctx;         // user-defined context
 
@@ -47,7 +51,14 @@ typedef struct VM {
 } VM;
 
 void VM__ctor(VM* self);
+/// Initialize a VM without any type or module, to be filled by `VM__ctor()` or `VM__clone()`.
+void VM__ctor_empty(VM* self);
 void VM__dtor(VM* self);
+/// Fill the empty VM `self` with a copy of the types, modules and heap of `src`.
+/// `src` must be idle and it is only read, so it can be cloned by several threads at once.
+/// On failure `*error` is the name of a type whose instances can't be cloned, and `self` must
+/// be destroyed.
+bool VM__clone(VM* self, VM* src, py_Name* error);
 
 void VM__push_frame(VM* self, Frame* frame);
 void VM__pop_frame(VM* self);
@@ -55,10 +66,48 @@ void VM__pop_frame(VM* self);
 bool pk__parse_int_slice(py_Ref slice, int length, int* start, int* stop, int* step);
 bool pk__normalize_index(int* index, int length);
 
-#define pk__mark_value(val) if((val)->is_ptr && !(val)->_obj->gc_marked) PyObject__mark((val)->_obj)
+#define pk__is_marked(obj) ((obj)->gc_mark == pk_current_vm->heap.mark_epoch)
+#define pk__mark_value(val) if((val)->is_ptr && !pk__is_marked((val)->_obj)) PyObject__mark((val)->_obj)
+/// Write barrier of the generational gc. Call it right after storing values into `obj`.
+#define pk__gc_barrier(obj)                                                                        \
+    do {                                                                                           \
+        PyObject* _obj = (obj);                                                                    \
+        if(pk__is_marked(_obj) && !_obj->gc_remembered) {                                          \
+            ManagedHeap__remember(&pk_current_vm->heap, _obj);                                     \
+        }                                                                                          \
+    } while(0)
+/// Version of a module's `__dict__` keys, stored as the module's userdata.
+/// It is renewed from `VM::module_version` whenever a name is added or removed.
+#define pk__module_version(mod) (*(uint32_t*)((mod)->_obj->flex + sizeof(NameDict)))
+void pk__module_touch(py_Ref module);
+
 void pk__mark_namedict(NameDict*);
 void pk__tp_set_marker(py_Type type, void (*gc_mark)(void*));
+/// Set the function relocating the userdata of a copied instance, see `VM__clone()`.
+/// It returns `false` if the instance can't be cloned. Instances of types with a `dtor` or a
+/// `gc_mark` but without a cloner can't be cloned either.
+void pk__tp_set_cloner(py_Type type, bool (*clone)(void*));
+bool pk__clone_unsupported(void* ud);
+/// The copy of an object of the source VM of `VM__clone()`.
+PyObject* pk__clone_object(PyObject* obj);
+/// Relocate a value copied from the source VM of `VM__clone()`.
+void pk__clone_value(py_TValue* val);
+/// Copy the storage of a `NameDict` shared with the source VM, and relocate its values.
+void pk__clone_namedict(NameDict* dict);
+/// Copy the storage of a `Dict` shared with the source VM, and relocate its entries.
+/// The keys are rehashed after the whole heap is relocated. The values of a set are unused, so
+/// they are only reset when `is_set` is true.
+void pk__clone_dict(Dict* dict, bool is_set);
+/// Deep copy a `CodeObject` shared with the source VM.
+void pk__clone_code(CodeObject* code);
+/// The copy of a `FuncDecl` of the source VM, with a new reference.
+FuncDecl_ pk__clone_funcdecl(FuncDecl_ decl);
 bool pk__object_new(int argc, py_Ref argv);
+/// Create an instance of a python class, with fixed slots if its class has `__slots__`, otherwise
+/// with a `__dict__` stored by shape.
+void pk__newinstance(py_OutRef out, py_Type type);
+/// Lay out the instances of a newly defined class by its `__slots__`.
+bool pk__tp_init_slots(py_Type type);
 py_TypeInfo* pk__type_info(py_Type type);
 
 bool pk_wrapper__self(int argc, py_Ref argv);
@@ -85,15 +134,27 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
 
 const char* pk_opname(Opcode op);
 
+/// The default `importfile` callback, which reads from the disk.
+char* pk_default_importfile(const char* path);
+
 int pk_arrayview(py_Ref self, py_TValue** p);
 bool pk_wrapper__arrayequal(py_Type type, int argc, py_Ref argv);
 bool pk_arrayiter(py_Ref val);
+bool pk_rangeview(py_Ref self, py_i64* start, py_i64* stop, py_i64* step);
 bool pk_arraycontains(py_Ref self, py_Ref val);
 
 bool pk_loadmethod(py_StackRef self, py_Name name);
+/// `pk_loadmethod` with the class attribute `cls_var` already resolved from `type`.
+bool pk_loadmethod_clsvar(py_StackRef self, py_Type type, py_Ref cls_var);
+/// `py_getattr` with the class attribute `cls_var` already resolved.
+bool pk_getattr_clsvar(py_Ref self, py_Name name, py_Ref cls_var);
+/// `py_setattr` with the class attribute `cls_var` already resolved.
+bool pk_setattr_clsvar(py_Ref self, py_Name name, py_Ref val, py_Ref cls_var);
 bool pk_callmagic(py_Name name, int argc, py_Ref argv);
 
 bool pk_exec(CodeObject* co, py_Ref module);
+/// Run a bundled python module, from its precompiled code if it is up to date.
+bool pk_exec_pythonlib(const char* name, const char* source, const char* filename, py_Ref module);
 
 /// Assumes [a, b] are on the stack, performs a binary op.
 /// The result is stored in `self->last_retval`.
@@ -110,6 +171,9 @@ py_Type pk_str_iterator__register();
 py_Type pk_bytes__register();
 py_Type pk_dict__register();
 py_Type pk_dict_items__register();
+py_Type pk_set__register();
+py_Type pk_frozenset__register();
+py_Type pk_set_iterator__register();
 py_Type pk_list__register();
 py_Type pk_tuple__register();
 py_Type pk_array_iterator__register();
@@ -119,11 +183,16 @@ py_Type pk_nativefunc__register();
 py_Type pk_boundmethod__register();
 py_Type pk_range__register();
 py_Type pk_range_iterator__register();
+py_Type pk_map__register();
+py_Type pk_filter__register();
+py_Type pk_zip__register();
+py_Type pk_enumerate__register();
 py_Type pk_BaseException__register();
 py_Type pk_Exception__register();
 py_Type pk_StopIteration__register();
 py_Type pk_super__register();
 py_Type pk_property__register();
+py_Type pk_member_descriptor__register();
 py_Type pk_staticmethod__register();
 py_Type pk_classmethod__register();
 py_Type pk_generator__register();
@@ -4,7 +4,7 @@
 
 typedef struct PyObject PyObject;
 typedef struct VM VM;
-extern VM* pk_current_vm;
+extern PK_THREAD_LOCAL_FAST VM* pk_current_vm;  // each thread runs its own VM
 
 typedef struct py_TValue {
     py_Type type;
@@ -45,9 +45,19 @@ typedef enum Opcode {
 #undef OPCODE
 } Opcode;
 
+// the number of opcodes, any `op` of a valid `Bytecode` is less than it
+enum {
+    kOpcodeCount = 0
+#define OPCODE(name) +1
+#include "pocketpy/xmacros/opcodes.h"
+#undef OPCODE
+};
+
+#define BC_MAX_ARG 0xFFFFFF
+
 typedef struct Bytecode {
-    uint8_t op;
-    uint16_t arg;
+    uint32_t op : 8;
+    uint32_t arg : 24;  // wide enough for any `py_Name`, signed args only use 16 bits
 } Bytecode;
 
 void Bytecode__set_signed_arg(Bytecode* self, int arg);
@@ -65,8 +75,25 @@ typedef struct BytecodeEx {
     int lineno;       // line number for each bytecode
     bool is_virtual;  // whether this bytecode is virtual (not in source code)
     int iblock;       // block index
+    int icache;       // inline cache index, -1 if this bytecode has no cache
 } BytecodeEx;
 
+/// Inline cache of `LOAD_ATTR`, `LOAD_METHOD` and `STORE_ATTR`.
+typedef struct AttrCache {
+    py_Type type;                 // receiver type
+    uint32_t version;             // `VM::type_version` when filled, 0 means empty
+    py_TValue* cls_var;           // resolved class attribute, NULL if not found
+    struct InstanceShape* shape;  // receiver shape of an instance attribute, NULL means empty
+    int offset;                   // offset of the instance attribute in `shape`
+} AttrCache;
+
+/// Inline cache of `LOAD_GLOBAL` and `LOAD_NONLOCAL`.
+typedef struct GlobalCache {
+    uint32_t module_version;    // version of the frame's module when filled, 0 means empty
+    uint32_t builtins_version;  // version of builtins when filled
+    py_TValue* slot;            // resolved slot in the module or builtins `__dict__`
+} GlobalCache;
+
 typedef struct CodeObject {
     SourceData_ src;
     c11_string* name;
@@ -83,6 +110,9 @@ typedef struct CodeObject {
     c11_vector /*T=CodeBlock*/ blocks;
     c11_vector /*T=FuncDecl_*/ func_decls;
 
+    c11_vector /*T=AttrCache*/ attr_caches;      // indexed by `BytecodeEx::icache`
+    c11_vector /*T=GlobalCache*/ global_caches;  // indexed by `BytecodeEx::icache`
+
     int start_line;
     int end_line;
 } CodeObject;
@@ -90,11 +120,18 @@ typedef struct CodeObject {
 void CodeObject__ctor(CodeObject* self, SourceData_ src, c11_sv name);
 void CodeObject__dtor(CodeObject* self);
 int CodeObject__add_varname(CodeObject* self, py_Name name);
+void CodeObject__init_caches(CodeObject* self);
 void CodeObject__gc_mark(const CodeObject* self);
+/// Serialize a compiled module into `out` (T=char). `source` is hashed to detect stale blobs.
+void CodeObject__dumps(const CodeObject* self, const char* source, c11_vector* out);
+/// Deserialize a compiled module. If `source` is not NULL, it must be the one the blob was
+/// compiled from and it is kept for tracebacks.
+/// @return NULL on success or an error message.
+const char* CodeObject__loads(CodeObject* out, const char* data, int size, const char* source);
 
 typedef struct FuncDeclKwArg {
     int index;        // index in co->varnames
-    uint16_t key;     // name of this argument
+    py_Name key;      // name of this argument
     py_TValue value;  // default value
 } FuncDeclKwArg;
 
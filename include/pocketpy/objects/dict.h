@@ -0,0 +1,48 @@
+#pragma once
+
+#include "pocketpy/common/vector.h"
+#include "pocketpy/objects/base.h"
+#include <stdint.h>
+
+/* The open-hash engine shared by `dict`, `set` and `frozenset`.
+ * Entries are kept in insertion order. A power-of-two table of slots maps hashes to entries, and
+ * each slot has a control byte, which is empty, deleted, or 7 bits of the hash. Slots are probed
+ * in aligned groups of `kDictGroupSize` whose control bytes are matched at once. */
+typedef struct {
+    uint64_t hash;
+    py_TValue key;
+    py_TValue val;  // always nil for sets
+} DictEntry;
+
+#define kDictGroupSize 16
+
+typedef struct {
+    int length;
+    uint32_t capacity;  // number of slots, a power of two and a multiple of `kDictGroupSize`
+    uint32_t used;      // slots that are not empty, including the deleted ones
+    uint8_t* ctrl;      // control bytes of the slots
+    int* indices;       // entry index of each full slot
+    c11_vector /*T=DictEntry*/ entries;
+} Dict;
+
+typedef struct {
+    DictEntry* curr;
+    DictEntry* end;
+} DictIterator;
+
+/// `capacity` must be a power of two, it is rounded up to `kDictGroupSize`.
+void Dict__ctor(Dict* self, uint32_t capacity, int entries_capacity);
+void Dict__dtor(Dict* self);
+void Dict__copy(Dict* self, const Dict* other);
+void Dict__clear(Dict* self);
+bool Dict__try_get(Dict* self, py_TValue* key, DictEntry** out);
+bool Dict__set(Dict* self, py_TValue* key, py_TValue* val);
+/// Delete an entry from the dict.
+/// -1: error, 0: not found, 1: found and deleted
+int Dict__pop(Dict* self, py_TValue* key);
+/// Recompute the hashes of the keys which are objects and rebuild the table, after the keys are
+/// moved to another heap. On error, `*failed` is the type of the key which can't be hashed.
+bool Dict__rehash_keys(Dict* self, py_Type* failed);
+
+void DictIterator__ctor(DictIterator* self, Dict* dict);
+DictEntry* DictIterator__next(DictIterator* self);
@@ -6,7 +6,7 @@
 #include <stdint.h>
 
 #define SMALLMAP_T__HEADER
-#define K uint16_t
+#define K py_Name
 #define V py_TValue
 #define NAME NameDict
 #include "pocketpy/xmacros/smallmap.h"
@@ -1,27 +1,36 @@
 #pragma once
 
 #include "pocketpy/objects/namedict.h"
+#include "pocketpy/objects/shape.h"
 #include "pocketpy/objects/base.h"
 
 typedef struct PyObject {
     py_Type type;  // we have a duplicated type here for convenience
-    // bool _;
-    bool gc_marked;
+    uint8_t gc_mark;  // marked if equal to `ManagedHeap::mark_epoch`, sticky in the old generation
+    uint8_t gc_remembered : 1;  // in the remembered set of `ManagedHeap`
+    uint8_t gc_size_class : 7;  // index of its `MultiPool` pool, or `kMultiPoolCount` if large
     int slots;  // number of slots in the object
     char flex[];
 } PyObject;
 
 // slots >= 0, allocate N slots
 // slots == -1, allocate a dict
+// slots <= -2, allocate an instance dict with (-2 - slots) inline values
 
-// | HEADER | <N slots> | <userdata>
-// | HEADER | <dict>    | <userdata>
+// | HEADER | <N slots>       | <userdata>
+// | HEADER | <dict>          | <userdata>
+// | HEADER | <instance dict> | <userdata>
 
 py_TValue* PyObject__slots(PyObject* self);
 NameDict* PyObject__dict(PyObject* self);
+InstanceDict* PyObject__instancedict(PyObject* self);
 void* PyObject__userdata(PyObject* self);
 
-#define PK_OBJ_SLOTS_SIZE(slots) ((slots) >= 0 ? sizeof(py_TValue) * (slots) : sizeof(NameDict))
+#define PK_OBJ_SLOTS_SIZE(slots)                                                                   \
+    ((slots) >= 0    ? sizeof(py_TValue) * (slots)                                                 \
+     : (slots) == -1 ? sizeof(NameDict)                                                            \
+                     : InstanceDict__size(-2 - (slots)))
 
 void PyObject__dtor(PyObject* self);
 void PyObject__mark(PyObject* self);
+void PyObject__mark_children(PyObject* self);
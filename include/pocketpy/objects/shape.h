@@ -0,0 +1,54 @@
+#pragma once
+
+#include "pocketpy/common/vector.h"
+#include "pocketpy/common/smallmap.h"
+#include "pocketpy/objects/namedict.h"
+#include "pocketpy/objects/base.h"
+
+#define kShapeMaxLength 64       // an instance with more attributes falls back to a dict
+#define kShapeMaxTransitions 32  // a shape with more transitions sends new attributes to a dict
+#define kShapeMaxInline 16       // max number of inline values of an instance
+
+/// A hidden class. Instances of a python class whose attributes were added in the same order
+/// share a shape, which maps each attribute to its offset in the values of the instance.
+typedef struct InstanceShape {
+    struct InstanceShape* parent;                   // NULL for the root
+    py_Name name;                                   // the last added attribute, 0 for the root
+    int length;                                     // number of attributes
+    int max_length;                                 // root only, the longest shape so far
+    c11_smallmap_n2i offsets;                       // attribute -> offset
+    c11_vector /*T=InstanceShape* */ transitions;  // children, one per added attribute
+} InstanceShape;
+
+InstanceShape* InstanceShape__new(InstanceShape* parent, py_Name name);
+void InstanceShape__delete(InstanceShape* self);
+/// The offset of `name`, or `-1` if not found.
+int InstanceShape__find(const InstanceShape* self, py_Name name);
+
+/// The `__dict__` of an instance of a python class.
+/// It falls back to a `NameDict` when its shape would grow too large or an attribute is deleted.
+typedef struct InstanceDict {
+    InstanceShape* shape;  // NULL in dict mode
+    union {
+        py_TValue* overflow;  // values past the inline ones
+        NameDict* dict;       // used in dict mode
+    };
+    int capacity;           // number of inline values
+    int overflow_capacity;  // number of values allocated in `overflow`
+    py_TValue values[];     // inline values
+} InstanceDict;
+
+#define InstanceDict__size(capacity) (sizeof(InstanceDict) + sizeof(py_TValue) * (capacity))
+#define InstanceDict__at(self, offset)                                                             \
+    ((offset) < (self)->capacity ? (self)->values + (offset)                                       \
+                                 : (self)->overflow + ((offset) - (self)->capacity))
+
+void InstanceDict__ctor(InstanceDict* self, InstanceShape* root, int capacity);
+void InstanceDict__dtor(InstanceDict* self);
+py_TValue* InstanceDict__try_get(InstanceDict* self, py_Name name);
+void InstanceDict__set(InstanceDict* self, py_Name name, py_TValue val);
+bool InstanceDict__del(InstanceDict* self, py_Name name);
+void InstanceDict__clear(InstanceDict* self);
+int InstanceDict__length(InstanceDict* self);
+/// The `i`-th attribute, in the same order as `NameDict`. Its name is written to `name`.
+py_TValue* InstanceDict__item(InstanceDict* self, int i, py_Name* name);
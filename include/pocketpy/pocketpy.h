@@ -18,7 +18,7 @@ extern "C" {
 typedef struct py_TValue py_TValue;
 /// An integer that represents a python identifier. This is to achieve string pooling and fast name
 /// resolution.
-typedef uint16_t py_Name;
+typedef uint32_t py_Name;
 /// An integer that represents a python type. `0` is invalid.
 typedef int16_t py_Type;
 /// A 64-bit integer type. Corresponds to `int` in python.
@@ -76,15 +76,33 @@ enum py_CompileMode { EXEC_MODE, EVAL_MODE, SINGLE_MODE };
 
 /// Initialize pocketpy and the default VM.
 PK_API void py_initialize();
-/// Finalize pocketpy and free all VMs.
+/// Finalize pocketpy and free all VMs. No other thread may use a VM during or after this call.
 PK_API void py_finalize();
 /// Get the current VM index.
 PK_API int py_currentvm();
-/// Switch to a VM.
-/// @param index index of the VM ranging from 0 to 16 (exclusive). `0` is the default VM.
+/// Switch to a VM, which is created on first use.
+/// The current VM is per thread, so different VMs can run on different threads concurrently.
+/// A VM must not be used by two threads at the same time.
+/// @param index index of the VM, a non-negative integer. `0` is the default VM.
 PK_API void py_switchvm(int index);
 /// Reset the current VM.
 PK_API void py_resetvm();
+/// Switch to a VM like `py_switchvm()`, but create it as a copy of VM `src`, replacing the VM
+/// if it exists. This is much faster than creating a VM and importing the same modules again.
+/// `src` must exist and be idle, i.e. no code is running on it. It is only read, so several
+/// threads can clone the same VM at once while no thread uses it.
+/// Objects which own native resources can't be cloned, such as files, generators, exceptions and
+/// instances of native types with a `dtor`. If `src` refers to any of them, a fresh VM is
+/// created instead and `TypeError` is raised.
+/// @param index index of the new VM, which must not be `src`.
+PK_API bool py_clonevm(int index, int src) PY_RAISE;
+/// Set the initial and the maximum size of the value stack of the current VM, in values.
+/// The stack starts small and grows by segments up to `max_size`, beyond which
+/// `StackOverflowError` is raised. Calls between python functions don't use the C stack, but calls
+/// through native functions do, so a large `max_size` may need a larger C stack as well.
+/// The stack must be empty, e.g. right after the VM is created. `py_resetvm()` restores the
+/// defaults, `PK_VM_STACK_INIT_SIZE` and `PK_VM_STACK_SIZE`.
+PK_API void py_setstacksize(int size, int max_size);
 /// Get the current VM context. This is used for user-defined data.
 PK_API void* py_getvmctx();
 /// Set the current VM context. This is used for user-defined data.
@@ -95,6 +113,15 @@ PK_API void py_interrupt();
 PK_API void py_sys_setargv(int argc, char** argv);
 /// Setup the callbacks for the current VM.
 PK_API py_Callbacks* py_callbacks();
+/// Run the garbage collector incrementally for about `budget_us` microseconds.
+/// Call it in idle time, e.g. at the end of a frame, to avoid long pauses at allocation time.
+/// @return `true` if no collection cycle is in progress afterwards.
+PK_API bool py_gc_step(int budget_us);
+/// Run a full collection and release the free memory of the heap, e.g. after a load spike.
+/// Live objects are never moved, but empty arenas, the pages of free blocks and the spare
+/// segment of the value stack are released.
+/// @return the number of released bytes.
+PK_API int py_gc_trim();
 
 /// Run a source string.
 /// @param source source string.
@@ -131,6 +158,16 @@ PK_API bool py_compile(const char* source,
                           const char* filename,
                           enum py_CompileMode mode,
                           bool is_dynamic) PY_RAISE PY_RETURN;
+/// Compile a source file into a binary code file (`.pkc`).
+/// `import` prefers `x.pkc` over `x.py` while the source is unchanged, which skips the compiler.
+/// A `.pkc` file without its source is imported as is.
+/// @param filename filename (for error messages). Use NULL for `src_path`.
+PK_API bool py_compilefile(const char* src_path,
+                           const char* dst_path,
+                           const char* filename) PY_RAISE;
+/// Run the content of a binary code file created by `py_compilefile`.
+/// @param module target module. Use NULL for the main module.
+PK_API bool py_execbinary(const char* data, int size, py_Ref module) PY_RAISE PY_RETURN;
 
 /// Python equivalent to `globals()`.
 PK_API void py_newglobals(py_OutRef);
@@ -184,6 +221,8 @@ PK_API void py_newlist(py_OutRef);
 PK_API void py_newlistn(py_OutRef, int n);
 /// Create an empty `dict`.
 PK_API void py_newdict(py_OutRef);
+/// Create an empty `set`.
+PK_API void py_newset(py_OutRef);
 /// Create an UNINITIALIZED `slice` object.
 /// You should use `py_setslot()` to set `start`, `stop`, and `step`.
 PK_API void py_newslice(py_OutRef);
@@ -269,6 +308,7 @@ PK_API void* py_touserdata(py_Ref);
 #define py_islist(self) py_istype(self, tp_list)
 #define py_istuple(self) py_istype(self, tp_tuple)
 #define py_isdict(self) py_istype(self, tp_dict)
+#define py_isset(self) py_istype(self, tp_set)
 
 #define py_isnil(self) py_istype(self, 0)
 #define py_isnone(self) py_istype(self, tp_NoneType)
@@ -362,6 +402,7 @@ PK_API bool
 
 /// Get the i-th slot of the object.
 /// The object must have slots and `i` must be in valid range.
+/// Use `py_setslot()` to store a value into an existing object.
 PK_API py_ObjectRef py_getslot(py_Ref self, int i);
 /// Set the i-th slot of the object.
 PK_API void py_setslot(py_Ref self, int i, py_Ref val);
@@ -491,7 +532,8 @@ PK_API bool py_pusheval(const char* expr, py_GlobalRef module) PY_RAISE;
 
 /// Create a new module.
 PK_API py_GlobalRef py_newmodule(const char* path);
-/// Get a module by path.
+/// Get a module by path. Built-in native modules are created on first use.
+/// Return `NULL` if not found.
 PK_API py_GlobalRef py_getmodule(const char* path);
 /// Reload an existing module.
 PK_API bool py_importlib_reload(py_GlobalRef module) PY_RAISE PY_RETURN;
@@ -594,10 +636,41 @@ PK_API bool py_len(py_Ref val) PY_RAISE PY_RETURN;
 PK_API bool py_json_dumps(py_Ref val) PY_RAISE PY_RETURN;
 /// Python equivalent to `json.loads(val)`.
 PK_API bool py_json_loads(const char* source) PY_RAISE PY_RETURN;
+/// Python equivalent to `json.loads(val)`, for a source that is not null-terminated.
+PK_API bool py_json_loadsv(c11_sv source) PY_RAISE PY_RETURN;
 /// Python equivalent to `pickle.dumps(val)`.
 PK_API bool py_pickle_dumps(py_Ref val) PY_RAISE PY_RETURN;
 /// Python equivalent to `pickle.loads(val)`.
 PK_API bool py_pickle_loads(const unsigned char* data, int size) PY_RAISE PY_RETURN;
+/************* Worker Pool *************/
+
+/// A pool of VMs, each running on its own worker thread.
+typedef struct py_VMPool py_VMPool;
+/// The pending result of a task submitted to a `py_VMPool`.
+typedef struct py_VMFuture py_VMFuture;
+
+/// Create a pool of `size` VMs on worker threads.
+/// Worker VMs are not indexed, i.e. `py_currentvm()` returns `-1` on them.
+/// @param init called on each worker thread after its VM is created, e.g. to bind modules.
+/// Use `NULL` if not needed.
+/// @param ctx passed to `init`.
+/// @return the pool, or `NULL` if threads are not supported.
+PK_API py_VMPool* py_vmpool_new(int size, void (*init)(void* ctx), void* ctx);
+/// Wait for all submitted tasks, then stop the worker threads and destroy their VMs.
+/// A pool must be deleted before `py_finalize()`.
+PK_API void py_vmpool_delete(py_VMPool* self);
+/// Submit `func(*args)` to the pool, where `func_path` is like `"module.func"`.
+/// `args` must be a `tuple`. It is pickled here and unpickled by a worker VM.
+/// @return a future to be deleted by `py_vmfuture_delete()`, or `NULL` if an exception is raised.
+PK_API py_VMFuture* py_vmpool_submit(py_VMPool* self, const char* func_path, py_Ref args) PY_RAISE;
+/// Check if the task is done without waiting.
+PK_API bool py_vmfuture_done(py_VMFuture* self);
+/// Wait for the task and unpickle its result in the current VM.
+/// If the task failed, raise a `RuntimeError` with the formatted exception of the worker.
+PK_API bool py_vmfuture_result(py_VMFuture* self) PY_RAISE PY_RETURN;
+/// Release a future. The task still runs if it is not done.
+PK_API void py_vmfuture_delete(py_VMFuture* self);
+
 /************* Unchecked Functions *************/
 
 PK_API py_ObjectRef py_tuple_data(py_Ref self);
@@ -642,6 +715,15 @@ PK_API bool
 /// noexcept
 PK_API int py_dict_len(py_Ref self);
 
+/// -1: error, 0: not found, 1: found
+PK_API int py_set_contains(py_Ref self, py_Ref key) PY_RAISE;
+/// true: success, false: error
+PK_API bool py_set_add(py_Ref self, py_Ref key) PY_RAISE;
+/// -1: error, 0: not found, 1: found (and deleted)
+PK_API int py_set_discard(py_Ref self, py_Ref key) PY_RAISE;
+/// noexcept
+PK_API int py_set_len(py_Ref self);
+
 /************* linalg module *************/
 void py_newvec2(py_OutRef out, c11_vec2);
 void py_newvec3(py_OutRef out, c11_vec3);
@@ -746,6 +828,18 @@ enum py_PredefinedTypes {
     tp_array2d,
     tp_array2d_view,
     tp_chunked_array2d,
+    /* new types are appended below, so that the values above do not change */
+    tp_set,
+    tp_frozenset,
+    tp_set_iterator,       // 1 slot
+    tp_map,                // N slots
+    tp_filter,             // 2 slots
+    tp_zip,                // N slots
+    tp_enumerate,          // 1 slot
+    tp_member_descriptor,  // int index
+    /* collections */
+    tp_deque,
+    tp_deque_iterator,  // 1 slot + int index
 };
 
 #ifdef __cplusplus
@@ -517,7 +517,7 @@ struct template_parser<Callable,
 class cpp_function : public function {
     PKBIND_TYPE_IMPL(function, cpp_function, tp_function);
 
-    inline static lazy<py_Type> tp_function_record = +[](py_Type& type) {
+    inline static thread_local lazy<py_Type> tp_function_record = +[](py_Type& type) {
         type = py_newtype("function_record", tp_object, nullptr, [](void* data) {
             static_cast<impl::function_record*>(data)->~function_record();
         });
@@ -33,10 +33,11 @@ struct action {
 };
 
 /// hold the object long time.
+/// the pool lives in a register of the current vm, so it is per thread like the current vm.
 struct object_pool {
-    inline static int cache = -1;
-    inline static py_Ref pool = nullptr;
-    inline static std::vector<int>* indices_ = nullptr;
+    inline static thread_local int cache = -1;
+    inline static thread_local py_Ref pool = nullptr;
+    inline static thread_local std::vector<int>* indices_ = nullptr;
 
     struct object_ref {
         py_Ref data;
@@ -29,7 +29,8 @@ public:
     using object ::object;
     using object ::operator=;
 
-    inline static std::unordered_map<std::type_index, py_Type> m_type_map;
+    // types are registered per vm, and the current vm is per thread.
+    inline static thread_local std::unordered_map<std::type_index, py_Type> m_type_map;
 
     // note: type is global instance, so we use ref_t.
     explicit type(py_Type type) : object(py_tpobject(type), ref_t{}) {}
@@ -339,7 +340,7 @@ class capsule : public object {
         void (*destructor)(void*);
     };
 
-    inline static lazy<py_Type> tp_capsule = +[](py_Type& type) {
+    inline static thread_local lazy<py_Type> tp_capsule = +[](py_Type& type) {
         type = py_newtype("capsule", tp_object, nullptr, [](void* data) {
             auto impl = static_cast<capsule_impl*>(data);
             if(impl->data && impl->destructor) { impl->destructor(impl->data); }
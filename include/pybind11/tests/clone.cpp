@@ -0,0 +1,169 @@
+#include "test.h"
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* kSnapshot = R"(
+import json
+from collections import deque
+from array2d import array2d
+
+class Point:
+    def __init__(self, x, y):
+        self.x = x
+        self.y = y
+
+    def __eq__(self, other):
+        return self.x == other.x and self.y == other.y
+
+    def __ne__(self, other):
+        return not self == other
+
+    def __hash__(self):
+        return hash((self.x, self.y))
+
+class Key:
+    pass
+
+def make_counter():
+    n = [0]
+    def inc():
+        n[0] += 1
+        return n[0]
+    return inc
+
+key = Key()
+table = {key: 'key', Point(1, 2): 'point', 'a': [1, 2.5, (3, 4)]}
+seen = {key, 1, 'b'}
+queue = deque([1, 2, 3])
+grid = array2d(2, 2, default=0)
+grid[1, 1] = Point(3, 4)
+counter = make_counter()
+counter()
+config = json.loads('{"debug": true}')
+)";
+
+bool clone(int index, int src) {
+    if(py_clonevm(index, src)) return true;
+    py_printexc();
+    py_clearexc(NULL);
+    return false;
+}
+
+bool eval_true(const char* source) {
+    if(!py_eval(source, NULL)) {
+        py_printexc();
+        return false;
+    }
+    return py_tobool(py_retval());
+}
+
+// VM 0 has pkbind's function records, which own C++ objects, so the snapshots are taken on a
+// fresh VM, whose index is not used by other tests
+const int kSource = 100;
+
+void switch_to_fresh_vm(int index) {
+    py_switchvm(index);
+    py_resetvm();
+}
+
+bool exec_snapshot(const char* source) {
+    if(py_exec(source, "<snapshot>", EXEC_MODE, NULL)) return true;
+    py_printexc();
+    return false;
+}
+
+TEST_F(PYBIND11_TEST, clone) {
+    switch_to_fresh_vm(kSource);
+    ASSERT_TRUE(exec_snapshot(kSnapshot));
+    ASSERT_TRUE(clone(kSource + 1, kSource));
+    EXPECT_EQ(py_currentvm(), kSource + 1);
+    // identity hashes are the new addresses
+    EXPECT_TRUE(eval_true("table[key] == 'key' and key in seen and len(seen) == 3"));
+    EXPECT_TRUE(eval_true("table[Point(1, 2)] == 'point' and table['a'][2] == (3, 4)"));
+    EXPECT_TRUE(eval_true("list(queue) == [1, 2, 3] and grid[1, 1] == Point(3, 4)"));
+    EXPECT_TRUE(eval_true("counter() == 2 and config['debug']"));
+    EXPECT_TRUE(eval_true("json.dumps([1]) == '[1]' and type(key).__name__ == 'Key'"));
+    ASSERT_TRUE(py_exec("queue.append(4); grid[0, 0] = 5; import gc; gc.collect()",
+                        "<clone>",
+                        EXEC_MODE,
+                        NULL));
+    EXPECT_TRUE(eval_true("len(queue) == 4 and grid[0, 0] == 5 and counter() == 3"));
+
+    // a clone can be cloned again
+    for(int i = 2; i < 5; i++) {
+        ASSERT_TRUE(clone(kSource + i, kSource + i - 1));
+        EXPECT_TRUE(eval_true("len(seen) == 3 and key in seen and 1 in seen and 'b' in seen"));
+        EXPECT_TRUE(eval_true("table[key] == 'key' and len(queue) == 4"));
+    }
+
+    // the source is unchanged
+    py_switchvm(kSource);
+    EXPECT_TRUE(eval_true("len(queue) == 3 and grid[0, 0] == 0 and counter() == 2"));
+    py_switchvm(0);
+}
+
+TEST_F(PYBIND11_TEST, clone_unsupported) {
+    switch_to_fresh_vm(kSource);
+    ASSERT_TRUE(py_exec("def gen():\n    yield 1\ng = gen()", "<snapshot>", EXEC_MODE, NULL));
+    EXPECT_FALSE(py_clonevm(kSource + 1, kSource));
+    EXPECT_TRUE(py_matchexc(tp_TypeError));
+    py_clearexc(NULL);
+    // a fresh vm is created instead
+    EXPECT_EQ(py_currentvm(), kSource + 1);
+    EXPECT_TRUE(eval_true("'g' not in globals() and sum([1, 2]) == 3"));
+    py_switchvm(0);
+}
+
+TEST_F(PYBIND11_TEST, clone_threads) {
+    switch_to_fresh_vm(kSource);
+    ASSERT_TRUE(exec_snapshot(kSnapshot));
+    const int N = 4;
+    std::vector<int> results(N);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < N; i++) {
+        threads.emplace_back([i, &results] {
+            for(int k = 0; k < 20; k++) {
+                if(!clone(kSource + 1 + i, kSource)) return;
+                for(int j = 0; j <= i; j++) {
+                    if(!py_eval("counter()", NULL)) return;
+                }
+                results[i] += py_toint(py_retval());
+            }
+        });
+    }
+    for(auto& thread: threads) {
+        thread.join();
+    }
+    for(int i = 0; i < N; i++) {
+        EXPECT_EQ(results[i], 20 * (i + 2));
+    }
+    py_switchvm(0);
+}
+
+TEST_F(PYBIND11_TEST, clone_stack_size) {
+    switch_to_fresh_vm(kSource);
+    py_setstacksize(64, 1 << 20);
+    const char* source = "def depth(n):\n    return 0 if n == 0 else depth(n - 1) + 1";
+    ASSERT_TRUE(py_exec(source, "<snapshot>", EXEC_MODE, NULL));
+    EXPECT_TRUE(eval_true("depth(20000) == 20000"));
+    // the spare segment left by the recursion is released
+    EXPECT_GT(py_gc_trim(), 0);
+
+    // the clone has the same stack size
+    ASSERT_TRUE(clone(kSource + 1, kSource));
+    EXPECT_TRUE(eval_true("depth(20000) == 20000"));
+
+    // and resetting restores the default size
+    py_resetvm();
+    ASSERT_TRUE(py_exec(source, "<reset>", EXEC_MODE, NULL));
+    EXPECT_FALSE(py_eval("depth(20000)", NULL));
+    EXPECT_TRUE(py_matchexc(tp_StackOverflowError));
+    py_clearexc(NULL);
+    EXPECT_TRUE(eval_true("depth(1000) == 1000"));
+    py_switchvm(0);
+}
+
+}  // namespace
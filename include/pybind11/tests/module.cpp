@@ -137,4 +137,22 @@ TEST_F(PYBIND11_TEST, reload_module) {
     }
 }
 
+TEST_F(PYBIND11_TEST, import_binary_with_callback) {
+    py::exec("import os, py_compile\n"
+             "with open('_pkc_callback.py', 'wt') as f:\n"
+             "    f.write('value = 1')\n"
+             "py_compile.compile('_pkc_callback.py')\n"
+             "os.remove('_pkc_callback.py')");
+
+    // a `.pkc` file on the disk is not imported through a custom `importfile`
+    auto importfile = py_callbacks()->importfile;
+    py_callbacks()->importfile = [](const char*) -> char* { return nullptr; };
+    EXPECT_EQ(py_import("_pkc_callback"), 0);
+    py_callbacks()->importfile = importfile;
+
+    EXPECT_EQ(py_import("_pkc_callback"), 1);
+    EXPECT_EVAL_EQ("__import__('_pkc_callback').value", 1);
+    py::exec("os.remove('_pkc_callback.pkc')");
+}
+
 }  // namespace
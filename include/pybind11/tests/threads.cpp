@@ -0,0 +1,56 @@
+#include "test.h"
+
+#include <thread>
+#include <vector>
+
+PYBIND11_EMBEDDED_MODULE(worker, m) {
+    m.def("square", [](int x) {
+        return x * x;
+    });
+}
+
+namespace {
+
+TEST_F(PYBIND11_TEST, threads) {
+    const int N = 8;
+    std::vector<int> totals(N), values(N);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < N; i++) {
+        threads.emplace_back([i, &totals, &values] {
+            // each thread owns a vm, so they run in parallel
+            py_switchvm(i + 1);
+            py::initialize();
+            py::exec("value = " + std::to_string(i));
+            py::exec(R"(
+import worker
+
+class A:
+    def __init__(self, x):
+        self.x = x
+
+total = 0
+for k in range(20000):
+    total += worker.square(A(k % 7).x)
+)");
+            totals[i] = py::eval("total").cast<int>();
+            values[i] = py::eval("value").cast<int>();
+            EXPECT_EQ(py_currentvm(), i + 1);
+            py::finalize(true);
+        });
+    }
+    for(auto& thread: threads) {
+        thread.join();
+    }
+
+    int expected = 0;
+    for(int k = 0; k < 20000; k++) {
+        expected += (k % 7) * (k % 7);
+    }
+    for(int i = 0; i < N; i++) {
+        EXPECT_EQ(totals[i], expected);
+        EXPECT_EQ(values[i], i);
+    }
+    EXPECT_EQ(py_currentvm(), 0);
+}
+
+}  // namespace
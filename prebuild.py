@@ -1,4 +1,7 @@
 import os
+import sys
+import subprocess
+import tempfile
 
 def get_sources():
     sources = {}
@@ -28,6 +31,8 @@ with open("include/pocketpy/common/_generated.h", "wt", encoding='utf-8', newlin
 // generated by prebuild.py
 
 const char* load_kPythonLib(const char* name);
+// precompiled code of a bundled module, see `python prebuild.py --precompile`
+const char* load_kPythonLibCode(const char* name, int* size);
 
 '''
     for key in sorted(sources.keys()):
@@ -55,3 +60,54 @@ with open("src/common/_generated.c", "wt", encoding='utf-8', newline='\n') as f:
     f.write("    return NULL;\n")
     f.write("}\n")
 
+
+def get_codes(exe):
+    # compile with a built pocketpy, the code is ignored at runtime if its source has changed
+    codes = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        script = ['import py_compile']
+        for file in sorted(os.listdir("python")):
+            if not file.endswith(".py"):
+                continue
+            key = file.split(".")[0]
+            # must match the filenames used by `py_exec` at runtime
+            filename = '<builtins>' if key == 'builtins' else file
+            script.append(f'py_compile.compile({"python/" + file!r}, {tmp + "/" + key + ".pkc"!r}, {filename!r})')
+        with open(tmp + "/precompile.py", "wt", encoding='utf-8', newline='\n') as f:
+            f.write('\n'.join(script) + '\n')
+        subprocess.run([exe, tmp + "/precompile.py"], check=True)
+        for key in get_sources().keys():
+            with open(tmp + "/" + key + ".pkc", "rb") as f:
+                codes[key] = f.read()
+    return codes
+
+code_path = "src/common/_generated_code.c"
+if len(sys.argv) == 3 and sys.argv[1] == '--precompile':
+    codes = get_codes(sys.argv[2])
+elif os.path.exists(code_path):
+    exit(0)     # keep the existing code
+else:
+    codes = {}
+
+with open(code_path, "wt", encoding='utf-8', newline='\n') as f:
+    data = '''// generated by prebuild.py --precompile
+#include "pocketpy/common/_generated.h"
+#include <string.h>
+'''
+    for key in sorted(codes.keys()):
+        data += f'static const unsigned char kPythonLibsCode_{key}[] = {{\n'
+        value = codes[key]
+        for i in range(0, len(value), 20):
+            data += '    ' + ' '.join(f'0x{c:02x},' for c in value[i:i+20]) + '\n'
+        data += '};\n'
+    f.write(data)
+
+    f.write("\n")
+    f.write("const char* load_kPythonLibCode(const char* name, int* size) {\n")
+    for key in sorted(codes.keys()):
+        f.write(f'    if (strcmp(name, "{key}") == 0) {{\n')
+        f.write(f'        *size = sizeof(kPythonLibsCode_{key});\n')
+        f.write(f'        return (const char*)kPythonLibsCode_{key};\n')
+        f.write('    }\n')
+    f.write("    return NULL;\n")
+    f.write("}\n")
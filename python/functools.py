@@ -1,13 +1,3 @@
-class cache:
-    def __init__(self, f):
-        self.f = f
-        self.cache = {}
-
-    def __call__(self, *args):
-        if args not in self.cache:
-            self.cache[args] = self.f(*args)
-        return self.cache[args]
-    
 def reduce(function, sequence, initial=...):
     it = iter(sequence)
     if initial is ...:
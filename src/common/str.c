@@ -33,6 +33,7 @@ void c11_string__ctor(c11_string* self, const char* data) {
 
 void c11_string__ctor2(c11_string* self, const char* data, int size) {
     self->size = size;
+    self->hash = 0;
     char* p = (char*)self->data;
     memcpy(p, data, size);
     p[size] = '\0';
@@ -40,6 +41,7 @@ void c11_string__ctor2(c11_string* self, const char* data, int size) {
 
 void c11_string__ctor3(c11_string* self, int size) {
     self->size = size;
+    self->hash = 0;
     char* p = (char*)self->data;
     p[size] = '\0';
 }
@@ -255,6 +257,44 @@ int c11_sv__cmp2(c11_sv self, const char* other) {
     return self.size - size;
 }
 
+uint32_t c11_sv__hash(c11_sv self) {
+    const uint64_t k = 0x9E3779B97F4A7C15ull;
+    uint64_t h = (uint64_t)self.size * k;
+    // 8 bytes per round
+    int i = 0;
+    for(; i + 8 <= self.size; i += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, self.data + i, 8);
+        h = (h ^ chunk) * k;
+        h ^= h >> 32;
+    }
+    uint64_t tail = 0;
+    // `data` may be NULL when the view is empty
+    if(i < self.size) memcpy(&tail, self.data + i, self.size - i);
+    h = (h ^ tail) * k;
+    // finalizer of murmur3
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    uint32_t res = (uint32_t)h;
+    return res != 0 ? res : 1;
+}
+
+uint32_t c11_string__hash(c11_string* self) {
+    if(self->hash == 0) self->hash = c11_sv__hash(c11_string__sv(self));
+    return self->hash;
+}
+
+bool c11_string__eq(c11_string* self, c11_string* other) {
+    if(self == other) return true;
+    if(self->size != other->size) return false;
+    // different cached hashes mean different strings
+    if(self->hash != 0 && other->hash != 0 && self->hash != other->hash) return false;
+    return memcmp(self->data, other->data, self->size) == 0;
+}
+
 bool c11__streq(const char* a, const char* b) { return strcmp(a, b) == 0; }
 
 bool c11__sveq(c11_sv a, c11_sv b) {
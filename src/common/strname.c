@@ -1,21 +1,50 @@
 #include "pocketpy/common/strname.h"
-#include "pocketpy/common/smallmap.h"
 #include "pocketpy/common/utils.h"
-#include "pocketpy/common/vector.h"
+#include "pocketpy/objects/codeobject.h"
 #include "pocketpy/pocketpy.h"
 
+#include "pocketpy/common/lock.h"
 #include <stdio.h>
 
-// TODO: use a more efficient data structure
-static c11_smallmap_s2n _interned;
-static c11_vector /*T=char* */ _r_interned;
+static c11_lock _lock = C11_LOCK_INIT;
 
-void py_Name__initialize() {
-    c11_smallmap_s2n__ctor(&_interned);
-    for(int i = 0; i < _r_interned.length; i++) {
-        PK_FREE(c11__at(char*, &_r_interned, i));
+typedef struct NameEntry {
+    char* data;
+    int size;
+    uint32_t hash;
+} NameEntry;
+
+// names are stored in fixed chunks, so `py_name2str` needs no lock
+#define kNameChunkSize 4096
+#define kMaxNameCount BC_MAX_ARG
+
+static NameEntry* _r_interned[kMaxNameCount / kNameChunkSize + 1];
+static int _length;
+// open addressing hash table of 1-based indices, 0 means empty
+static py_Name* _interned;
+static int _capacity;
+
+static NameEntry* py_Name__entry(py_Name index) {
+    return &_r_interned[index / kNameChunkSize][index % kNameChunkSize];
+}
+
+static void py_Name__rehash(int capacity) {
+    py_Name* table = PK_MALLOC(sizeof(py_Name) * capacity);
+    memset(table, 0, sizeof(py_Name) * capacity);
+    for(py_Name index = 1; index <= (py_Name)_length; index++) {
+        uint32_t i = py_Name__entry(index)->hash & (capacity - 1);
+        while(table[i]) i = (i + 1) & (capacity - 1);
+        table[i] = index;
     }
-    c11_vector__ctor(&_r_interned, sizeof(c11_sv));
+    PK_FREE(_interned);
+    _interned = table;
+    _capacity = capacity;
+}
+
+void py_Name__initialize() {
+    _length = 0;
+    _interned = NULL;
+    py_Name__rehash(1024);
 
 #define MAGIC_METHOD(x)                                                                            \
     if(x != py_name(#x)) abort();
@@ -25,40 +54,57 @@ void py_Name__initialize() {
 
 void py_Name__finalize() {
     // free all char*
-    for(int i = 0; i < _r_interned.length; i++) {
-        PK_FREE(c11__getitem(char*, &_r_interned, i));
+    for(py_Name index = 1; index <= (py_Name)_length; index++) {
+        PK_FREE(py_Name__entry(index)->data);
     }
-    c11_smallmap_s2n__dtor(&_interned);
-    c11_vector__dtor(&_r_interned);
+    for(int i = 0; i < c11__count_array(_r_interned); i++) {
+        PK_FREE(_r_interned[i]);
+        _r_interned[i] = NULL;
+    }
+    PK_FREE(_interned);
+    _interned = NULL;
+    _capacity = 0;
+    _length = 0;
 }
 
 py_Name py_name(const char* name) { return py_namev((c11_sv){name, strlen(name)}); }
 
 py_Name py_namev(c11_sv name) {
-    // TODO: PK_GLOBAL_SCOPE_LOCK()
-    uint16_t index = c11_smallmap_s2n__get(&_interned, name, 0);
-    if(index != 0) return index;
+    uint32_t hash = c11_sv__hash(name);
+    c11_lock__acquire(&_lock);
+    uint32_t i = hash & (_capacity - 1);
+    for(py_Name index; (index = _interned[i]) != 0; i = (i + 1) & (_capacity - 1)) {
+        NameEntry* entry = py_Name__entry(index);
+        if(entry->hash == hash && entry->size == name.size &&
+           memcmp(entry->data, name.data, name.size) == 0) {
+            c11_lock__release(&_lock);
+            return index;
+        }
+    }
     // generate new index
-    if(_interned.length > 65530) c11__abort("py_Name index overflow");
+    if(_length >= kMaxNameCount) c11__abort("py_Name index overflow");
+    py_Name index = ++_length;  // 1-based
+    NameEntry** chunk = &_r_interned[index / kNameChunkSize];
+    if(*chunk == NULL) *chunk = PK_MALLOC(sizeof(NameEntry) * kNameChunkSize);
     // NOTE: we must allocate the string in the heap so iterators are not invalidated
     char* p = PK_MALLOC(name.size + 1);
     memcpy(p, name.data, name.size);
     p[name.size] = '\0';
-    c11_vector__push(char*, &_r_interned, p);
-    index = _r_interned.length;  // 1-based
-    // save to _interned
-    c11_smallmap_s2n__set(&_interned, (c11_sv){p, name.size}, index);
-    assert(_interned.length == _r_interned.length);
+    *py_Name__entry(index) = (NameEntry){p, name.size, hash};
+    _interned[i] = index;
+    // keep the load factor below 1/2
+    if(_length * 2 > _capacity) py_Name__rehash(_capacity * 2);
+    c11_lock__release(&_lock);
     return index;
 }
 
 const char* py_name2str(py_Name index) {
-    assert(index > 0 && index <= _interned.length);
-    return c11__getitem(char*, &_r_interned, index - 1);
+    assert(index > 0 && index <= (py_Name)_length);
+    return py_Name__entry(index)->data;
 }
 
 c11_sv py_name2sv(py_Name index) {
-    assert(index > 0 && index <= _interned.length);
-    const char* p = py_name2str(index);
-    return (c11_sv){p, strlen(p)};
+    assert(index > 0 && index <= (py_Name)_length);
+    NameEntry* entry = py_Name__entry(index);
+    return (c11_sv){entry->data, entry->size};
 }
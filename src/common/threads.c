@@ -0,0 +1,101 @@
+#include "pocketpy/common/threads.h"
+#include "pocketpy/common/utils.h"
+
+#if PK_ENABLE_THREADS
+
+#include <stdlib.h>
+
+typedef struct {
+    c11_thrd_func func;
+    void* arg;
+} c11_thrd_start;
+
+#ifdef _WIN32
+
+static DWORD WINAPI c11_thrd__entry(LPVOID param) {
+    c11_thrd_start start = *(c11_thrd_start*)param;
+    PK_FREE(param);
+    start.func(start.arg);
+    return 0;
+}
+
+bool c11_thrd__create(c11_thrd* self, c11_thrd_func func, void* arg) {
+    c11_thrd_start* start = PK_MALLOC(sizeof(c11_thrd_start));
+    start->func = func;
+    start->arg = arg;
+    *self = CreateThread(NULL, 0, c11_thrd__entry, start, 0, NULL);
+    if(*self == NULL) {
+        PK_FREE(start);
+        return false;
+    }
+    return true;
+}
+
+void c11_thrd__join(c11_thrd* self) {
+    WaitForSingleObject(*self, INFINITE);
+    CloseHandle(*self);
+}
+
+void c11_mutex__ctor(c11_mutex* self) { InitializeSRWLock(self); }
+
+void c11_mutex__dtor(c11_mutex* self) {}
+
+void c11_mutex__lock(c11_mutex* self) { AcquireSRWLockExclusive(self); }
+
+void c11_mutex__unlock(c11_mutex* self) { ReleaseSRWLockExclusive(self); }
+
+void c11_cond__ctor(c11_cond* self) { InitializeConditionVariable(self); }
+
+void c11_cond__dtor(c11_cond* self) {}
+
+void c11_cond__wait(c11_cond* self, c11_mutex* mutex) {
+    SleepConditionVariableSRW(self, mutex, INFINITE, 0);
+}
+
+void c11_cond__signal(c11_cond* self) { WakeConditionVariable(self); }
+
+void c11_cond__broadcast(c11_cond* self) { WakeAllConditionVariable(self); }
+
+#else
+
+static void* c11_thrd__entry(void* param) {
+    c11_thrd_start start = *(c11_thrd_start*)param;
+    PK_FREE(param);
+    start.func(start.arg);
+    return NULL;
+}
+
+bool c11_thrd__create(c11_thrd* self, c11_thrd_func func, void* arg) {
+    c11_thrd_start* start = PK_MALLOC(sizeof(c11_thrd_start));
+    start->func = func;
+    start->arg = arg;
+    if(pthread_create(self, NULL, c11_thrd__entry, start) != 0) {
+        PK_FREE(start);
+        return false;
+    }
+    return true;
+}
+
+void c11_thrd__join(c11_thrd* self) { pthread_join(*self, NULL); }
+
+void c11_mutex__ctor(c11_mutex* self) { pthread_mutex_init(self, NULL); }
+
+void c11_mutex__dtor(c11_mutex* self) { pthread_mutex_destroy(self); }
+
+void c11_mutex__lock(c11_mutex* self) { pthread_mutex_lock(self); }
+
+void c11_mutex__unlock(c11_mutex* self) { pthread_mutex_unlock(self); }
+
+void c11_cond__ctor(c11_cond* self) { pthread_cond_init(self, NULL); }
+
+void c11_cond__dtor(c11_cond* self) { pthread_cond_destroy(self); }
+
+void c11_cond__wait(c11_cond* self, c11_mutex* mutex) { pthread_cond_wait(self, mutex); }
+
+void c11_cond__signal(c11_cond* self) { pthread_cond_signal(self); }
+
+void c11_cond__broadcast(c11_cond* self) { pthread_cond_broadcast(self); }
+
+#endif
+
+#endif
@@ -23,7 +23,9 @@ c11_vector c11_vector__copy(const c11_vector* self) {
     c11_vector retval;
     c11_vector__ctor(&retval, self->elem_size);
     c11_vector__reserve(&retval, self->capacity);
-    memcpy(retval.data, self->data, (size_t)self->elem_size * (size_t)self->length);
+    if(self->length > 0) {
+        memcpy(retval.data, self->data, (size_t)self->elem_size * (size_t)self->length);
+    }
     retval.length = self->length;
     return retval;
 }
@@ -61,6 +61,7 @@ typedef struct Ctx {
     int level;
     int curr_iblock;
     bool is_compiling_class;
+    bool is_arg_overflow;  // an arg did not fit in `Bytecode`, reported by `pop_context()`
     c11_vector /*T=Expr* */ s_expr;
     c11_smallmap_n2i global_names;
     c11_smallmap_s2n co_consts_string_dedup_map;
@@ -73,8 +74,8 @@ static void Ctx__dtor(Ctx* self);
 static int Ctx__prepare_loop_divert(Ctx* self, int line, bool is_break);
 static int Ctx__enter_block(Ctx* self, CodeBlockType type);
 static void Ctx__exit_block(Ctx* self);
-static int Ctx__emit_(Ctx* self, Opcode opcode, uint16_t arg, int line);
-static int Ctx__emit_virtual(Ctx* self, Opcode opcode, uint16_t arg, int line, bool virtual);
+static int Ctx__emit_(Ctx* self, Opcode opcode, uint32_t arg, int line);
+static int Ctx__emit_virtual(Ctx* self, Opcode opcode, uint32_t arg, int line, bool virtual);
 static void Ctx__revert_last_emit_(Ctx* self);
 static int Ctx__emit_int(Ctx* self, int64_t value, int line);
 static void Ctx__patch_jump(Ctx* self, int index);
@@ -1046,7 +1047,7 @@ void CallExpr__emit_(Expr* self_, Ctx* ctx) {
 
     c11__foreach(Expr*, &self->args, e) { vtemit_(*e, ctx); }
     c11__foreach(CallExprKwArg, &self->kwargs, e) {
-        Ctx__emit_int(ctx, e->key, self->line);
+        Ctx__emit_(ctx, OP_LOAD_KEYWORD, e->key, self->line);
         vtemit_(e->val, ctx);
     }
     int KWARGC = self->kwargs.length;
@@ -1073,6 +1074,7 @@ static void Ctx__ctor(Ctx* self, CodeObject* co, FuncDecl* func, int level) {
     self->level = level;
     self->curr_iblock = 0;
     self->is_compiling_class = false;
+    self->is_arg_overflow = false;
     c11_vector__ctor(&self->s_expr, sizeof(Expr*));
     c11_smallmap_n2i__ctor(&self->global_names);
     c11_smallmap_s2n__ctor(&self->co_consts_string_dedup_map);
@@ -1146,7 +1148,11 @@ static void Ctx__s_emit_decorators(Ctx* self, int count) {
     }
 }
 
-static int Ctx__emit_virtual(Ctx* self, Opcode opcode, uint16_t arg, int line, bool is_virtual) {
+static int Ctx__emit_virtual(Ctx* self, Opcode opcode, uint32_t arg, int line, bool is_virtual) {
+    if(arg > BC_MAX_ARG) {
+        self->is_arg_overflow = true;
+        arg = BC_NOARG;
+    }
     Bytecode bc = {(uint8_t)opcode, arg};
     BytecodeEx bcx = {line, is_virtual, self->curr_iblock};
     c11_vector__push(Bytecode, &self->co->codes, bc);
@@ -1157,7 +1163,7 @@ static int Ctx__emit_virtual(Ctx* self, Opcode opcode, uint16_t arg, int line, b
     return i;
 }
 
-static int Ctx__emit_(Ctx* self, Opcode opcode, uint16_t arg, int line) {
+static int Ctx__emit_(Ctx* self, Opcode opcode, uint32_t arg, int line) {
     return Ctx__emit_virtual(self, opcode, arg, line, false);
 }
 
@@ -1201,6 +1207,8 @@ static int Ctx__add_const_string(Ctx* self, c11_sv key) {
     } else {
         py_TValue tmp;
         py_newstrv(&tmp, key);
+        // constants are likely dict keys, their hashes are computed once here
+        c11_string__hash(PyObject__userdata(tmp._obj));
         c11_vector__push(py_TValue, &self->co->consts, tmp);
         int index = self->co->consts.length - 1;
         c11_smallmap_s2n__set(&self->co_consts_string_dedup_map,
@@ -1478,6 +1486,9 @@ static Error* pop_context(Compiler* self) {
     if(co->consts.length > 65530) {
         return SyntaxError(self, "maximum number of constants exceeded");
     }
+    if(ctx()->is_arg_overflow) {
+        return SyntaxError(self, "too many constants or names in one code object");
+    }
     // pre-compute block.end or block.end2
     for(int i = 0; i < codes->length; i++) {
         Bytecode* bc = c11__at(Bytecode, codes, i);
@@ -1521,6 +1532,7 @@ static Error* pop_context(Compiler* self) {
 
         assert(func->type != FuncType_UNSET);
     }
+    CodeObject__init_caches(co);
     Ctx__dtor(ctx());
     c11_vector__pop(&self->contexts);
     return NULL;
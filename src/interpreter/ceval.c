@@ -4,32 +4,63 @@
 #include "pocketpy/interpreter/vm.h"
 #include "pocketpy/common/sstream.h"
 #include "pocketpy/objects/codeobject.h"
+#include "pocketpy/objects/dict.h"
 #include "pocketpy/pocketpy.h"
 #include "pocketpy/objects/error.h"
 #include <stdbool.h>
 
 static bool stack_format_object(VM* self, c11_sv spec);
 
+/// Move the values of `frame` to a new segment of the stack when the current one is full.
+static bool stack_grow_frame(VM* self, Frame* frame) {
+    py_StackRef p0 = frame->p0;
+    py_StackRef sp = self->stack.sp;
+    py_StackRef new_p0 = ValueStack__split(&self->stack, p0, PK_MAX_CO_VARNAMES);
+    if(new_p0 == NULL) return false;
+    frame->p0 = new_p0;
+    frame->locals = new_p0 + (frame->locals - p0);
+    // the class being built lives on the stack of the frame
+    if(self->__curr_class >= p0 && self->__curr_class < sp) {
+        self->__curr_class = new_p0 + (self->__curr_class - p0);
+    }
+    return true;
+}
+
 #define CHECK_RETURN_FROM_EXCEPT_OR_FINALLY()                                                      \
     if(self->is_curr_exc_handled) py_clearexc(NULL)
 
 #define CHECK_STACK_OVERFLOW()                                                                     \
     do {                                                                                           \
         if(self->stack.sp > self->stack.end) {                                                     \
-            py_exception(tp_StackOverflowError, "");                                               \
-            goto __ERROR;                                                                          \
+            if(!stack_grow_frame(self, frame)) goto __ERROR;                                       \
         }                                                                                          \
     } while(0)
 
+#if PK_ENABLE_COMPUTED_GOTO
+// threaded dispatch: each handler jumps directly to the next one via `OP_LABELS`
+#define TARGET(op)                                                                                 \
+    case OP_##op:                                                                                  \
+    __TARGET_##op
+#define GOTO_NEXT_STEP()                                                                           \
+    do {                                                                                           \
+        byte = *frame->ip;                                                                         \
+        if(self->is_signal_interrupted) goto __NEXT_STEP;                                          \
+        goto* OP_LABELS[byte.op];                                                                  \
+    } while(0)
+#else
+#define TARGET(op) case OP_##op
+#define GOTO_NEXT_STEP() goto __NEXT_STEP
+#endif
+
 #define DISPATCH()                                                                                 \
     do {                                                                                           \
         frame->ip++;                                                                               \
-        goto __NEXT_STEP;                                                                          \
+        GOTO_NEXT_STEP();                                                                          \
     } while(0)
 #define DISPATCH_JUMP(__offset)                                                                    \
     do {                                                                                           \
         frame->ip += __offset;                                                                     \
-        goto __NEXT_STEP;                                                                          \
+        GOTO_NEXT_STEP();                                                                          \
     } while(0)
 #define DISPATCH_JUMP_ABSOLUTE(__target)                                                           \
     do {                                                                                           \
@@ -72,6 +103,183 @@ static bool stack_format_object(VM* self, c11_sv spec);
         }                                                                                          \
     } while(0)
 
+#if defined(__GNUC__) || defined(__clang__)
+#define i64_add_overflow(a, b, out) __builtin_add_overflow(a, b, out)
+#define i64_sub_overflow(a, b, out) __builtin_sub_overflow(a, b, out)
+#define i64_mul_overflow(a, b, out) __builtin_mul_overflow(a, b, out)
+#else
+static bool i64_add_overflow(py_i64 a, py_i64 b, py_i64* out) {
+    if((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) return true;
+    *out = a + b;
+    return false;
+}
+
+static bool i64_sub_overflow(py_i64 a, py_i64 b, py_i64* out) {
+    if((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b)) return true;
+    *out = a - b;
+    return false;
+}
+
+static bool i64_mul_overflow(py_i64 a, py_i64 b, py_i64* out) {
+    // conservative: only multiply operands that fit in 32 bits
+    if(a < INT32_MIN || a > INT32_MAX || b < INT32_MIN || b > INT32_MAX) return true;
+    *out = a * b;
+    return false;
+}
+#endif
+
+/// Fast path of `BINARY_OP` for `int` and `float` operands.
+/// The result is written to `lhs`. Return `false` to fallback to `pk_stack_binaryop`.
+static bool stack_binaryop_number(py_TValue* lhs, const py_TValue* rhs, py_Name op) {
+    if(lhs->type == tp_int && rhs->type == tp_int) {
+        py_i64 a = lhs->_i64;
+        py_i64 b = rhs->_i64;
+        py_i64 c;
+        switch(op) {
+            case __add__:
+                if(i64_add_overflow(a, b, &c)) return false;
+                py_newint(lhs, c);
+                return true;
+            case __sub__:
+                if(i64_sub_overflow(a, b, &c)) return false;
+                py_newint(lhs, c);
+                return true;
+            case __mul__:
+                if(i64_mul_overflow(a, b, &c)) return false;
+                py_newint(lhs, c);
+                return true;
+            case __truediv__:
+                if(b == 0) return false;
+                py_newfloat(lhs, (py_f64)a / (py_f64)b);
+                return true;
+            case __floordiv__:
+                if(b == 0 || (a == INT64_MIN && b == -1)) return false;
+                c = a / b;
+                if((a % b != 0) && ((a < 0) != (b < 0))) c--;
+                py_newint(lhs, c);
+                return true;
+            case __mod__:
+                if(b == 0 || (a == INT64_MIN && b == -1)) return false;
+                c = a % b;
+                if(c != 0 && ((c < 0) != (b < 0))) c += b;
+                py_newint(lhs, c);
+                return true;
+            case __and__: py_newint(lhs, a & b); return true;
+            case __or__: py_newint(lhs, a | b); return true;
+            case __xor__: py_newint(lhs, a ^ b); return true;
+            case __lshift__:
+                if(b < 0 || b >= 64) return false;
+                py_newint(lhs, (py_i64)((uint64_t)a << b));
+                return true;
+            case __rshift__:
+                if(b < 0 || b >= 64) return false;
+                py_newint(lhs, a >> b);
+                return true;
+            case __eq__: py_newbool(lhs, a == b); return true;
+            case __ne__: py_newbool(lhs, a != b); return true;
+            case __lt__: py_newbool(lhs, a < b); return true;
+            case __le__: py_newbool(lhs, a <= b); return true;
+            case __gt__: py_newbool(lhs, a > b); return true;
+            case __ge__: py_newbool(lhs, a >= b); return true;
+            default: return false;
+        }
+    }
+
+    py_f64 a, b;
+    switch(lhs->type) {
+        case tp_int: a = (py_f64)lhs->_i64; break;
+        case tp_float: a = lhs->_f64; break;
+        default: return false;
+    }
+    switch(rhs->type) {
+        case tp_int: b = (py_f64)rhs->_i64; break;
+        case tp_float: b = rhs->_f64; break;
+        default: return false;
+    }
+    switch(op) {
+        case __add__: py_newfloat(lhs, a + b); return true;
+        case __sub__: py_newfloat(lhs, a - b); return true;
+        case __mul__: py_newfloat(lhs, a * b); return true;
+        case __truediv__:
+            if(b == 0) return false;
+            py_newfloat(lhs, a / b);
+            return true;
+        case __eq__: py_newbool(lhs, a == b); return true;
+        case __ne__: py_newbool(lhs, a != b); return true;
+        case __lt__: py_newbool(lhs, a < b); return true;
+        case __le__: py_newbool(lhs, a <= b); return true;
+        case __gt__: py_newbool(lhs, a > b); return true;
+        case __ge__: py_newbool(lhs, a >= b); return true;
+        default: return false;
+    }
+}
+
+/// Resolve `py_tpfindname(type, name)` via the inline cache of the current bytecode.
+static py_Ref Frame__tpfindname_cached(VM* self, Frame* frame, py_Type type, py_Name name) {
+    const CodeObject* co = frame->co;
+    int icache = c11__getitem(BytecodeEx, &co->codes_ex, Frame__ip(frame)).icache;
+    if(icache < 0) return py_tpfindname(type, name);
+    AttrCache* ic = c11__at(AttrCache, &co->attr_caches, icache);
+    if(ic->type != type || ic->version != self->type_version) {
+        ic->type = type;
+        ic->version = self->type_version;
+        ic->cls_var = py_tpfindname(type, name);
+    }
+    return ic->cls_var;
+}
+
+/// Find `name` in the `__dict__` of an instance with `slots <= -2` via the inline cache of the
+/// current bytecode. Return `NULL` if not found.
+static py_Ref Frame__getinstdict_cached(Frame* frame, PyObject* obj, py_Name name) {
+    InstanceDict* dict = PyObject__instancedict(obj);
+    const CodeObject* co = frame->co;
+    int icache = c11__getitem(BytecodeEx, &co->codes_ex, Frame__ip(frame)).icache;
+    if(dict->shape == NULL || icache < 0) return InstanceDict__try_get(dict, name);
+    AttrCache* ic = c11__at(AttrCache, &co->attr_caches, icache);
+    if(ic->shape != dict->shape) {
+        int offset = InstanceShape__find(dict->shape, name);
+        if(offset < 0) return NULL;
+        ic->shape = dict->shape;
+        ic->offset = offset;
+    }
+    return InstanceDict__at(dict, ic->offset);
+}
+
+/// Whether an attribute of `self` may be found in its `__dict__` by shape, i.e. it is an instance
+/// with `slots <= -2` and the attribute is not a property of its class.
+#define pk__is_shaped_attr(self, cls_var)                                                          \
+    ((self)->is_ptr && (self)->_obj->slots <= -2 && !((cls_var) && py_istype(cls_var, tp_property)))
+
+/// The slot of `self` if `cls_var` is a member descriptor of `__slots__` which applies to it.
+/// Return `NULL` otherwise.
+static py_Ref Frame__member_slot(py_Ref self, py_Ref cls_var) {
+    if(cls_var == NULL || cls_var->type != tp_member_descriptor || !self->is_ptr) return NULL;
+    int index = *(int*)PyObject__userdata(cls_var->_obj);
+    if(index >= self->_obj->slots) return NULL;
+    return PyObject__slots(self->_obj) + index;
+}
+
+/// Resolve a global name from the frame's module or builtins via the inline cache.
+/// Return `NULL` if not found.
+static py_Ref Frame__getglobal_cached(VM* self, Frame* frame, py_Name name) {
+    const CodeObject* co = frame->co;
+    int icache = c11__getitem(BytecodeEx, &co->codes_ex, Frame__ip(frame)).icache;
+    GlobalCache* ic = c11__at(GlobalCache, &co->global_caches, icache);
+    uint32_t module_version = pk__module_version(frame->module);
+    uint32_t builtins_version = pk__module_version(&self->builtins);
+    if(ic->module_version == module_version && ic->builtins_version == builtins_version) {
+        return ic->slot;
+    }
+    py_Ref slot = py_getdict(frame->module, name);
+    if(slot == NULL) slot = py_getdict(&self->builtins, name);
+    if(slot != NULL) {
+        ic->module_version = module_version;
+        ic->builtins_version = builtins_version;
+        ic->slot = slot;
+    }
+    return slot;
+}
+
 static bool unpack_dict_to_buffer(py_Ref key, py_Ref val, void* ctx) {
     py_TValue** p = ctx;
     if(py_isstr(key)) {
@@ -85,6 +293,14 @@ static bool unpack_dict_to_buffer(py_Ref key, py_Ref val, void* ctx) {
 }
 
 FrameResult VM__run_top_frame(VM* self) {
+#if PK_ENABLE_COMPUTED_GOTO
+    static const void* const OP_LABELS[] = {
+#define OPCODE(name) &&__TARGET_##name,
+#include "pocketpy/xmacros/opcodes.h"
+#undef OPCODE
+    };
+#endif
+
     Frame* frame = self->top_frame;
     const Frame* base_frame = frame;
 
@@ -107,22 +323,22 @@ FrameResult VM__run_top_frame(VM* self) {
         }
 
         switch((Opcode)byte.op) {
-            case OP_NO_OP: DISPATCH();
+            TARGET(NO_OP): DISPATCH();
             /*****************************************/
-            case OP_POP_TOP: POP(); DISPATCH();
-            case OP_DUP_TOP: PUSH(TOP()); DISPATCH();
-            case OP_DUP_TOP_TWO:
+            TARGET(POP_TOP): POP(); DISPATCH();
+            TARGET(DUP_TOP): PUSH(TOP()); DISPATCH();
+            TARGET(DUP_TOP_TWO):
                 // [a, b]
                 PUSH(SECOND());  // [a, b, a]
                 PUSH(SECOND());  // [a, b, a, b]
                 DISPATCH();
-            case OP_ROT_TWO: {
+            TARGET(ROT_TWO): {
                 py_TValue tmp = *TOP();
                 *TOP() = *SECOND();
                 *SECOND() = tmp;
                 DISPATCH();
             }
-            case OP_ROT_THREE: {
+            TARGET(ROT_THREE): {
                 // [a, b, c] -> [c, a, b]
                 py_TValue tmp = *TOP();
                 *TOP() = *SECOND();
@@ -130,7 +346,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 *THIRD() = tmp;
                 DISPATCH();
             }
-            case OP_PRINT_EXPR:
+            TARGET(PRINT_EXPR):
                 if(TOP()->type != tp_NoneType) {
                     bool ok = py_repr(TOP());
                     if(!ok) goto __ERROR;
@@ -140,39 +356,44 @@ FrameResult VM__run_top_frame(VM* self) {
                 POP();
                 DISPATCH();
             /*****************************************/
-            case OP_LOAD_CONST: {
+            TARGET(LOAD_CONST): {
                 CHECK_STACK_OVERFLOW();
                 PUSH(c11__at(py_TValue, &frame->co->consts, byte.arg));
                 DISPATCH();
             }
-            case OP_LOAD_NONE: {
+            TARGET(LOAD_NONE): {
                 CHECK_STACK_OVERFLOW();
                 py_newnone(SP()++);
                 DISPATCH();
             }
-            case OP_LOAD_TRUE: {
+            TARGET(LOAD_TRUE): {
                 CHECK_STACK_OVERFLOW();
                 py_newbool(SP()++, true);
                 DISPATCH();
             }
-            case OP_LOAD_FALSE: {
+            TARGET(LOAD_FALSE): {
                 CHECK_STACK_OVERFLOW();
                 py_newbool(SP()++, false);
                 DISPATCH();
             }
             /*****************************************/
-            case OP_LOAD_SMALL_INT: {
+            TARGET(LOAD_SMALL_INT): {
                 CHECK_STACK_OVERFLOW();
                 py_newint(SP()++, (int16_t)byte.arg);
                 DISPATCH();
             }
+            TARGET(LOAD_KEYWORD): {
+                CHECK_STACK_OVERFLOW();
+                py_newint(SP()++, byte.arg);
+                DISPATCH();
+            }
             /*****************************************/
-            case OP_LOAD_ELLIPSIS: {
+            TARGET(LOAD_ELLIPSIS): {
                 CHECK_STACK_OVERFLOW();
                 py_newellipsis(SP()++);
                 DISPATCH();
             }
-            case OP_LOAD_FUNCTION: {
+            TARGET(LOAD_FUNCTION): {
                 CHECK_STACK_OVERFLOW();
                 FuncDecl_ decl = c11__getitem(FuncDecl_, &frame->co->func_decls, byte.arg);
                 Function* ud = py_newobject(SP(), tp_function, 0, sizeof(Function));
@@ -186,20 +407,20 @@ FrameResult VM__run_top_frame(VM* self) {
                 SP()++;
                 DISPATCH();
             }
-            case OP_LOAD_NULL:
+            TARGET(LOAD_NULL):
                 py_newnil(SP()++);
                 DISPATCH();
                 /*****************************************/
-            case OP_LOAD_FAST: {
+            TARGET(LOAD_FAST): {
                 PUSH(&frame->locals[byte.arg]);
                 if(py_isnil(TOP())) {
-                    py_Name name = c11__getitem(uint16_t, &frame->co->varnames, byte.arg);
+                    py_Name name = c11__getitem(py_Name, &frame->co->varnames, byte.arg);
                     UnboundLocalError(name);
                     goto __ERROR;
                 }
                 DISPATCH();
             }
-            case OP_LOAD_NAME: {
+            TARGET(LOAD_NAME): {
                 assert(frame->is_dynamic);
                 py_Name name = byte.arg;
                 py_TValue* tmp;
@@ -237,19 +458,14 @@ FrameResult VM__run_top_frame(VM* self) {
                 NameError(name);
                 goto __ERROR;
             }
-            case OP_LOAD_NONLOCAL: {
+            TARGET(LOAD_NONLOCAL): {
                 py_Name name = byte.arg;
                 py_Ref tmp = Frame__f_closure_try_get(frame, name);
                 if(tmp != NULL) {
                     PUSH(tmp);
                     DISPATCH();
                 }
-                tmp = py_getdict(frame->module, name);
-                if(tmp != NULL) {
-                    PUSH(tmp);
-                    DISPATCH();
-                }
-                tmp = py_getdict(&self->builtins, name);
+                tmp = Frame__getglobal_cached(self, frame, name);
                 if(tmp != NULL) {
                     PUSH(tmp);
                     DISPATCH();
@@ -257,14 +473,9 @@ FrameResult VM__run_top_frame(VM* self) {
                 NameError(name);
                 goto __ERROR;
             }
-            case OP_LOAD_GLOBAL: {
+            TARGET(LOAD_GLOBAL): {
                 py_Name name = byte.arg;
-                py_Ref tmp = py_getdict(frame->module, name);
-                if(tmp != NULL) {
-                    PUSH(tmp);
-                    DISPATCH();
-                }
-                tmp = py_getdict(&self->builtins, name);
+                py_Ref tmp = Frame__getglobal_cached(self, frame, name);
                 if(tmp != NULL) {
                     PUSH(tmp);
                     DISPATCH();
@@ -272,15 +483,29 @@ FrameResult VM__run_top_frame(VM* self) {
                 NameError(name);
                 goto __ERROR;
             }
-            case OP_LOAD_ATTR: {
-                if(py_getattr(TOP(), byte.arg)) {
+            TARGET(LOAD_ATTR): {
+                py_Ref cls_var = Frame__tpfindname_cached(self, frame, TOP()->type, byte.arg);
+                if(pk__is_shaped_attr(TOP(), cls_var)) {
+                    py_Ref res = Frame__getinstdict_cached(frame, TOP()->_obj, byte.arg);
+                    if(res) {
+                        py_assign(TOP(), res);
+                        DISPATCH();
+                    }
+                } else {
+                    py_Ref slot = Frame__member_slot(TOP(), cls_var);
+                    if(slot && !py_isnil(slot)) {
+                        py_assign(TOP(), slot);
+                        DISPATCH();
+                    }
+                }
+                if(pk_getattr_clsvar(TOP(), byte.arg, cls_var)) {
                     py_assign(TOP(), py_retval());
                 } else {
                     goto __ERROR;
                 }
                 DISPATCH();
             }
-            case OP_LOAD_CLASS_GLOBAL: {
+            TARGET(LOAD_CLASS_GLOBAL): {
                 assert(self->__curr_class);
                 py_Name name = byte.arg;
                 py_Ref tmp = py_getdict(self->__curr_class, name);
@@ -302,12 +527,23 @@ FrameResult VM__run_top_frame(VM* self) {
                 NameError(name);
                 goto __ERROR;
             }
-            case OP_LOAD_METHOD: {
+            TARGET(LOAD_METHOD): {
                 // [self] -> [unbound, self]
-                bool ok = py_pushmethod(byte.arg);
-                if(!ok) {
+                py_Name name = byte.arg;
+                bool ok;
+                if(TOP()->type == tp_super || py_ismagicname(name)) {
+                    ok = pk_loadmethod(TOP(), name);
+                } else {
+                    py_Type type = TOP()->type;
+                    py_Ref cls_var = Frame__tpfindname_cached(self, frame, type, name);
+                    ok = pk_loadmethod_clsvar(TOP(), type, cls_var);
+                }
+                if(ok) {
+                    SP()++;
+                } else {
                     // fallback to getattr
-                    if(py_getattr(TOP(), byte.arg)) {
+                    py_Ref cls_var = Frame__tpfindname_cached(self, frame, TOP()->type, name);
+                    if(pk_getattr_clsvar(TOP(), name, cls_var)) {
                         py_assign(TOP(), py_retval());
                         py_newnil(SP()++);
                     } else {
@@ -316,7 +552,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
                 DISPATCH();
             }
-            case OP_LOAD_SUBSCR: {
+            TARGET(LOAD_SUBSCR): {
                 // [a, b] -> a[b]
                 py_Ref magic = py_tpfindmagic(SECOND()->type, __getitem__);
                 if(magic) {
@@ -335,8 +571,8 @@ FrameResult VM__run_top_frame(VM* self) {
                 TypeError("'%t' object is not subscriptable", SECOND()->type);
                 goto __ERROR;
             }
-            case OP_STORE_FAST: frame->locals[byte.arg] = POPX(); DISPATCH();
-            case OP_STORE_NAME: {
+            TARGET(STORE_FAST): frame->locals[byte.arg] = POPX(); DISPATCH();
+            TARGET(STORE_NAME): {
                 assert(frame->is_dynamic);
                 py_Name name = byte.arg;
                 py_newstr(SP()++, py_name2str(name));
@@ -368,18 +604,31 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
                 DISPATCH();
             }
-            case OP_STORE_GLOBAL: {
+            TARGET(STORE_GLOBAL): {
                 py_setdict(frame->module, byte.arg, TOP());
                 POP();
                 DISPATCH();
             }
-            case OP_STORE_ATTR: {
+            TARGET(STORE_ATTR): {
                 // [val, a] -> a.b = val
-                if(!py_setattr(TOP(), byte.arg, SECOND())) goto __ERROR;
+                py_Ref cls_var = Frame__tpfindname_cached(self, frame, TOP()->type, byte.arg);
+                py_Ref slot;
+                if(pk__is_shaped_attr(TOP(), cls_var)) {
+                    slot = Frame__getinstdict_cached(frame, TOP()->_obj, byte.arg);
+                } else {
+                    slot = Frame__member_slot(TOP(), cls_var);
+                }
+                if(slot) {
+                    *slot = *SECOND();
+                    pk__gc_barrier(TOP()->_obj);
+                    STACK_SHRINK(2);
+                    DISPATCH();
+                }
+                if(!pk_setattr_clsvar(TOP(), byte.arg, SECOND(), cls_var)) goto __ERROR;
                 STACK_SHRINK(2);
                 DISPATCH();
             }
-            case OP_STORE_SUBSCR: {
+            TARGET(STORE_SUBSCR): {
                 // [val, a, b] -> a[b] = val
                 py_Ref magic = py_tpfindmagic(SECOND()->type, __setitem__);
                 if(magic) {
@@ -396,7 +645,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 TypeError("'%t' object does not support item assignment", SECOND()->type);
                 goto __ERROR;
             }
-            case OP_DELETE_FAST: {
+            TARGET(DELETE_FAST): {
                 py_Ref tmp = &frame->locals[byte.arg];
                 if(py_isnil(tmp)) {
                     py_Name name = c11__getitem(py_Name, &frame->co->varnames, byte.arg);
@@ -406,7 +655,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 py_newnil(tmp);
                 DISPATCH();
             }
-            case OP_DELETE_NAME: {
+            TARGET(DELETE_NAME): {
                 assert(frame->is_dynamic);
                 py_Name name = byte.arg;
                 py_newstr(SP()++, py_name2str(name));
@@ -437,7 +686,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
                 DISPATCH();
             }
-            case OP_DELETE_GLOBAL: {
+            TARGET(DELETE_GLOBAL): {
                 py_Name name = byte.arg;
                 bool ok = py_deldict(frame->module, name);
                 if(!ok) {
@@ -447,12 +696,12 @@ FrameResult VM__run_top_frame(VM* self) {
                 DISPATCH();
             }
 
-            case OP_DELETE_ATTR: {
+            TARGET(DELETE_ATTR): {
                 if(!py_delattr(TOP(), byte.arg)) goto __ERROR;
                 DISPATCH();
             }
 
-            case OP_DELETE_SUBSCR: {
+            TARGET(DELETE_SUBSCR): {
                 // [a, b] -> del a[b]
                 py_Ref magic = py_tpfindmagic(SECOND()->type, __delitem__);
                 if(magic) {
@@ -470,7 +719,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 goto __ERROR;
             }
             /*****************************************/
-            case OP_BUILD_IMAG: {
+            TARGET(BUILD_IMAG): {
                 // [x]
                 py_Ref f = py_getdict(&self->builtins, py_name("complex"));
                 assert(f != NULL);
@@ -483,7 +732,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 PUSH(py_retval());
                 DISPATCH();
             }
-            case OP_BUILD_BYTES: {
+            TARGET(BUILD_BYTES): {
                 int size;
                 py_Ref string = c11__at(py_TValue, &frame->co->consts, byte.arg);
                 const char* data = py_tostrn(string, &size);
@@ -491,7 +740,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 memcpy(p, data, size);
                 DISPATCH();
             }
-            case OP_BUILD_TUPLE: {
+            TARGET(BUILD_TUPLE): {
                 py_TValue tmp;
                 py_newtuple(&tmp, byte.arg);
                 py_TValue* begin = SP() - byte.arg;
@@ -502,7 +751,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 PUSH(&tmp);
                 DISPATCH();
             }
-            case OP_BUILD_LIST: {
+            TARGET(BUILD_LIST): {
                 py_TValue tmp;
                 py_newlistn(&tmp, byte.arg);
                 py_TValue* begin = SP() - byte.arg;
@@ -513,7 +762,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 PUSH(&tmp);
                 DISPATCH();
             }
-            case OP_BUILD_DICT: {
+            TARGET(BUILD_DICT): {
                 py_TValue* begin = SP() - byte.arg * 2;
                 py_Ref tmp = py_pushtmp();
                 py_newdict(tmp);
@@ -525,29 +774,18 @@ FrameResult VM__run_top_frame(VM* self) {
                 PUSH(tmp);
                 DISPATCH();
             }
-            case OP_BUILD_SET: {
+            TARGET(BUILD_SET): {
                 py_TValue* begin = SP() - byte.arg;
-                py_Ref typeobject_set = py_getdict(&self->builtins, py_name("set"));
-                assert(typeobject_set != NULL);
-                py_push(typeobject_set);
-                py_pushnil();
-                if(!py_vectorcall(0, 0)) goto __ERROR;
-                py_push(py_retval());  // empty set
-                py_Name id_add = py_name("add");
+                py_newset(SP()++);  // empty set
                 for(int i = 0; i < byte.arg; i++) {
-                    py_push(TOP());
-                    if(!py_pushmethod(id_add)) {
-                        c11__abort("OP_BUILD_SET: failed to load method 'add'");
-                    }
-                    py_push(begin + i);
-                    if(!py_vectorcall(1, 0)) goto __ERROR;
+                    if(!py_set_add(TOP(), begin + i)) goto __ERROR;
                 }
                 py_TValue tmp = *TOP();
                 SP() = begin;
                 PUSH(&tmp);
                 DISPATCH();
             }
-            case OP_BUILD_SLICE: {
+            TARGET(BUILD_SLICE): {
                 // [start, stop, step]
                 py_TValue tmp;
                 py_newslice(&tmp);
@@ -558,7 +796,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 PUSH(&tmp);
                 DISPATCH();
             }
-            case OP_BUILD_STRING: {
+            TARGET(BUILD_STRING): {
                 py_TValue* begin = SP() - byte.arg;
                 c11_sbuf ss;
                 c11_sbuf__ctor(&ss);
@@ -571,23 +809,36 @@ FrameResult VM__run_top_frame(VM* self) {
                 DISPATCH();
             }
             /*****************************/
-            case OP_BINARY_OP: {
+            TARGET(BINARY_OP): {
                 py_Name op = byte.arg & 0xFF;
+                if(stack_binaryop_number(SECOND(), TOP(), op)) {
+                    POP();
+                    DISPATCH();
+                }
                 py_Name rop = byte.arg >> 8;
                 if(!pk_stack_binaryop(self, op, rop)) goto __ERROR;
                 POP();
                 *TOP() = self->last_retval;
                 DISPATCH();
             }
-            case OP_IS_OP: {
+            TARGET(IS_OP): {
                 bool res = py_isidentical(SECOND(), TOP());
                 POP();
                 if(byte.arg) res = !res;
                 py_newbool(TOP(), res);
                 DISPATCH();
             }
-            case OP_CONTAINS_OP: {
+            TARGET(CONTAINS_OP): {
                 // [b, a] -> b __contains__ a (a in b) -> [retval]
+                py_Type tp_b = SECOND()->type;
+                if(tp_b == tp_set || tp_b == tp_frozenset || tp_b == tp_dict) {
+                    DictEntry* entry;
+                    if(!Dict__try_get(py_touserdata(SECOND()), TOP(), &entry)) goto __ERROR;
+                    bool res = (entry != NULL) != byte.arg;
+                    STACK_SHRINK(2);
+                    py_newbool(SP()++, res);
+                    DISPATCH();
+                }
                 py_Ref magic = py_tpfindmagic(SECOND()->type, __contains__);
                 if(magic) {
                     if(magic->type == tp_nativefunc) {
@@ -607,22 +858,22 @@ FrameResult VM__run_top_frame(VM* self) {
                 goto __ERROR;
             }
                 /*****************************************/
-            case OP_JUMP_FORWARD: DISPATCH_JUMP((int16_t)byte.arg);
-            case OP_POP_JUMP_IF_FALSE: {
+            TARGET(JUMP_FORWARD): DISPATCH_JUMP((int16_t)byte.arg);
+            TARGET(POP_JUMP_IF_FALSE): {
                 int res = py_bool(TOP());
                 if(res < 0) goto __ERROR;
                 POP();
                 if(!res) DISPATCH_JUMP((int16_t)byte.arg);
                 DISPATCH();
             }
-            case OP_POP_JUMP_IF_TRUE: {
+            TARGET(POP_JUMP_IF_TRUE): {
                 int res = py_bool(TOP());
                 if(res < 0) goto __ERROR;
                 POP();
                 if(res) DISPATCH_JUMP((int16_t)byte.arg);
                 DISPATCH();
             }
-            case OP_JUMP_IF_TRUE_OR_POP: {
+            TARGET(JUMP_IF_TRUE_OR_POP): {
                 int res = py_bool(TOP());
                 if(res < 0) goto __ERROR;
                 if(res) {
@@ -632,7 +883,7 @@ FrameResult VM__run_top_frame(VM* self) {
                     DISPATCH();
                 }
             }
-            case OP_JUMP_IF_FALSE_OR_POP: {
+            TARGET(JUMP_IF_FALSE_OR_POP): {
                 int res = py_bool(TOP());
                 if(res < 0) goto __ERROR;
                 if(!res) {
@@ -642,7 +893,7 @@ FrameResult VM__run_top_frame(VM* self) {
                     DISPATCH();
                 }
             }
-            case OP_SHORTCUT_IF_FALSE_OR_POP: {
+            TARGET(SHORTCUT_IF_FALSE_OR_POP): {
                 int res = py_bool(TOP());
                 if(res < 0) goto __ERROR;
                 if(!res) {                      // [b, False]
@@ -654,19 +905,19 @@ FrameResult VM__run_top_frame(VM* self) {
                     DISPATCH();
                 }
             }
-            case OP_LOOP_CONTINUE: {
+            TARGET(LOOP_CONTINUE): {
                 DISPATCH_JUMP((int16_t)byte.arg);
             }
-            case OP_LOOP_BREAK: {
+            TARGET(LOOP_BREAK): {
                 DISPATCH_JUMP((int16_t)byte.arg);
             }
             /*****************************************/
-            case OP_CALL: {
+            TARGET(CALL): {
                 ManagedHeap__collect_if_needed(&self->heap);
                 vectorcall_opcall(byte.arg & 0xFF, byte.arg >> 8);
                 DISPATCH();
             }
-            case OP_CALL_VARGS: {
+            TARGET(CALL_VARGS): {
                 // [_0, _1, _2 | k1, v1, k2, v2]
                 uint16_t argc = byte.arg & 0xFF;
                 uint16_t kwargc = byte.arg >> 8;
@@ -721,7 +972,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 vectorcall_opcall(argc, kwargc);
                 DISPATCH();
             }
-            case OP_RETURN_VALUE: {
+            TARGET(RETURN_VALUE): {
                 CHECK_RETURN_FROM_EXCEPT_OR_FINALLY();
                 if(byte.arg == BC_NOARG) {
                     self->last_retval = POPX();
@@ -738,7 +989,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
                 DISPATCH();
             }
-            case OP_YIELD_VALUE: {
+            TARGET(YIELD_VALUE): {
                 CHECK_RETURN_FROM_EXCEPT_OR_FINALLY();
                 if(byte.arg == 1) {
                     py_newnone(py_retval());
@@ -748,7 +999,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
                 return RES_YIELD;
             }
-            case OP_FOR_ITER_YIELD_VALUE: {
+            TARGET(FOR_ITER_YIELD_VALUE): {
                 CHECK_RETURN_FROM_EXCEPT_OR_FINALLY();
                 int res = py_next(TOP());
                 if(res == -1) goto __ERROR;
@@ -763,61 +1014,56 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
             }
             /////////
-            case OP_LIST_APPEND: {
+            TARGET(LIST_APPEND): {
                 // [list, iter, value]
                 py_list_append(THIRD(), TOP());
                 POP();
                 DISPATCH();
             }
-            case OP_DICT_ADD: {
+            TARGET(DICT_ADD): {
                 // [dict, iter, key, value]
                 bool ok = py_dict_setitem(FOURTH(), SECOND(), TOP());
                 if(!ok) goto __ERROR;
                 STACK_SHRINK(2);
                 DISPATCH();
             }
-            case OP_SET_ADD: {
+            TARGET(SET_ADD): {
                 // [set, iter, value]
-                py_push(THIRD());  // [| set]
-                if(!py_pushmethod(py_name("add"))) {
-                    c11__abort("OP_SET_ADD: failed to load method 'add'");
-                }  // [|add() set]
-                py_push(THIRD());
-                if(!py_vectorcall(1, 0)) goto __ERROR;
+                if(!py_set_add(THIRD(), TOP())) goto __ERROR;
                 POP();
                 DISPATCH();
             }
             /////////
-            case OP_UNARY_NEGATIVE: {
+            TARGET(UNARY_NEGATIVE): {
                 if(!pk_callmagic(__neg__, 1, TOP())) goto __ERROR;
                 *TOP() = self->last_retval;
                 DISPATCH();
             }
-            case OP_UNARY_NOT: {
+            TARGET(UNARY_NOT): {
                 int res = py_bool(TOP());
                 if(res < 0) goto __ERROR;
                 py_newbool(TOP(), !res);
                 DISPATCH();
             }
-            case OP_UNARY_STAR: {
+            TARGET(UNARY_STAR): {
                 py_TValue value = POPX();
                 int* level = py_newobject(SP()++, tp_star_wrapper, 1, sizeof(int));
                 *level = byte.arg;
                 py_setslot(TOP(), 0, &value);
                 DISPATCH();
             }
-            case OP_UNARY_INVERT: {
+            TARGET(UNARY_INVERT): {
                 if(!pk_callmagic(__invert__, 1, TOP())) goto __ERROR;
                 *TOP() = self->last_retval;
                 DISPATCH();
             }
             ////////////////
-            case OP_GET_ITER: {
+            TARGET(GET_ITER): {
                 if(!py_iter(TOP())) goto __ERROR;
                 *TOP() = *py_retval();
                 DISPATCH();
             }
-            case OP_FOR_ITER: {
+            TARGET(FOR_ITER): {
                 int res = py_next(TOP());
                 if(res == -1) goto __ERROR;
                 if(res) {
@@ -830,7 +1076,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
             }
             ////////
-            case OP_IMPORT_PATH: {
+            TARGET(IMPORT_PATH): {
                 py_Ref path_object = c11__at(py_TValue, &frame->co->consts, byte.arg);
                 const char* path = py_tostr(path_object);
                 int res = py_import(path);
@@ -842,7 +1088,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 PUSH(py_retval());
                 DISPATCH();
             }
-            case OP_POP_IMPORT_STAR: {
+            TARGET(POP_IMPORT_STAR): {
                 // [module]
                 NameDict* dict = PyObject__dict(TOP()->_obj);
                 py_Ref all = NameDict__try_get(dict, __all__);
@@ -876,8 +1122,8 @@ FrameResult VM__run_top_frame(VM* self) {
                 DISPATCH();
             }
             ////////
-            case OP_UNPACK_SEQUENCE: {
-                py_TValue* p;
+            TARGET(UNPACK_SEQUENCE): {
+                py_TValue* p = NULL;
                 int length;
 
                 switch(TOP()->type) {
@@ -944,7 +1190,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
                 DISPATCH();
             }
-            case OP_UNPACK_EX: {
+            TARGET(UNPACK_EX): {
                 py_TValue* p;
                 int length = pk_arrayview(TOP(), &p);
                 if(length == -1) {
@@ -967,7 +1213,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 DISPATCH();
             }
             ///////////
-            case OP_BEGIN_CLASS: {
+            TARGET(BEGIN_CLASS): {
                 // [base]
                 py_Name name = byte.arg;
                 py_Type base;
@@ -995,9 +1241,10 @@ FrameResult VM__run_top_frame(VM* self) {
                 self->__curr_class = TOP();
                 DISPATCH();
             }
-            case OP_END_CLASS: {
+            TARGET(END_CLASS): {
                 // [cls or decorated]
                 py_Name name = byte.arg;
+                if(!pk__tp_init_slots(py_totype(self->__curr_class))) goto __ERROR;
                 // set into f_globals
                 py_setdict(frame->module, name, TOP());
 
@@ -1021,7 +1268,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 self->__curr_class = NULL;
                 DISPATCH();
             }
-            case OP_STORE_CLASS_ATTR: {
+            TARGET(STORE_CLASS_ATTR): {
                 assert(self->__curr_class);
                 py_Name name = byte.arg;
                 // TOP() can be a function, classmethod or custom decorator
@@ -1037,7 +1284,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 POP();
                 DISPATCH();
             }
-            case OP_ADD_CLASS_ANNOTATION: {
+            TARGET(ADD_CLASS_ANNOTATION): {
                 assert(self->__curr_class);
                 // [type_hint string]
                 py_Type type = py_totype(self->__curr_class);
@@ -1049,7 +1296,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 DISPATCH();
             }
             ///////////
-            case OP_WITH_ENTER: {
+            TARGET(WITH_ENTER): {
                 // [expr]
                 py_push(TOP());
                 if(!py_pushmethod(__enter__)) {
@@ -1061,7 +1308,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 PUSH(py_retval());
                 DISPATCH();
             }
-            case OP_WITH_EXIT: {
+            TARGET(WITH_EXIT): {
                 // [expr]
                 py_push(TOP());
                 if(!py_pushmethod(__exit__)) {
@@ -1074,17 +1321,17 @@ FrameResult VM__run_top_frame(VM* self) {
                 DISPATCH();
             }
             ///////////
-            case OP_TRY_ENTER: {
+            TARGET(TRY_ENTER): {
                 Frame__set_unwind_target(frame, SP());
                 DISPATCH();
             }
-            case OP_EXCEPTION_MATCH: {
+            TARGET(EXCEPTION_MATCH): {
                 if(!py_checktype(TOP(), tp_type)) goto __ERROR;
                 bool ok = py_isinstance(&self->curr_exception, py_totype(TOP()));
                 py_newbool(TOP(), ok);
                 DISPATCH();
             }
-            case OP_RAISE: {
+            TARGET(RAISE): {
                 // [exception]
                 if(py_istype(TOP(), tp_type)) {
                     if(!py_tpcall(py_totype(TOP()), 0, NULL)) goto __ERROR;
@@ -1097,7 +1344,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 py_raise(TOP());
                 goto __ERROR;
             }
-            case OP_RAISE_ASSERT: {
+            TARGET(RAISE_ASSERT): {
                 if(byte.arg) {
                     if(!py_str(TOP())) goto __ERROR;
                     POP();
@@ -1107,29 +1354,29 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
                 goto __ERROR;
             }
-            case OP_RE_RAISE: {
+            TARGET(RE_RAISE): {
                 if(self->curr_exception.type) {
                     assert(!self->is_curr_exc_handled);
                     goto __ERROR_RE_RAISE;
                 }
                 DISPATCH();
             }
-            case OP_PUSH_EXCEPTION: {
+            TARGET(PUSH_EXCEPTION): {
                 assert(self->curr_exception.type);
                 PUSH(&self->curr_exception);
                 DISPATCH();
             }
-            case OP_BEGIN_EXC_HANDLING: {
+            TARGET(BEGIN_EXC_HANDLING): {
                 assert(self->curr_exception.type);
                 self->is_curr_exc_handled = true;
                 DISPATCH();
             }
-            case OP_END_EXC_HANDLING: {
+            TARGET(END_EXC_HANDLING): {
                 assert(self->curr_exception.type);
                 py_clearexc(NULL);
                 DISPATCH();
             }
-            case OP_BEGIN_FINALLY: {
+            TARGET(BEGIN_FINALLY): {
                 if(self->curr_exception.type) {
                     assert(!self->is_curr_exc_handled);
                     // temporarily handle the exception if any
@@ -1137,7 +1384,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 }
                 DISPATCH();
             }
-            case OP_END_FINALLY: {
+            TARGET(END_FINALLY): {
                 if(byte.arg == BC_NOARG) {
                     if(self->curr_exception.type) {
                         assert(self->is_curr_exc_handled);
@@ -1151,7 +1398,7 @@ FrameResult VM__run_top_frame(VM* self) {
                 DISPATCH();
             }
             //////////////////
-            case OP_FORMAT_STRING: {
+            TARGET(FORMAT_STRING): {
                 py_Ref spec = c11__at(py_TValue, &frame->co->consts, byte.arg);
                 bool ok = stack_format_object(self, py_tosv(spec));
                 if(!ok) goto __ERROR;
@@ -1409,6 +1656,8 @@ static bool stack_format_object(VM* self, c11_sv spec) {
 }
 
 #undef CHECK_RETURN_FROM_EXCEPT_OR_FINALLY
+#undef TARGET
+#undef GOTO_NEXT_STEP
 #undef DISPATCH
 #undef DISPATCH_JUMP
 #undef DISPATCH_JUMP_ABSOLUTE
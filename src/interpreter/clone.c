@@ -0,0 +1,334 @@
+#include "pocketpy/interpreter/vm.h"
+#include "pocketpy/common/utils.h"
+#include "pocketpy/objects/dict.h"
+
+/* A VM is cloned like a copying collector works. Every object reachable from the roots of the
+ * source VM is copied into the new heap, then relocated from a worklist: its values are
+ * redirected to the copies and the storage it shares with the source VM is copied as well.
+ * A table maps the objects, code and shapes of the source VM to their copies. */
+typedef struct {
+    const void* key;
+    void* value;
+} Cloner_KV;
+
+typedef struct Cloner {
+    Cloner_KV* table;  // open addressing with linear probing, `key` is NULL for empty entries
+    int capacity;      // a power of two
+    int length;
+    ManagedHeap* heap;
+    c11_vector /*T=PyObject* */ worklist;  // copied objects to relocate
+    c11_vector /*T=Dict* */ dicts;         // copied dicts to rehash at last
+} Cloner;
+
+static PK_THREAD_LOCAL Cloner* pk_current_cloner;
+
+static Cloner_KV* Cloner__find(Cloner* self, const void* key) {
+    uint64_t hash = (uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ull;
+    uint32_t mask = self->capacity - 1;
+    for(uint32_t i = (uint32_t)(hash >> 32) & mask;; i = (i + 1) & mask) {
+        Cloner_KV* kv = &self->table[i];
+        if(kv->key == key || kv->key == NULL) return kv;
+    }
+}
+
+static void Cloner__alloc_table(Cloner* self, int capacity) {
+    self->capacity = capacity;
+    self->table = PK_MALLOC(sizeof(Cloner_KV) * capacity);
+    memset(self->table, 0, sizeof(Cloner_KV) * capacity);
+}
+
+/// The copy of `key`, or NULL if it is not copied yet.
+static void* Cloner__get(Cloner* self, const void* key) { return Cloner__find(self, key)->value; }
+
+static void Cloner__set(Cloner* self, const void* key, void* value) {
+    // keep the load factor below 1/2
+    if((self->length + 1) * 2 > self->capacity) {
+        Cloner_KV* old_table = self->table;
+        int old_capacity = self->capacity;
+        Cloner__alloc_table(self, old_capacity * 2);
+        for(int i = 0; i < old_capacity; i++) {
+            if(old_table[i].key) *Cloner__find(self, old_table[i].key) = old_table[i];
+        }
+        PK_FREE(old_table);
+    }
+    Cloner_KV* kv = Cloner__find(self, key);
+    assert(kv->key == NULL);
+    kv->key = key;
+    kv->value = value;
+    self->length++;
+}
+
+PyObject* pk__clone_object(PyObject* obj) {
+    Cloner* self = pk_current_cloner;
+    Cloner_KV* kv = Cloner__find(self, obj);
+    if(kv->key) return kv->value;
+    PyObject* res = ManagedHeap__gcclone(self->heap, obj);
+    Cloner__set(self, obj, res);
+    c11_vector__push(PyObject*, &self->worklist, res);
+    return res;
+}
+
+void pk__clone_value(py_TValue* val) {
+    if(val->is_ptr) val->_obj = pk__clone_object(val->_obj);
+}
+
+void pk__clone_namedict(NameDict* dict) {
+    *dict = c11_vector__copy(dict);
+    for(int i = 0; i < dict->length; i++) {
+        pk__clone_value(&c11__at(NameDict_KV, dict, i)->value);
+    }
+}
+
+void pk__clone_dict(Dict* dict, bool is_set) {
+    Dict res;
+    Dict__copy(&res, dict);
+    for(int i = 0; i < res.entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &res.entries, i);
+        if(py_isnil(&entry->key)) {
+            // the value of a deleted entry may be dead
+            entry->val = *py_NIL();
+            continue;
+        }
+        pk__clone_value(&entry->key);
+        if(is_set) {
+            entry->val = *py_NIL();
+        } else {
+            pk__clone_value(&entry->val);
+        }
+    }
+    *dict = res;
+    // the hash of an object may be its address
+    c11_vector__push(Dict*, &pk_current_cloner->dicts, dict);
+}
+
+bool pk__clone_unsupported(void* ud) { return false; }
+
+static SourceData_ Cloner__source(Cloner* self, SourceData_ src) {
+    SourceData_ res = Cloner__get(self, src);
+    if(res) {
+        PK_INCREF(res);
+        return res;
+    }
+    res = PK_MALLOC(sizeof(struct SourceData));
+    *res = *src;
+    res->rc.count = 1;
+    res->filename = c11_string__copy(src->filename);
+    res->source = c11_string__copy(src->source);
+    res->line_starts = c11_vector__copy(&src->line_starts);
+    c11__foreach(const char*, &res->line_starts, it) {
+        *it = res->source->data + (*it - src->source->data);
+    }
+    Cloner__set(self, src, res);
+    return res;
+}
+
+void pk__clone_code(CodeObject* code) {
+    Cloner* self = pk_current_cloner;
+    code->src = Cloner__source(self, code->src);
+    code->name = c11_string__copy(code->name);
+    code->codes = c11_vector__copy(&code->codes);
+    code->codes_ex = c11_vector__copy(&code->codes_ex);
+    code->consts = c11_vector__copy(&code->consts);
+    c11__foreach(py_TValue, &code->consts, it) pk__clone_value(it);
+    code->varnames = c11_vector__copy(&code->varnames);
+    code->varnames_inv = c11_vector__copy(&code->varnames_inv);
+    code->blocks = c11_vector__copy(&code->blocks);
+    code->func_decls = c11_vector__copy(&code->func_decls);
+    c11__foreach(FuncDecl_, &code->func_decls, it) *it = pk__clone_funcdecl(*it);
+    // the inline caches point into the source VM, so they start empty
+    code->attr_caches = c11_vector__copy(&code->attr_caches);
+    memset(code->attr_caches.data, 0, sizeof(AttrCache) * code->attr_caches.length);
+    code->global_caches = c11_vector__copy(&code->global_caches);
+    memset(code->global_caches.data, 0, sizeof(GlobalCache) * code->global_caches.length);
+}
+
+FuncDecl_ pk__clone_funcdecl(FuncDecl_ decl) {
+    Cloner* self = pk_current_cloner;
+    FuncDecl_ res = Cloner__get(self, decl);
+    if(res) {
+        PK_INCREF(res);
+        return res;
+    }
+    res = PK_MALLOC(sizeof(FuncDecl));
+    *res = *decl;
+    res->rc.count = 1;
+    Cloner__set(self, decl, res);
+    pk__clone_code(&res->code);
+    res->args = c11_vector__copy(&decl->args);
+    res->kwargs = c11_vector__copy(&decl->kwargs);
+    c11__foreach(FuncDeclKwArg, &res->kwargs, it) pk__clone_value(&it->value);
+    res->kw_to_index = c11_vector__copy(&decl->kw_to_index);
+    // the docstring of a python function points into the consts of its own code
+    for(int i = 0; i < decl->code.consts.length; i++) {
+        py_TValue* c = c11__at(py_TValue, &decl->code.consts, i);
+        if(decl->docstring && py_isstr(c) && py_tostr(c) == decl->docstring) {
+            res->docstring = py_tostr(c11__at(py_TValue, &res->code.consts, i));
+            break;
+        }
+    }
+    return res;
+}
+
+static InstanceShape* Cloner__shape(Cloner* self, InstanceShape* shape, InstanceShape* parent) {
+    InstanceShape* res = PK_MALLOC(sizeof(InstanceShape));
+    *res = *shape;
+    res->parent = parent;
+    res->offsets = c11_vector__copy(&shape->offsets);
+    res->transitions = c11_vector__copy(&shape->transitions);
+    c11__foreach(InstanceShape*, &res->transitions, it) *it = Cloner__shape(self, *it, res);
+    Cloner__set(self, shape, res);
+    return res;
+}
+
+static void Cloner__types(Cloner* self, TypeList* dst, TypeList* src) {
+    for(py_Type i = 0; i < src->length; i++) {
+        py_TypeInfo* ti = TypeList__emplace(dst);
+        *ti = *TypeList__get(src, i);
+        // 0: unused
+        if(i == 0) continue;
+        if(ti->base) ti->base_ti = TypeList__get(dst, ti->base);
+        pk__clone_value(&ti->self);
+        pk__clone_value(&ti->module);
+        pk__clone_value(&ti->annotations);
+        if(ti->shape) ti->shape = Cloner__shape(self, ti->shape, NULL);
+        for(int j = 0; j < PK_MAGIC_SLOTS_COMMON_LENGTH; j++) {
+            pk__clone_value(ti->magic_0 + j);
+        }
+        if(ti->magic_1) {
+            py_TValue* magic_1 = PK_MALLOC(sizeof(py_TValue) * PK_MAGIC_SLOTS_UNCOMMON_LENGTH);
+            memcpy(magic_1, ti->magic_1, sizeof(py_TValue) * PK_MAGIC_SLOTS_UNCOMMON_LENGTH);
+            for(int j = 0; j < PK_MAGIC_SLOTS_UNCOMMON_LENGTH; j++) {
+                pk__clone_value(magic_1 + j);
+            }
+            ti->magic_1 = magic_1;
+        }
+    }
+}
+
+static void Cloner__modules(ModuleDict* dst, ModuleDict* src) {
+    if(src->path == NULL) return;
+    py_TValue module = src->module;
+    pk__clone_value(&module);
+    // the key is the module's `__path__`, which belongs to the source VM
+    py_TValue path = *NameDict__try_get(PyObject__dict(src->module._obj), __path__);
+    pk__clone_value(&path);
+    // preorder, so that the tree keeps its shape
+    ModuleDict__set(dst, py_tostr(&path), module);
+    if(src->left) Cloner__modules(dst, src->left);
+    if(src->right) Cloner__modules(dst, src->right);
+}
+
+/// Relocate a copied object. Returns `false` if it can't be cloned, before changing it.
+static bool Cloner__relocate(Cloner* self, TypeList* types, PyObject* obj) {
+    py_TypeInfo* ti = TypeList__get(types, obj->type);
+    if(ti->clone) {
+        if(!ti->clone(PyObject__userdata(obj))) return false;
+    } else if(ti->dtor || ti->gc_mark) {
+        // the userdata owns some storage, which would be shared with the source VM
+        return false;
+    }
+
+    if(obj->slots > 0) {
+        py_TValue* p = PyObject__slots(obj);
+        for(int i = 0; i < obj->slots; i++) {
+            pk__clone_value(p + i);
+        }
+    } else if(obj->slots == -1) {
+        pk__clone_namedict(PyObject__dict(obj));
+    } else if(obj->slots <= -2) {
+        InstanceDict* dict = PyObject__instancedict(obj);
+        if(dict->shape) {
+            // the shapes are copied with the types
+            dict->shape = Cloner__get(self, dict->shape);
+            assert(dict->shape != NULL);
+            if(dict->overflow) {
+                int size = sizeof(py_TValue) * dict->overflow_capacity;
+                py_TValue* overflow = PK_MALLOC(size);
+                memcpy(overflow, dict->overflow, size);
+                dict->overflow = overflow;
+            }
+            for(int i = 0; i < dict->shape->length; i++) {
+                pk__clone_value(InstanceDict__at(dict, i));
+            }
+        } else {
+            NameDict* copy = PK_MALLOC(sizeof(NameDict));
+            *copy = *dict->dict;
+            pk__clone_namedict(copy);
+            dict->dict = copy;
+        }
+    }
+    return true;
+}
+
+/// Make a copied object safe to free, when it still shares its storage with the source VM.
+static void Cloner__discard(PyObject* obj) {
+    obj->type = tp_object;
+    obj->slots = 0;
+}
+
+bool VM__clone(VM* self, VM* src, py_Name* error) {
+    assert(src->top_frame == NULL);
+    Cloner cloner;
+    Cloner__alloc_table(&cloner, 4096);
+    cloner.length = 0;
+    cloner.heap = &self->heap;
+    c11_vector__ctor(&cloner.worklist, sizeof(PyObject*));
+    c11_vector__ctor(&cloner.dicts, sizeof(Dict*));
+    pk_current_cloner = &cloner;
+    // nothing is reachable from the roots until the copies are relocated
+    self->heap.gc_enabled = false;
+
+    // roots
+    Cloner__types(&cloner, &self->types, &src->types);
+    Cloner__modules(&self->modules, &src->modules);
+    for(int i = 0; i < c11__count_array(self->ascii_literals); i++) {
+        self->ascii_literals[i] = src->ascii_literals[i];
+        pk__clone_value(&self->ascii_literals[i]);
+    }
+    self->builtins = src->builtins;
+    pk__clone_value(&self->builtins);
+    self->main = src->main;
+    pk__clone_value(&self->main);
+    for(int i = 0; i < c11__count_array(self->reg); i++) {
+        self->reg[i] = src->reg[i];
+        pk__clone_value(&self->reg[i]);
+    }
+    self->callbacks = src->callbacks;
+    self->ctx = src->ctx;
+    self->type_version = src->type_version;
+    self->module_version = src->module_version;
+    if(self->stack.initial_size != src->stack.initial_size ||
+       self->stack.max_size != src->stack.max_size) {
+        ValueStack__dtor(&self->stack);
+        ValueStack__ctor(&self->stack, src->stack.initial_size, src->stack.max_size);
+    }
+
+    bool ok = true;
+    while(cloner.worklist.length > 0) {
+        PyObject* obj = c11_vector__back(PyObject*, &cloner.worklist);
+        c11_vector__pop(&cloner.worklist);
+        if(!Cloner__relocate(&cloner, &self->types, obj)) {
+            *error = TypeList__get(&self->types, obj->type)->name;
+            Cloner__discard(obj);
+            c11__foreach(PyObject*, &cloner.worklist, it) Cloner__discard(*it);
+            ok = false;
+            break;
+        }
+    }
+    // the VM is complete now, so hashing may run python code
+    for(int i = 0; ok && i < cloner.dicts.length; i++) {
+        Dict* dict = c11__getitem(Dict*, &cloner.dicts, i);
+        py_Type type;
+        if(!Dict__rehash_keys(dict, &type)) {
+            *error = TypeList__get(&self->types, type)->name;
+            ok = false;
+        }
+    }
+
+    self->heap.gc_enabled = src->heap.gc_enabled;
+    pk_current_cloner = NULL;
+    PK_FREE(cloner.table);
+    c11_vector__dtor(&cloner.worklist);
+    c11_vector__dtor(&cloner.dicts);
+    return ok;
+}
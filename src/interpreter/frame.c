@@ -6,12 +6,110 @@
 #include "pocketpy/pocketpy.h"
 #include <stdbool.h>
 
-void ValueStack__ctor(ValueStack* self) {
-    self->sp = self->begin;
-    self->end = self->begin + PK_VM_STACK_SIZE;
+static int ValueStackSegment__size(int capacity) {
+    return sizeof(ValueStackSegment) + sizeof(py_TValue) * (capacity + PK_MAX_CO_VARNAMES * 2);
 }
 
-void ValueStack__clear(ValueStack* self) { self->sp = self->begin; }
+static ValueStackSegment* ValueStackSegment__new(int capacity) {
+    ValueStackSegment* self = PK_MALLOC(ValueStackSegment__size(capacity));
+    // gc scans the values below `sp`, so they must never be garbage
+    memset(self, 0, ValueStackSegment__size(capacity));
+    self->prev = NULL;
+    self->prev_sp = NULL;
+    self->capacity = capacity;
+    return self;
+}
+
+static void ValueStack__enter(ValueStack* self, ValueStackSegment* segment, py_TValue* sp) {
+    self->segment = segment;
+    self->sp = sp;
+    self->end = segment->begin + segment->capacity;
+}
+
+void ValueStack__ctor(ValueStack* self, int initial_size, int max_size) {
+    if(initial_size < PK_MAX_CO_VARNAMES) initial_size = PK_MAX_CO_VARNAMES;
+    if(max_size < initial_size) max_size = initial_size;
+    ValueStackSegment* segment = ValueStackSegment__new(initial_size);
+    self->spare = NULL;
+    self->is_overflowing = false;
+    self->size = initial_size;
+    self->initial_size = initial_size;
+    self->max_size = max_size;
+    ValueStack__enter(self, segment, segment->begin);
+}
+
+void ValueStack__dtor(ValueStack* self) {
+    ValueStackSegment* p = self->segment;
+    while(p) {
+        ValueStackSegment* prev = p->prev;
+        PK_FREE(p);
+        p = prev;
+    }
+    PK_FREE(self->spare);
+    self->segment = NULL;
+    self->spare = NULL;
+}
+
+py_TValue* ValueStack__split(ValueStack* self, py_TValue* p0, int reserve) {
+    ValueStackSegment* curr = self->segment;
+    int length = self->sp - p0;
+    // the values already own the segment, e.g. a frame which keeps growing, so it is replaced
+    bool is_owner = p0 == curr->begin && curr->prev != NULL;
+    int available = self->max_size - self->size + (is_owner ? curr->capacity : 0);
+    int capacity = c11__max(curr->capacity * 2, length + reserve);
+    if(capacity > available) capacity = available;
+    if(capacity < length + reserve) {
+        // raising the error needs a few values, which fit in the extra places past `end`
+        if(self->is_overflowing) return p0;
+        self->is_overflowing = true;
+        py_exception(tp_StackOverflowError, "");
+        self->is_overflowing = false;
+        return NULL;
+    }
+
+    ValueStackSegment* segment = self->spare;
+    self->spare = NULL;
+    if(segment == NULL || segment->capacity < capacity || segment->capacity > available) {
+        PK_FREE(segment);
+        segment = ValueStackSegment__new(capacity);
+    }
+    if(is_owner) {
+        segment->prev = curr->prev;
+        segment->prev_sp = curr->prev_sp;
+    } else {
+        segment->prev = curr;
+        segment->prev_sp = p0;
+    }
+    memcpy(segment->begin, p0, length * sizeof(py_TValue));
+    if(is_owner) {
+        self->size -= curr->capacity;
+        self->spare = curr;
+    }
+    self->size += segment->capacity;
+    ValueStack__enter(self, segment, segment->begin + length);
+    return segment->begin;
+}
+
+void ValueStack__reset(ValueStack* self, py_TValue* p0) {
+    ValueStackSegment* curr = self->segment;
+    if(p0 != curr->begin || curr->prev == NULL) {
+        self->sp = p0;
+        return;
+    }
+    // leave the segment and keep it for the next split, which is likely to happen soon
+    self->size -= curr->capacity;
+    ValueStack__enter(self, curr->prev, curr->prev_sp);
+    PK_FREE(self->spare);
+    self->spare = curr;
+}
+
+int ValueStack__trim(ValueStack* self) {
+    if(self->spare == NULL) return 0;
+    int size = ValueStackSegment__size(self->spare->capacity);
+    PK_FREE(self->spare);
+    self->spare = NULL;
+    return size;
+}
 
 py_TValue* FastLocals__try_get_by_name(py_TValue* locals, const CodeObject* co, py_Name name) {
     int index = c11_smallmap_n2i__get(&co->varnames_inv, name, -1);
@@ -27,14 +27,21 @@ static bool generator__next__(int argc, py_Ref argv) {
     VM* vm = pk_current_vm;
     if(ud->state == 2) return StopIteration();
 
+    py_Ref backup = py_getslot(argv, 0);
+    int length = py_list_len(backup);
+    py_StackRef frame_p0 = py_peek(0);
+    if(frame_p0 + length > vm->stack.end) {
+        // continue on a new segment of the stack
+        frame_p0 = ValueStack__split(&vm->stack, frame_p0, length + PK_MAX_CO_VARNAMES);
+        if(frame_p0 == NULL) return false;
+    }
+
     // reset frame->p0
     int locals_offset = ud->frame->locals - ud->frame->p0;
-    ud->frame->p0 = py_peek(0);
+    ud->frame->p0 = frame_p0;
     ud->frame->locals = ud->frame->p0 + locals_offset;
 
     // restore the context
-    py_Ref backup = py_getslot(argv, 0);
-    int length = py_list_len(backup);
     py_TValue* p = py_list_data(backup);
     for(int i = 0; i < length; i++)
         py_push(&p[i]);
@@ -58,10 +65,11 @@ static bool generator__next__(int argc, py_Ref argv) {
     if(res == RES_YIELD) {
         // backup the context
         ud->frame = vm->top_frame;
+        pk__gc_barrier(argv->_obj);
         for(py_StackRef p = ud->frame->p0; p != vm->stack.sp; p++) {
             py_list_append(backup, p);
         }
-        vm->stack.sp = ud->frame->p0;
+        ValueStack__reset(&vm->stack, ud->frame->p0);
         vm->top_frame = vm->top_frame->f_back;
         ud->state = 1;
         return true;
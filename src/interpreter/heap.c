@@ -1,38 +1,69 @@
 #include "pocketpy/interpreter/heap.h"
 #include "pocketpy/config.h"
 #include "pocketpy/interpreter/objectpool.h"
+#include "pocketpy/interpreter/vm.h"
 #include "pocketpy/objects/base.h"
 #include "pocketpy/pocketpy.h"
 
+#include <limits.h>
+
+#if PK_SYSTEM_MALLOC && defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
 void ManagedHeap__ctor(ManagedHeap* self) {
     MultiPool__ctor(&self->small_objects);
     c11_vector__ctor(&self->large_objects, sizeof(PyObject*));
+    c11_vector__ctor(&self->young_objects, sizeof(PyObject*));
+    c11_vector__ctor(&self->remembered, sizeof(PyObject*));
+    c11_vector__ctor(&self->gray_objects, sizeof(PyObject*));
 
     for(int i = 0; i < c11__count_array(self->freed_ma); i++) {
         self->freed_ma[i] = PK_GC_MIN_THRESHOLD;
     }
     self->gc_threshold = PK_GC_MIN_THRESHOLD;
     self->gc_counter = 0;
+    self->old_threshold = PK_GC_MIN_THRESHOLD * 4;
+    self->old_count = 0;
     self->gc_enabled = true;
+    self->phase = GC_PHASE_IDLE;
+    self->cycle_mark_ns = 0;
+    self->mark_epoch = 1;
+    memset(&self->stats, 0, sizeof(ManagedHeapStats));
+}
+
+// large objects are prefixed with their size, so that they can be copied by `VM__clone()`
+#define kLargeObjectPrefix 8
+
+static PyObject* ManagedHeap__alloc_large(int size) {
+    char* p = PK_MALLOC(kLargeObjectPrefix + size);
+    *(int*)p = size;
+    PyObject* obj = (PyObject*)(p + kLargeObjectPrefix);
+    obj->gc_size_class = kMultiPoolCount;
+    return obj;
+}
+
+static void ManagedHeap__free_large(PyObject* obj) {
+    PyObject__dtor(obj);
+    PK_FREE((char*)obj - kLargeObjectPrefix);
 }
 
 void ManagedHeap__dtor(ManagedHeap* self) {
+    // young large objects, before their neighbours in `young_objects` are freed
+    c11__foreach(PyObject*, &self->young_objects, it) {
+        if((*it)->gc_size_class == kMultiPoolCount) ManagedHeap__free_large(*it);
+    }
     // small_objects
     MultiPool__dtor(&self->small_objects);
     // large_objects
-    for(int i = 0; i < self->large_objects.length; i++) {
-        PyObject* obj = c11__getitem(PyObject*, &self->large_objects, i);
-        PyObject__dtor(obj);
-        PK_FREE(obj);
-    }
+    c11__foreach(PyObject*, &self->large_objects, it) ManagedHeap__free_large(*it);
     c11_vector__dtor(&self->large_objects);
+    c11_vector__dtor(&self->young_objects);
+    c11_vector__dtor(&self->remembered);
+    c11_vector__dtor(&self->gray_objects);
 }
 
-void ManagedHeap__collect_if_needed(ManagedHeap* self) {
-    if(!self->gc_enabled) return;
-    if(self->gc_counter < self->gc_threshold) return;
-    self->gc_counter = 0;
-    int freed = ManagedHeap__collect(self);
+static void ManagedHeap__update_threshold(ManagedHeap* self, int freed) {
     // adjust `gc_threshold` based on `freed_ma`
     self->freed_ma[0] = self->freed_ma[1];
     self->freed_ma[1] = self->freed_ma[2];
@@ -43,59 +74,282 @@ void ManagedHeap__collect_if_needed(ManagedHeap* self) {
     self->gc_threshold = c11__min(c11__max(avg_freed, lower), upper);
 }
 
-int ManagedHeap__collect(ManagedHeap* self) {
-    ManagedHeap__mark(self);
-    int freed = ManagedHeap__sweep(self);
+static void ManagedHeap__begin_cycle(ManagedHeap* self);
+static bool ManagedHeap__mark_step(ManagedHeap* self, int work);
+static int ManagedHeap__finish_cycle(ManagedHeap* self, bool lazy);
+static bool ManagedHeap__sweep_step(ManagedHeap* self, int work);
+
+void ManagedHeap__collect_if_needed(ManagedHeap* self) {
+    if(!self->gc_enabled) return;
+    if(self->gc_counter < self->gc_threshold) return;
+    self->gc_counter = 0;
+    if(self->phase == GC_PHASE_MARK) {
+        // trace a few objects for each object allocated since the last step
+        if(ManagedHeap__mark_step(self, self->gc_threshold * PK_GC_STEP_RATIO)) {
+            ManagedHeap__update_threshold(self, ManagedHeap__finish_cycle(self, true));
+        }
+        return;
+    }
+    // and sweep a few arenas left by the last cycle
+    ManagedHeap__sweep_step(self, self->gc_threshold * PK_GC_STEP_RATIO);
+    if(self->old_count >= self->old_threshold) {
+        ManagedHeap__begin_cycle(self);
+    } else {
+        ManagedHeap__update_threshold(self, ManagedHeap__collect_young(self));
+    }
+}
+
+/// Promote the marked young objects into the old generation and free the others.
+/// Unmarked small objects are left to the lazy sweep if `full` is true.
+static int ManagedHeap__sweep_young(ManagedHeap* self, bool full) {
+    int freed = 0;
+    c11__foreach(PyObject*, &self->young_objects, it) {
+        PyObject* obj = *it;
+        bool is_large = obj->gc_size_class == kMultiPoolCount;
+        if(obj->gc_mark == self->mark_epoch) {
+            if(is_large) c11_vector__push(PyObject*, &self->large_objects, obj);
+        } else if(is_large) {
+            ManagedHeap__free_large(obj);
+            freed++;
+        } else if(!full) {
+            PyObject__dtor(obj);
+            MultiPool__dealloc(&self->small_objects, obj, obj->gc_size_class);
+            freed++;
+        }
+    }
+    c11_vector__clear(&self->young_objects);
     return freed;
 }
 
-int ManagedHeap__sweep(ManagedHeap* self) {
-    // small_objects
-    int small_freed = MultiPool__sweep_dealloc(&self->small_objects);
-    // large_objects
+static void ManagedHeap__sweep_large(ManagedHeap* self) {
     int large_living_count = 0;
     for(int i = 0; i < self->large_objects.length; i++) {
         PyObject* obj = c11__getitem(PyObject*, &self->large_objects, i);
-        if(obj->gc_marked) {
-            obj->gc_marked = false;
+        if(obj->gc_mark == self->mark_epoch) {
             c11__setitem(PyObject*, &self->large_objects, large_living_count, obj);
             large_living_count++;
         } else {
-            PyObject__dtor(obj);
-            PK_FREE(obj);
+            ManagedHeap__free_large(obj);
         }
     }
     // shrink `self->large_objects`
-    int large_freed = self->large_objects.length - large_living_count;
     self->large_objects.length = large_living_count;
-    // printf("large_freed=%d\n", large_freed);
-    // printf("small_freed=%d\n", small_freed);
-    return small_freed + large_freed;
+}
+
+static bool ManagedHeap__sweep_step(ManagedHeap* self, int work) {
+    int64_t t0 = time_ns();
+    bool done = MultiPool__sweep_step(&self->small_objects, work);
+    self->stats.total_sweep_ns += time_ns() - t0;
+    return done;
+}
+
+/// Trace up to `work` objects from the gray worklist and the remembered set.
+/// Returns `true` if both are empty.
+static bool ManagedHeap__trace(ManagedHeap* self, int work) {
+    c11_vector* gray_objects = &self->gray_objects;
+    c11_vector* remembered = &self->remembered;
+    for(; work > 0; work--) {
+        PyObject* obj;
+        if(gray_objects->length > 0) {
+            obj = c11_vector__back(PyObject*, gray_objects);
+            c11_vector__pop(gray_objects);
+            // each marked object is grayed once, so this counts the marked objects
+            self->stats.last_traced++;
+        } else if(remembered->length > 0) {
+            // a marked object written since it was traced, it may point to unmarked ones
+            obj = c11_vector__back(PyObject*, remembered);
+            c11_vector__pop(remembered);
+            obj->gc_remembered = false;
+        } else {
+            return true;
+        }
+        PyObject__mark_children(obj);
+    }
+    return gray_objects->length == 0 && remembered->length == 0;
+}
+
+static void ManagedHeap__begin_cycle(ManagedHeap* self) {
+    assert(self->phase == GC_PHASE_IDLE);
+    // dead objects of the last cycle must be swept before their marks change meaning
+    ManagedHeap__sweep_step(self, INT_MAX);
+    int64_t t0 = time_ns();
+    self->stats.last_traced = 0;
+    // everything is traced from the roots, so the remembered set and the worklist are useless
+    c11__foreach(PyObject*, &self->remembered, it) (*it)->gc_remembered = false;
+    c11_vector__clear(&self->remembered);
+    c11_vector__clear(&self->gray_objects);
+    // unmark the old generation by flipping the epoch, the young one is unmarked already
+    self->mark_epoch = !self->mark_epoch;
+    c11__foreach(PyObject*, &self->young_objects, it) (*it)->gc_mark = !self->mark_epoch;
+    self->phase = GC_PHASE_MARK;
+    ManagedHeap__mark_roots(self);
+    self->cycle_mark_ns = time_ns() - t0;
+}
+
+static bool ManagedHeap__mark_step(ManagedHeap* self, int work) {
+    assert(self->phase == GC_PHASE_MARK);
+    int64_t t0 = time_ns();
+    bool done = ManagedHeap__trace(self, work);
+    self->cycle_mark_ns += time_ns() - t0;
+    return done;
+}
+
+static void ManagedHeap__record(ManagedHeap* self, int64_t mark_ns, int64_t sweep_ns, int freed) {
+    ManagedHeapStats* stats = &self->stats;
+    stats->last_freed = freed;
+    stats->last_mark_ns = mark_ns;
+    stats->last_sweep_ns = sweep_ns;
+    stats->total_mark_ns += mark_ns;
+    stats->total_sweep_ns += sweep_ns;
+}
+
+/// Finish the incremental cycle. If `lazy` is true, dead small objects are destructed later
+/// by `ManagedHeap__sweep_step` or the allocator, but they are already counted as freed.
+static int ManagedHeap__finish_cycle(ManagedHeap* self, bool lazy) {
+    assert(self->phase == GC_PHASE_MARK);
+    int64_t t0 = time_ns();
+    // the roots are not guarded by the write barrier, so they are rescanned here
+    ManagedHeap__mark_roots(self);
+    ManagedHeap__trace(self, INT_MAX);
+    int64_t t1 = time_ns();
+    int freed = self->old_count + self->young_objects.length - self->stats.last_traced;
+    ManagedHeap__sweep_young(self, true);
+    ManagedHeap__sweep_large(self);
+    MultiPool__begin_sweep(&self->small_objects, self->mark_epoch);
+    if(!lazy) MultiPool__sweep_step(&self->small_objects, INT_MAX);
+    self->old_count = self->stats.last_traced;
+    self->old_threshold = c11__max(self->old_count * 2, PK_GC_MIN_THRESHOLD * 4);
+    self->phase = GC_PHASE_IDLE;
+    self->stats.full_collections++;
+    ManagedHeap__record(self, self->cycle_mark_ns + (t1 - t0), time_ns() - t1, freed);
+    return freed;
+}
+
+int ManagedHeap__collect(ManagedHeap* self) {
+    // objects marked by the cycle in progress may be dead now, and the marks of an unfinished
+    // cycle can't be reset by flipping the epoch again, so it is finished first
+    if(self->phase == GC_PHASE_MARK) ManagedHeap__finish_cycle(self, true);
+    ManagedHeap__begin_cycle(self);
+    return ManagedHeap__finish_cycle(self, false);
+}
+
+int ManagedHeap__trim(ManagedHeap* self) {
+    ManagedHeap__collect(self);
+    int released = MultiPool__trim(&self->small_objects);
+    // the worklist can be huge after tracing a deep structure
+    released += self->gray_objects.capacity * self->gray_objects.elem_size;
+    c11_vector__dtor(&self->gray_objects);
+    c11_vector__ctor(&self->gray_objects, sizeof(PyObject*));
+#if PK_SYSTEM_MALLOC && defined(__GLIBC__)
+    // return the free pages of the malloc heap to the system
+    malloc_trim(0);
+#endif
+    return released;
+}
+
+int ManagedHeap__collect_young(ManagedHeap* self) {
+    if(self->phase == GC_PHASE_MARK) return ManagedHeap__finish_cycle(self, true);
+    int64_t t0 = time_ns();
+    self->stats.collections++;
+    self->stats.last_traced = 0;
+    // old objects are already marked, so this only traces the young generation and the
+    // children of old objects in the remembered set
+    ManagedHeap__mark_roots(self);
+    ManagedHeap__trace(self, INT_MAX);
+    int64_t t1 = time_ns();
+    int young_length = self->young_objects.length;
+    int freed = ManagedHeap__sweep_young(self, false);
+    self->old_count += young_length - freed;
+    ManagedHeap__record(self, t1 - t0, time_ns() - t1, freed);
+    return freed;
+}
+
+static bool ManagedHeap__sweep_until(ManagedHeap* self, int64_t deadline) {
+    // check the clock every 1024 swept blocks
+    while(!ManagedHeap__sweep_step(self, 1024)) {
+        if(time_ns() >= deadline) return false;
+    }
+    return true;
+}
+
+bool ManagedHeap__step(ManagedHeap* self, int64_t budget_ns) {
+    int64_t deadline = time_ns() + budget_ns;
+    if(self->phase == GC_PHASE_IDLE) {
+        // finish the lazy sweep of the last cycle first, it counts as part of that cycle
+        if(!MultiPool__sweep_step(&self->small_objects, 0)) {
+            return ManagedHeap__sweep_until(self, deadline);
+        }
+        // start the next cycle early, so that it is done before allocations trigger it
+        if(self->old_count < self->old_threshold / 2) {
+            if(self->gc_counter > 0) {
+                self->gc_counter = 0;
+                ManagedHeap__update_threshold(self, ManagedHeap__collect_young(self));
+            }
+            return true;
+        }
+        ManagedHeap__begin_cycle(self);
+    }
+    // check the clock every 1024 traced objects
+    while(!ManagedHeap__mark_step(self, 1024)) {
+        if(time_ns() >= deadline) return false;
+    }
+    ManagedHeap__update_threshold(self, ManagedHeap__finish_cycle(self, true));
+    return ManagedHeap__sweep_until(self, deadline);
+}
+
+void ManagedHeap__remember(ManagedHeap* self, PyObject* obj) {
+    assert(obj->gc_mark == self->mark_epoch && !obj->gc_remembered);
+    obj->gc_remembered = true;
+    c11_vector__push(PyObject*, &self->remembered, obj);
 }
 
 PyObject* ManagedHeap__gcnew(ManagedHeap* self, py_Type type, int slots, int udsize) {
-    assert(slots >= 0 || slots == -1);
+    assert(slots >= 0 || slots == -1 || pk__type_info(type)->shape);
     PyObject* obj;
     // header + slots + udsize
     int size = sizeof(PyObject) + PK_OBJ_SLOTS_SIZE(slots) + udsize;
     if(!PK_LOW_MEMORY_MODE && size <= kPoolMaxBlockSize) {
         obj = MultiPool__alloc(&self->small_objects, size);
         assert(obj != NULL);
+        obj->gc_size_class = (size - 1) >> 5;
     } else {
-        obj = PK_MALLOC(size);
-        c11_vector__push(PyObject*, &self->large_objects, obj);
+        obj = ManagedHeap__alloc_large(size);
     }
+    c11_vector__push(PyObject*, &self->young_objects, obj);
     obj->type = type;
-    obj->gc_marked = false;
+    obj->gc_mark = !self->mark_epoch;
+    obj->gc_remembered = false;
     obj->slots = slots;
 
     // initialize slots or dict
     if(slots >= 0) {
         memset(obj->flex, 0, slots * sizeof(py_TValue));
-    } else {
+    } else if(slots == -1) {
         NameDict__ctor((void*)obj->flex);
+    } else {
+        InstanceDict__ctor((void*)obj->flex, pk__type_info(type)->shape, -2 - slots);
     }
 
     self->gc_counter++;
     return obj;
-}
\ No newline at end of file
+}
+
+PyObject* ManagedHeap__gcclone(ManagedHeap* self, const PyObject* src) {
+    PyObject* obj;
+    int size;
+    if(src->gc_size_class == kMultiPoolCount) {
+        size = *(const int*)((const char*)src - kLargeObjectPrefix);
+        obj = ManagedHeap__alloc_large(size);
+    } else {
+        // the whole block, which is at least as large as the object
+        size = (src->gc_size_class + 1) * 32;
+        obj = MultiPool__alloc(&self->small_objects, size);
+        assert(obj != NULL);
+    }
+    memcpy(obj, src, size);
+    c11_vector__push(PyObject*, &self->young_objects, obj);
+    obj->gc_mark = !self->mark_epoch;
+    obj->gc_remembered = false;
+    self->gc_counter++;
+    return obj;
+}
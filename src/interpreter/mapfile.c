@@ -0,0 +1,72 @@
+#include "pocketpy/pocketpy.h"
+
+#if PK_IS_DESKTOP_PLATFORM && PK_ENABLE_OS
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char* map_file_desktop_only(const char* path, int* size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path,
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              NULL,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              NULL);
+    if(file == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0 ||
+       file_size.QuadPart > INT32_MAX) {
+        CloseHandle(file);
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if(mapping == NULL) return NULL;
+    // the view keeps the mapping alive
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(data == NULL) return NULL;
+    *size = (int)file_size.QuadPart;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return NULL;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > INT32_MAX) {
+        close(fd);
+        return NULL;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) return NULL;
+    *size = (int)st.st_size;
+    return data;
+#endif
+}
+
+void unmap_file_desktop_only(const char* data, int size) {
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+#else
+
+const char* map_file_desktop_only(const char* path, int* size) { return NULL; }
+
+void unmap_file_desktop_only(const char* data, int size) {}
+
+#endif
@@ -3,83 +3,142 @@
 #include "pocketpy/config.h"
 #include "pocketpy/objects/object.h"
 #include "pocketpy/common/sstream.h"
+#include "pocketpy/common/algorithm.h"
 
 #include <assert.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+
+static int c11__ctz64(uint64_t x) {
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int)index;
+}
+
+#define c11__popcount64(x) ((int)__popcnt64(x))
+#else
+#define c11__ctz64(x) __builtin_ctzll(x)
+#define c11__popcount64(x) __builtin_popcountll(x)
+#endif
+
 static PoolArena* PoolArena__new(int block_size) {
     assert(kPoolArenaSize % block_size == 0);
     int block_count = kPoolArenaSize / block_size;
-    PoolArena* self = PK_MALLOC(sizeof(PoolArena) + sizeof(int) * block_count);
+    // only the bitmap needs to be initialized
+    PoolArena* self = PK_MALLOC(sizeof(PoolArena));
     self->block_size = block_size;
     self->block_count = block_count;
-    self->unused_length = block_count;
-    self->unused = PK_MALLOC(sizeof(int) * block_count);
-    for(int i = 0; i < block_count; i++) {
-        self->unused[i] = i;
+    self->used_length = 0;
+    self->cursor = 0;
+    memset(self->used, 0, sizeof(self->used));
+    for(int i = block_count; i < kPoolArenaBitmapLength * 64; i++) {
+        self->used[i / 64] |= 1ULL << (i % 64);
     }
-    memset(self->data, 0, kPoolArenaSize);
     return self;
 }
 
+static PyObject* PoolArena__block(PoolArena* self, int index) {
+    return (PyObject*)(self->data + index * self->block_size);
+}
+
 static void PoolArena__delete(PoolArena* self) {
-    for(int i = 0; i < self->block_count; i++) {
-        PyObject* obj = (PyObject*)(self->data + i * self->block_size);
-        if(obj->type != 0) PyObject__dtor(obj);
+    for(int i = 0; i < kPoolArenaBitmapLength; i++) {
+        for(uint64_t word = self->used[i]; word; word &= word - 1) {
+            int index = i * 64 + c11__ctz64(word);
+            if(index >= self->block_count) break;
+            PyObject* obj = PoolArena__block(self, index);
+            if(obj->type != 0) PyObject__dtor(obj);
+        }
     }
-    PK_FREE(self->unused);
     PK_FREE(self);
 }
 
 static void* PoolArena__alloc(PoolArena* self) {
-    assert(self->unused_length > 0);
-    int index = self->unused[self->unused_length - 1];
-    self->unused_length--;
-    return self->data + index * self->block_size;
-}
-
-static int PoolArena__sweep_dealloc(PoolArena* self) {
-    int freed = 0;
-    self->unused_length = 0;
-    for(int i = 0; i < self->block_count; i++) {
-        PyObject* obj = (PyObject*)(self->data + i * self->block_size);
-        if(obj->type == 0) {
-            // free slot
-            self->unused[self->unused_length] = i;
-            self->unused_length++;
-        } else {
-            if(!obj->gc_marked) {
-                // not marked, need to free
+    assert(self->used_length < self->block_count);
+    while(self->used[self->cursor] == UINT64_MAX) {
+        self->cursor++;
+    }
+    uint64_t word = self->used[self->cursor];
+    int bit = c11__ctz64(~word);
+    self->used[self->cursor] = word | (1ULL << bit);
+    self->used_length++;
+    return PoolArena__block(self, self->cursor * 64 + bit);
+}
+
+/// Free the dead objects, i.e. the ones not marked with `live_mark`, and the blocks which were
+/// in `Pool::free_blocks`. Only allocated blocks are visited.
+static void PoolArena__sweep(PoolArena* self, uint8_t live_mark) {
+    for(int i = 0; i < kPoolArenaBitmapLength; i++) {
+        uint64_t freed_bits = 0;
+        for(uint64_t word = self->used[i]; word; word &= word - 1) {
+            int bit = c11__ctz64(word);
+            int index = i * 64 + bit;
+            if(index >= self->block_count) break;
+            PyObject* obj = PoolArena__block(self, index);
+            if(obj->type == 0) {
+                // a stale free block, its object is already destructed
+                freed_bits |= 1ULL << bit;
+            } else if(obj->gc_mark != live_mark) {
                 PyObject__dtor(obj);
-                obj->type = 0;
-                freed++;
-                self->unused[self->unused_length] = i;
-                self->unused_length++;
-            } else {
-                // marked, clear mark
-                obj->gc_marked = false;
+                freed_bits |= 1ULL << bit;
             }
         }
+        if(freed_bits) {
+            self->used[i] &= ~freed_bits;
+            self->used_length -= c11__popcount64(freed_bits);
+        }
     }
-    return freed;
+    self->cursor = 0;
 }
 
 static void Pool__ctor(Pool* self, int block_size) {
     c11_vector__ctor(&self->arenas, sizeof(PoolArena*));
     c11_vector__ctor(&self->no_free_arenas, sizeof(PoolArena*));
+    c11_vector__ctor(&self->unswept_arenas, sizeof(PoolArena*));
     self->block_size = block_size;
+    self->free_blocks = NULL;
+    self->free_blocks_length = 0;
 }
 
 static void Pool__dtor(Pool* self) {
     c11__foreach(PoolArena*, &self->arenas, arena) PoolArena__delete(*arena);
     c11__foreach(PoolArena*, &self->no_free_arenas, arena) PoolArena__delete(*arena);
+    c11__foreach(PoolArena*, &self->unswept_arenas, arena) PoolArena__delete(*arena);
     c11_vector__dtor(&self->arenas);
     c11_vector__dtor(&self->no_free_arenas);
+    c11_vector__dtor(&self->unswept_arenas);
+}
+
+/// Sweep the last unswept arena and move it to where it belongs.
+static void Pool__sweep_one(Pool* self, uint8_t live_mark) {
+    PoolArena* arena = c11_vector__back(PoolArena*, &self->unswept_arenas);
+    c11_vector__pop(&self->unswept_arenas);
+    PoolArena__sweep(arena, live_mark);
+    if(arena->used_length == arena->block_count) {
+        c11_vector__push(PoolArena*, &self->no_free_arenas, arena);
+    } else if(arena->used_length == 0 && self->arenas.length > 0) {
+        // all free, and there is another arena to allocate from
+        PoolArena__delete(arena);
+    } else {
+        c11_vector__push(PoolArena*, &self->arenas, arena);
+    }
 }
 
-static void* Pool__alloc(Pool* self) {
+static void* Pool__alloc(Pool* self, uint8_t live_mark) {
+    if(self->free_blocks) {
+        PyObject* obj = self->free_blocks;
+        self->free_blocks = *(void**)obj->flex;
+        self->free_blocks_length--;
+        return obj;
+    }
+    // sweep lazily until an arena has free blocks
+    while(self->arenas.length == 0 && self->unswept_arenas.length > 0) {
+        Pool__sweep_one(self, live_mark);
+    }
     PoolArena* arena;
     if(self->arenas.length == 0) {
         arena = PoolArena__new(self->block_size);
@@ -88,56 +147,20 @@ static void* Pool__alloc(Pool* self) {
         arena = c11_vector__back(PoolArena*, &self->arenas);
     }
     void* ptr = PoolArena__alloc(arena);
-    if(arena->unused_length == 0) {
+    if(arena->used_length == arena->block_count) {
         c11_vector__pop(&self->arenas);
         c11_vector__push(PoolArena*, &self->no_free_arenas, arena);
     }
     return ptr;
 }
 
-static int Pool__sweep_dealloc(Pool* self, c11_vector* arenas, c11_vector* no_free_arenas) {
-    c11_vector__clear(arenas);
-    c11_vector__clear(no_free_arenas);
-
-    int freed = 0;
-    for(int i = 0; i < self->arenas.length; i++) {
-        PoolArena* item = c11__getitem(PoolArena*, &self->arenas, i);
-        assert(item->unused_length > 0);
-        freed += PoolArena__sweep_dealloc(item);
-        if(item->unused_length == item->block_count) {
-            // all free
-            if(arenas->length > 0) {
-                // at least one arena
-                PoolArena__delete(item);
-            } else {
-                // no arena
-                c11_vector__push(PoolArena*, arenas, item);
-            }
-        } else {
-            // some free
-            c11_vector__push(PoolArena*, arenas, item);
-        }
-    }
-    for(int i = 0; i < self->no_free_arenas.length; i++) {
-        PoolArena* item = c11__getitem(PoolArena*, &self->no_free_arenas, i);
-        freed += PoolArena__sweep_dealloc(item);
-        if(item->unused_length == 0) {
-            // still no free
-            c11_vector__push(PoolArena*, no_free_arenas, item);
-        } else {
-            if(item->unused_length == item->block_count) {
-                // all free
-                PoolArena__delete(item);
-            } else {
-                // some free
-                c11_vector__push(PoolArena*, arenas, item);
-            }
-        }
-    }
-
-    c11_vector__swap(&self->arenas, arenas);
-    c11_vector__swap(&self->no_free_arenas, no_free_arenas);
-    return freed;
+static void Pool__dealloc(Pool* self, void* p) {
+    // free blocks keep `type == 0` so that `PoolArena__sweep` can recollect them
+    PyObject* obj = p;
+    obj->type = 0;
+    *(void**)obj->flex = self->free_blocks;
+    self->free_blocks = obj;
+    self->free_blocks_length++;
 }
 
 void* MultiPool__alloc(MultiPool* self, int size) {
@@ -145,30 +168,123 @@ void* MultiPool__alloc(MultiPool* self, int size) {
     int index = (size - 1) >> 5;
     if(index < kMultiPoolCount) {
         Pool* pool = &self->pools[index];
-        return Pool__alloc(pool);
+        return Pool__alloc(pool, self->live_mark);
     }
     return NULL;
 }
 
-int MultiPool__sweep_dealloc(MultiPool* self) {
-    c11_vector arenas;
-    c11_vector no_free_arenas;
-    c11_vector__ctor(&arenas, sizeof(PoolArena*));
-    c11_vector__ctor(&no_free_arenas, sizeof(PoolArena*));
-    int freed = 0;
+void MultiPool__dealloc(MultiPool* self, void* p, int size_class) {
+    assert(size_class >= 0 && size_class < kMultiPoolCount);
+    Pool__dealloc(&self->pools[size_class], p);
+}
+
+void MultiPool__begin_sweep(MultiPool* self, uint8_t live_mark) {
+    self->live_mark = live_mark;
     for(int i = 0; i < kMultiPoolCount; i++) {
-        Pool* item = &self->pools[i];
-        freed += Pool__sweep_dealloc(item, &arenas, &no_free_arenas);
+        Pool* pool = &self->pools[i];
+        assert(pool->unswept_arenas.length == 0);
+        c11_vector__swap(&pool->unswept_arenas, &pool->arenas);
+        if(pool->no_free_arenas.length > 0) {
+            c11_vector__extend(PoolArena*,
+                               &pool->unswept_arenas,
+                               pool->no_free_arenas.data,
+                               pool->no_free_arenas.length);
+            c11_vector__clear(&pool->no_free_arenas);
+        }
+        // the free blocks are recollected by the sweep
+        pool->free_blocks = NULL;
+        pool->free_blocks_length = 0;
+    }
+}
+
+bool MultiPool__sweep_step(MultiPool* self, int work) {
+    for(int i = 0; i < kMultiPoolCount; i++) {
+        Pool* pool = &self->pools[i];
+        while(pool->unswept_arenas.length > 0) {
+            if(work <= 0) return false;
+            work -= c11_vector__back(PoolArena*, &pool->unswept_arenas)->used_length + 1;
+            Pool__sweep_one(pool, self->live_mark);
+        }
+    }
+    return true;
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// `madvise()` is not declared by a strict `-std=c11` build
+#ifdef MADV_DONTNEED
+/// Give the pages of free blocks back to the system. They are zero-filled on the next access.
+static int PoolArena__discard_free_pages(PoolArena* self) {
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    int discarded = 0;
+    int i = 0;
+    while(i < self->block_count) {
+        if(self->used[i / 64] >> (i % 64) & 1) {
+            i++;
+            continue;
+        }
+        int j = i + 1;
+        while(j < self->block_count && !(self->used[j / 64] >> (j % 64) & 1)) {
+            j++;
+        }
+        // free blocks [i, j), shrunk to whole pages
+        uintptr_t begin = (uintptr_t)PoolArena__block(self, i);
+        uintptr_t end = (uintptr_t)PoolArena__block(self, j);
+        begin = (begin + page_size - 1) & ~(page_size - 1);
+        end &= ~(page_size - 1);
+        if(begin < end && madvise((void*)begin, end - begin, MADV_DONTNEED) == 0) {
+            discarded += (int)(end - begin);
+        }
+        i = j;
     }
-    c11_vector__dtor(&arenas);
-    c11_vector__dtor(&no_free_arenas);
-    return freed;
+    return discarded;
+}
+#else
+static int PoolArena__discard_free_pages(PoolArena* self) { return 0; }
+#endif
+
+static int PoolArena__sparser(const void* a, const void* b, void* extra) {
+    return (*(PoolArena**)a)->used_length < (*(PoolArena**)b)->used_length;
+}
+
+static int Pool__trim(Pool* self) {
+    assert(self->unswept_arenas.length == 0 && self->free_blocks == NULL);
+    int released = 0;
+    int length = 0;
+    for(int i = 0; i < self->arenas.length; i++) {
+        PoolArena* arena = c11__getitem(PoolArena*, &self->arenas, i);
+        if(arena->used_length == 0) {
+            PoolArena__delete(arena);
+            released += sizeof(PoolArena);
+        } else {
+            // live objects are never moved, but the pages between them can be released
+            released += PoolArena__discard_free_pages(arena);
+            c11__setitem(PoolArena*, &self->arenas, length, arena);
+            length++;
+        }
+    }
+    self->arenas.length = length;
+    // allocate from the densest arena first, so that the sparse ones can drain
+    c11__stable_sort(self->arenas.data, length, sizeof(PoolArena*), PoolArena__sparser, NULL);
+    return released;
+}
+
+int MultiPool__trim(MultiPool* self) {
+    int released = 0;
+    for(int i = 0; i < kMultiPoolCount; i++) {
+        released += Pool__trim(&self->pools[i]);
+    }
+    return released;
 }
 
 void MultiPool__ctor(MultiPool* self) {
     for(int i = 0; i < kMultiPoolCount; i++) {
         Pool__ctor(&self->pools[i], 32 * (i + 1));
     }
+    self->live_mark = 0;
 }
 
 void MultiPool__dtor(MultiPool* self) {
@@ -182,21 +298,28 @@ c11_string* MultiPool__summary(MultiPool* self) {
     c11_sbuf__ctor(&sbuf);
     for(int i = 0; i < kMultiPoolCount; i++) {
         Pool* item = &self->pools[i];
-        int total_bytes = (item->arenas.length + item->no_free_arenas.length) * kPoolArenaSize;
+        int arena_count =
+            item->arenas.length + item->no_free_arenas.length + item->unswept_arenas.length;
+        int total_bytes = arena_count * kPoolArenaSize;
         int used_bytes = 0;
-        for(int j = 0; j < item->arenas.length; j++) {
-            PoolArena* arena = c11__getitem(PoolArena*, &item->arenas, j);
-            used_bytes += (arena->block_count - arena->unused_length) * arena->block_size;
+        c11_vector* lists[] = {&item->arenas, &item->no_free_arenas, &item->unswept_arenas};
+        for(int j = 0; j < c11__count_array(lists); j++) {
+            c11__foreach(PoolArena*, lists[j], it) {
+                used_bytes += (*it)->used_length * item->block_size;
+            }
         }
-        used_bytes += item->no_free_arenas.length * kPoolArenaSize;
-        float used_pct = (float)used_bytes / total_bytes * 100;
+        used_bytes -= item->free_blocks_length * item->block_size;
+        float used_pct = total_bytes == 0 ? 0 : (float)used_bytes / total_bytes * 100;
         char buf[256];
         snprintf(buf,
                  sizeof(buf),
-                 "Pool<%d>: len(arenas)=%d, len(no_free_arenas)=%d, %d/%d (%.1f%% used)",
+                 "Pool<%d>: len(arenas)=%d, len(no_free_arenas)=%d, len(unswept_arenas)=%d, "
+                 "len(free_blocks)=%d, %d/%d (%.1f%% used)",
                  item->block_size,
                  item->arenas.length,
                  item->no_free_arenas.length,
+                 item->unswept_arenas.length,
+                 item->free_blocks_length,
                  used_bytes,
                  total_bytes,
                  used_pct);
@@ -13,6 +13,7 @@ void TypeList__dtor(TypeList* self) {
     for(py_Type t = 0; t < self->length; t++) {
         py_TypeInfo* info = TypeList__get(self, t);
         if(info->magic_1) PK_FREE(info->magic_1);
+        if(info->shape) InstanceShape__delete(info->shape);
     }
     for(int i = 0; i < PK_MAX_CHUNK_LENGTH; i++) {
         if(self->chunks[i]) PK_FREE(self->chunks[i]);
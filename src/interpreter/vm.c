@@ -10,7 +10,7 @@
 #include "pocketpy/pocketpy.h"
 #include <stdbool.h>
 
-static char* pk_default_importfile(const char* path) {
+char* pk_default_importfile(const char* path) {
 #if PK_ENABLE_OS
     FILE* f = fopen(path, "rb");
     if(f == NULL) return NULL;
@@ -53,9 +53,10 @@ static void py_TypeInfo__ctor(py_TypeInfo* self,
 
     self->module = module;
     self->annotations = *py_NIL();
+    self->slots = -1;
 }
 
-void VM__ctor(VM* self) {
+void VM__ctor_empty(VM* self) {
     self->top_frame = NULL;
 
     ModuleDict__ctor(&self->modules, NULL, *py_NIL());
@@ -72,6 +73,8 @@ void VM__ctor(VM* self) {
     self->curr_exception = *py_NIL();
     self->is_signal_interrupted = false;
     self->is_curr_exc_handled = false;
+    self->type_version = 1;
+    self->module_version = 1;
 
     self->ctx = NULL;
     self->__curr_class = NULL;
@@ -80,7 +83,11 @@ void VM__ctor(VM* self) {
     FixedMemoryPool__ctor(&self->pool_frame, sizeof(Frame), 32);
 
     ManagedHeap__ctor(&self->heap);
-    ValueStack__ctor(&self->stack);
+    ValueStack__ctor(&self->stack, PK_VM_STACK_INIT_SIZE, PK_VM_STACK_SIZE);
+}
+
+void VM__ctor(VM* self) {
+    VM__ctor_empty(self);
 
     /* Init Builtin Types */
     for(int i = 0; i < 128; i++) {
@@ -177,7 +184,6 @@ void VM__ctor(VM* self) {
     INJECT_BUILTIN_EXC(KeyError, tp_Exception);
 
 #undef INJECT_BUILTIN_EXC
-#undef validate
 
     /* Setup Public Builtin Types */
     py_Type public_types[] = {
@@ -208,36 +214,46 @@ void VM__ctor(VM* self) {
 
     py_newnotimplemented(py_emplacedict(&self->builtins, py_name("NotImplemented")));
 
+    // these modules define predefined types
     pk__add_module_linalg();
     pk__add_module_array2d();
+
+    // builtin types appended to `py_PredefinedTypes` after the modules above
+    validate(tp_set, pk_set__register());
+    validate(tp_frozenset, pk_frozenset__register());
+    validate(tp_set_iterator, pk_set_iterator__register());
+    validate(tp_map, pk_map__register());
+    validate(tp_filter, pk_filter__register());
+    validate(tp_zip, pk_zip__register());
+    validate(tp_enumerate, pk_enumerate__register());
+    validate(tp_member_descriptor, pk_member_descriptor__register());
+#undef validate
+
+    py_Type appended_public_types[] = {
+        tp_set,
+        tp_frozenset,
+        tp_map,
+        tp_filter,
+        tp_zip,
+        tp_enumerate,
+    };
+    for(int i = 0; i < c11__count_array(appended_public_types); i++) {
+        py_TypeInfo* ti = pk__type_info(appended_public_types[i]);
+        py_setdict(&self->builtins, ti->name, &ti->self);
+    }
+
+    pk__add_module_collections();
     pk__add_module_colorcvt();
 
-    // add modules
-    pk__add_module_os();
-    pk__add_module_sys();
+    // `open()` is a builtin
     pk__add_module_io();
-    pk__add_module_math();
-    pk__add_module_dis();
-    pk__add_module_random();
-    pk__add_module_json();
-    pk__add_module_gc();
-    pk__add_module_time();
-    pk__add_module_easing();
-    pk__add_module_traceback();
-    pk__add_module_enum();
-    pk__add_module_inspect();
-    pk__add_module_pickle();
-    pk__add_module_importlib();
-
-    pk__add_module_conio();
-    pk__add_module_lz4();    // optional
-    pk__add_module_libhv();  // optional
-    pk__add_module_pkpy();
+
+    // other native modules are created on first use, see `py_getmodule()`
 
     // add python builtins
     do {
         bool ok;
-        ok = py_exec(kPythonLibs_builtins, "<builtins>", EXEC_MODE, &self->builtins);
+        ok = pk_exec_pythonlib("builtins", kPythonLibs_builtins, "<builtins>", &self->builtins);
         if(!ok) goto __ABORT;
         break;
     __ABORT:
@@ -257,7 +273,7 @@ void VM__dtor(VM* self) {
     ModuleDict__dtor(&self->modules);
     TypeList__dtor(&self->types);
     FixedMemoryPool__dtor(&self->pool_frame);
-    ValueStack__clear(&self->stack);
+    ValueStack__dtor(&self->stack);
 }
 
 void VM__push_frame(VM* self, Frame* frame) {
@@ -269,8 +285,7 @@ void VM__pop_frame(VM* self) {
     assert(self->top_frame);
     Frame* frame = self->top_frame;
     // reset stack pointer
-
-    self->stack.sp = frame->p0;
+    ValueStack__reset(&self->stack, frame->p0);
     // pop frame and delete
     self->top_frame = frame->f_back;
     Frame__delete(frame);
@@ -353,8 +368,14 @@ py_Type pk_newtype(const char* name,
     py_TypeInfo__ctor(ti, py_name(name), index, base, base_ti, module ? *module : *py_NIL());
     if(!dtor && base) dtor = base_ti->dtor;
     ti->dtor = dtor;
+    if(base) {
+        // the userdata of subclasses has the same layout
+        ti->gc_mark = base_ti->gc_mark;
+        ti->clone = base_ti->clone;
+    }
     ti->is_python = is_python;
     ti->is_sealed = is_sealed;
+    if(is_python) ti->shape = InstanceShape__new(NULL, 0);
     return index;
 }
 
@@ -429,6 +450,24 @@ static bool
     return true;
 }
 
+/// Push the frame of a python function, whose locals are in `[argv, sp)`, and run it unless
+/// `opcall` is true.
+static FrameResult VM__call_frame(VM* self,
+                                  Function* fn,
+                                  py_StackRef p0,
+                                  py_StackRef argv,
+                                  bool opcall) {
+    if(self->stack.sp > self->stack.end) {
+        // continue on a new segment of the stack
+        py_StackRef new_p0 = ValueStack__split(&self->stack, p0, PK_MAX_CO_VARNAMES);
+        if(new_p0 == NULL) return RES_ERROR;
+        argv = new_p0 + (argv - p0);
+        p0 = new_p0;
+    }
+    VM__push_frame(self, Frame__new(&fn->decl->code, &fn->module, p0, argv, true));
+    return opcall ? RES_CALL : VM__run_top_frame(self);
+}
+
 FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall) {
     pk_print_stack(self, self->top_frame, (Bytecode){0});
 
@@ -449,12 +488,6 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
     py_Ref argv = p0 + 1 + (int)py_isnil(p0 + 1);
 
     if(p0->type == tp_function) {
-        // check stack overflow
-        if(self->stack.sp > self->stack.end) {
-            py_exception(tp_StackOverflowError, "");
-            return RES_ERROR;
-        }
-
         Function* fn = py_touserdata(p0);
         const CodeObject* co = &fn->decl->code;
 
@@ -468,8 +501,7 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
                 // submit the call
                 if(!fn->cfunc) {
                     // python function
-                    VM__push_frame(self, Frame__new(co, &fn->module, p0, argv, true));
-                    return opcall ? RES_CALL : VM__run_top_frame(self);
+                    return VM__call_frame(self, fn, p0, argv, opcall);
                 } else {
                     // decl-based binding
                     self->__curr_function = p0;
@@ -497,8 +529,7 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
                 // submit the call
                 if(!fn->cfunc) {
                     // python function
-                    VM__push_frame(self, Frame__new(co, &fn->module, p0, argv, true));
-                    return opcall ? RES_CALL : VM__run_top_frame(self);
+                    return VM__call_frame(self, fn, p0, argv, opcall);
                 } else {
                     // decl-based binding
                     self->__curr_function = p0;
@@ -530,8 +561,16 @@ FrameResult VM__vectorcall(VM* self, uint16_t argc, uint16_t kwargc, bool opcall
             TypeError("nativefunc does not accept keyword arguments");
             return RES_ERROR;
         }
-        bool ok = py_callcfunc(p0->_cfunc, p1 - argv, argv);
-        self->stack.sp = p0;
+        int n = p1 - argv;
+        if(self->stack.sp > self->stack.end) {
+            // continue on a new segment of the stack
+            py_StackRef new_p0 = ValueStack__split(&self->stack, p0, PK_MAX_CO_VARNAMES);
+            if(new_p0 == NULL) return RES_ERROR;
+            argv = new_p0 + (argv - p0);
+            p0 = new_p0;
+        }
+        bool ok = py_callcfunc(p0->_cfunc, n, argv);
+        ValueStack__reset(&self->stack, p0);
         return ok ? RES_RETURN : RES_ERROR;
     }
 
@@ -583,6 +622,7 @@ void PyObject__dtor(PyObject* self) {
     py_TypeInfo* ti = pk__type_info(self->type);
     if(ti->dtor) ti->dtor(PyObject__userdata(self));
     if(self->slots == -1) NameDict__dtor(PyObject__dict(self));
+    if(self->slots <= -2) InstanceDict__dtor(PyObject__instancedict(self));
 }
 
 void pk__mark_namedict(NameDict* dict) {
@@ -598,11 +638,22 @@ void pk__tp_set_marker(py_Type type, void (*gc_mark)(void*)) {
     ti->gc_mark = gc_mark;
 }
 
+void pk__tp_set_cloner(py_Type type, bool (*clone)(void*)) {
+    py_TypeInfo* ti = pk__type_info(type);
+    assert(ti->clone == NULL);
+    ti->clone = clone;
+}
+
 void PyObject__mark(PyObject* obj) {
-    assert(!obj->gc_marked);
+    assert(!pk__is_marked(obj));
 
-    obj->gc_marked = true;
+    obj->gc_mark = pk_current_vm->heap.mark_epoch;
+    // its children are traced later from the worklist, so deep structures can't overflow the
+    // C stack
+    c11_vector__push(PyObject*, &pk_current_vm->heap.gray_objects, obj);
+}
 
+void PyObject__mark_children(PyObject* obj) {
     if(obj->slots > 0) {
         py_TValue* p = PyObject__slots(obj);
         for(int i = 0; i < obj->slots; i++)
@@ -610,6 +661,14 @@ void PyObject__mark(PyObject* obj) {
     } else if(obj->slots == -1) {
         NameDict* dict = PyObject__dict(obj);
         pk__mark_namedict(dict);
+    } else if(obj->slots <= -2) {
+        InstanceDict* dict = PyObject__instancedict(obj);
+        if(dict->shape) {
+            for(int i = 0; i < dict->shape->length; i++)
+                pk__mark_value(InstanceDict__at(dict, i));
+        } else {
+            pk__mark_namedict(dict->dict);
+        }
     }
 
     py_TypeInfo* ti = pk__type_info(obj->type);
@@ -635,11 +694,15 @@ void CodeObject__gc_mark(const CodeObject* self) {
     }
 }
 
-void ManagedHeap__mark(ManagedHeap* self) {
+void ManagedHeap__mark_roots(ManagedHeap* self) {
     VM* vm = pk_current_vm;
-    // mark value stack
-    for(py_TValue* p = vm->stack.begin; p != vm->stack.end; p++) {
-        pk__mark_value(p);
+    // mark value stack, values above `sp` are dead
+    py_TValue* sp = vm->stack.sp;
+    for(ValueStackSegment* seg = vm->stack.segment; seg; seg = seg->prev) {
+        for(py_TValue* p = seg->begin; p != sp; p++) {
+            pk__mark_value(p);
+        }
+        sp = seg->prev_sp;
     }
     // mark ascii literals
     for(int i = 0; i < c11__count_array(vm->ascii_literals); i++) {
@@ -690,7 +753,7 @@ void pk_print_stack(VM* self, Frame* frame, Bytecode byte) {
     py_TValue* sp = self->stack.sp;
     c11_sbuf buf;
     c11_sbuf__ctor(&buf);
-    for(py_Ref p = self->stack.begin; p != sp; p++) {
+    for(py_Ref p = self->stack.segment->begin; p != sp; p++) {
         switch(p->type) {
             case tp_nil: c11_sbuf__write_cstr(&buf, "nil"); break;
             case tp_int: c11_sbuf__write_i64(&buf, p->_i64); break;
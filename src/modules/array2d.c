@@ -2,6 +2,12 @@
 #include "pocketpy/interpreter/vm.h"
 #include "pocketpy/pocketpy.h"
 #include <limits.h>
+#include <stddef.h>
+
+// the elements of an array2d are the slots of its object
+#define c11_array2d__object(self) ((PyObject*)((char*)(self)->data - offsetof(PyObject, flex)))
+// a chunked_array2d is the userdata of an object without slots
+#define c11_chunked_array2d__object(self) ((PyObject*)((char*)(self) - offsetof(PyObject, flex)))
 
 static bool c11_array2d_like_is_valid(c11_array2d_like* self, unsigned int col, unsigned int row) {
     return col < self->n_cols && row < self->n_rows;
@@ -13,6 +19,7 @@ static py_Ref c11_array2d__get(c11_array2d* self, int col, int row) {
 
 static bool c11_array2d__set(c11_array2d* self, int col, int row, py_Ref value) {
     self->data[row * self->header.n_cols + col] = *value;
+    pk__gc_barrier(c11_array2d__object(self));
     return true;
 }
 
@@ -163,7 +170,7 @@ static bool array2d_like_map(int argc, py_Ref argv) {
         for(int i = 0; i < self->n_cols; i++) {
             py_Ref item = self->f_get(self, i, j);
             if(!py_call(f, 1, item)) return false;
-            res->data[j * self->n_cols + i] = *py_retval();
+            c11_array2d__set(res, i, j, py_retval());
         }
     }
     py_assign(py_retval(), py_peek(-1));
@@ -730,6 +737,8 @@ static bool array2d_like_iterator__next__(int argc, py_Ref argv) {
 static void register_array2d_like_iterator(py_Ref mod) {
     py_Type type = py_newtype("array2d_like_iterator", tp_object, mod, NULL);
     assert(type == tp_array2d_like_iterator);
+    // it points to the array
+    pk__tp_set_cloner(type, pk__clone_unsupported);
     py_bindmagic(type, __iter__, pk_wrapper__self);
     py_bindmagic(type, __next__, array2d_like_iterator__next__);
 }
@@ -754,7 +763,7 @@ static bool array2d__new__(int argc, py_Ref argv) {
                                 {i, j}
                 });
                 if(!py_call(default_, 1, &tmp)) return false;
-                ud->data[j * n_cols + i] = *py_retval();
+                c11_array2d__set(ud, i, j, py_retval());
             }
         }
     } else {
@@ -795,9 +804,17 @@ static bool array2d_fromlist_STATIC(int argc, py_Ref argv) {
     return true;
 }
 
+static bool array2d__clone(void* ud) {
+    c11_array2d* self = ud;
+    // the slots are right before the userdata
+    self->data = (py_TValue*)ud - self->header.numel;
+    return true;
+}
+
 static void register_array2d(py_Ref mod) {
     py_Type type = py_newtype("array2d", tp_array2d_like, mod, NULL);
     assert(type == tp_array2d);
+    pk__tp_set_cloner(type, array2d__clone);
     py_bind(py_tpobject(type),
             "__new__(cls, n_cols: int, n_rows: int, default=None)",
             array2d__new__);
@@ -814,6 +831,8 @@ static bool array2d_view_origin(int argc, py_Ref argv) {
 static void register_array2d_view(py_Ref mod) {
     py_Type type = py_newtype("array2d_view", tp_array2d_like, mod, NULL);
     assert(type == tp_array2d_view);
+    // its context points to the viewed object
+    pk__tp_set_cloner(type, pk__clone_unsupported);
     py_bindproperty(type, "origin", array2d_view_origin, NULL);
 }
 
@@ -844,6 +863,7 @@ static py_TValue* c11_chunked_array2d__new_chunk(c11_chunked_array2d* self, c11_
     }
     memset(&data[1], 0, sizeof(py_TValue) * (chunk_numel - 1));
     c11_chunked_array2d_chunks__set(&self->chunks, pos, data);
+    pk__gc_barrier(c11_chunked_array2d__object(self));
     self->last_visited.key = pos;
     self->last_visited.value = data;
     return data;
@@ -906,6 +926,7 @@ bool c11_chunked_array2d__set(c11_chunked_array2d* self, int col, int row, py_Re
         if(data == NULL) return false;
     }
     data[1 + local_pos.y * self->chunk_size + local_pos.x] = *value;
+    pk__gc_barrier(c11_chunked_array2d__object(self));
     return true;
 }
 
@@ -0,0 +1,479 @@
+#include "pocketpy/pocketpy.h"
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/sstream.h"
+#include "pocketpy/common/_generated.h"
+#include "pocketpy/interpreter/vm.h"
+
+/* A ring buffer of values. `capacity` is always a power of 2. */
+typedef struct {
+    py_TValue* data;
+    int head;
+    int length;
+    int capacity;
+    int maxlen;  // -1 means unbounded
+} Deque;
+
+static void Deque__ctor(Deque* self, int maxlen) {
+    self->capacity = 8;
+    self->data = PK_MALLOC(sizeof(py_TValue) * self->capacity);
+    self->head = 0;
+    self->length = 0;
+    self->maxlen = maxlen;
+}
+
+static void Deque__dtor(Deque* self) { PK_FREE(self->data); }
+
+static py_TValue* Deque__at(Deque* self, int index) {
+    return &self->data[(self->head + index) & (self->capacity - 1)];
+}
+
+static void Deque__grow(Deque* self) {
+    int new_capacity = self->capacity * 2;
+    py_TValue* new_data = PK_MALLOC(sizeof(py_TValue) * new_capacity);
+    for(int i = 0; i < self->length; i++) {
+        new_data[i] = *Deque__at(self, i);
+    }
+    PK_FREE(self->data);
+    self->data = new_data;
+    self->head = 0;
+    self->capacity = new_capacity;
+}
+
+static void Deque__clear(Deque* self) {
+    self->head = 0;
+    self->length = 0;
+}
+
+static py_TValue Deque__pop(Deque* self) {
+    assert(self->length > 0);
+    self->length--;
+    return *Deque__at(self, self->length);
+}
+
+static py_TValue Deque__popleft(Deque* self) {
+    assert(self->length > 0);
+    py_TValue retval = self->data[self->head];
+    self->head = (self->head + 1) & (self->capacity - 1);
+    self->length--;
+    return retval;
+}
+
+static void Deque__append(Deque* self, py_TValue* val) {
+    if(self->length == self->maxlen) {
+        if(self->maxlen == 0) return;
+        Deque__popleft(self);
+    }
+    if(self->length == self->capacity) Deque__grow(self);
+    *Deque__at(self, self->length) = *val;
+    self->length++;
+}
+
+static void Deque__appendleft(Deque* self, py_TValue* val) {
+    if(self->length == self->maxlen) {
+        if(self->maxlen == 0) return;
+        Deque__pop(self);
+    }
+    if(self->length == self->capacity) Deque__grow(self);
+    self->head = (self->head - 1) & (self->capacity - 1);
+    self->data[self->head] = *val;
+    self->length++;
+}
+
+/// Extend the deque object `self` with the elements of `iterable`.
+static bool Deque__extend(py_Ref self, py_Ref iterable, bool left) {
+    void (*f)(Deque*, py_TValue*) = left ? Deque__appendleft : Deque__append;
+    Deque* ud = py_touserdata(self);
+    py_TValue* p;
+    int length = pk_arrayview(iterable, &p);
+    if(length != -1) {
+        for(int i = 0; i < length; i++)
+            f(ud, &p[i]);
+        pk__gc_barrier(self->_obj);
+        return true;
+    }
+    if(py_istype(iterable, tp_deque)) {
+        Deque* other = py_touserdata(iterable);
+        // `d.extend(d)` must only see the original elements
+        int n = other->length;
+        for(int i = 0; i < n; i++)
+            f(ud, Deque__at(other, i));
+        pk__gc_barrier(self->_obj);
+        return true;
+    }
+    if(!py_iter(iterable)) return false;
+    py_push(py_retval());
+    while(true) {
+        int res = py_next(py_peek(-1));
+        if(res == -1) return false;
+        if(!res) break;
+        f(ud, py_retval());
+        pk__gc_barrier(self->_obj);
+    }
+    py_pop();
+    return true;
+}
+
+///////////////////////////////
+static bool deque__new__(int argc, py_Ref argv) {
+    py_Type cls = py_totype(argv);
+    int slots = cls == tp_deque ? 0 : -1;
+    Deque* ud = py_newobject(py_retval(), cls, slots, sizeof(Deque));
+    Deque__ctor(ud, -1);
+    return true;
+}
+
+static bool deque__init__(int argc, py_Ref argv) {
+    Deque* self = py_touserdata(argv);
+    if(!py_isnone(py_arg(2))) {
+        PY_CHECK_ARG_TYPE(2, tp_int);
+        py_i64 maxlen = py_toint(py_arg(2));
+        if(maxlen < 0) return ValueError("maxlen must be non-negative");
+        self->maxlen = maxlen;
+    }
+    Deque__clear(self);
+    if(!py_isnone(py_arg(1))) {
+        if(!Deque__extend(argv, py_arg(1), false)) return false;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque__len__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Deque* self = py_touserdata(argv);
+    py_newint(py_retval(), self->length);
+    return true;
+}
+
+static bool deque__getitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    Deque* self = py_touserdata(argv);
+    int index = py_toint(py_arg(1));
+    if(!pk__normalize_index(&index, self->length)) return false;
+    py_assign(py_retval(), Deque__at(self, index));
+    return true;
+}
+
+static bool deque__setitem__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    Deque* self = py_touserdata(argv);
+    int index = py_toint(py_arg(1));
+    if(!pk__normalize_index(&index, self->length)) return false;
+    py_assign(Deque__at(self, index), py_arg(2));
+    pk__gc_barrier(argv->_obj);
+    py_newnone(py_retval());
+    return true;
+}
+
+/// Index of the first element equal to `val`, -1 if not found, -2 on error.
+static int Deque__index(py_Ref self, py_Ref val) {
+    Deque* ud = py_touserdata(self);
+    for(int i = 0; i < ud->length; i++) {
+        py_TValue item = *Deque__at(ud, i);
+        int res = py_equal(&item, val);
+        if(res == -1) return -2;
+        if(res == 1) return i;
+    }
+    return -1;
+}
+
+static bool deque__contains__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int index = Deque__index(argv, py_arg(1));
+    if(index == -2) return false;
+    py_newbool(py_retval(), index >= 0);
+    return true;
+}
+
+static bool deque__iter__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    int* index = py_newobject(py_retval(), tp_deque_iterator, 1, sizeof(int));
+    *index = 0;
+    py_setslot(py_retval(), 0, argv);  // keep a reference to the deque
+    return true;
+}
+
+static bool deque__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Deque* self = py_touserdata(argv);
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    c11_sbuf__write_cstr(&buf, "deque([");
+    for(int i = 0; i < self->length; i++) {
+        if(i > 0) c11_sbuf__write_cstr(&buf, ", ");
+        py_TValue item = *Deque__at(self, i);
+        if(!py_repr(&item)) {
+            c11_sbuf__dtor(&buf);
+            return false;
+        }
+        c11_sbuf__write_sv(&buf, py_tosv(py_retval()));
+    }
+    c11_sbuf__write_char(&buf, ']');
+    if(self->maxlen >= 0) {
+        c11_sbuf__write_cstr(&buf, ", maxlen=");
+        c11_sbuf__write_int(&buf, self->maxlen);
+    }
+    c11_sbuf__write_char(&buf, ')');
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+static bool deque__eq__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!py_istype(py_arg(1), tp_deque)) {
+        py_newnotimplemented(py_retval());
+        return true;
+    }
+    Deque* self = py_touserdata(py_arg(0));
+    Deque* other = py_touserdata(py_arg(1));
+    if(self->length != other->length) {
+        py_newbool(py_retval(), false);
+        return true;
+    }
+    for(int i = 0; i < self->length; i++) {
+        py_TValue lhs = *Deque__at(self, i);
+        py_TValue rhs = *Deque__at(other, i);
+        int res = py_equal(&lhs, &rhs);
+        if(res == -1) return false;
+        if(res == 0) {
+            py_newbool(py_retval(), false);
+            return true;
+        }
+    }
+    py_newbool(py_retval(), true);
+    return true;
+}
+
+static bool deque__ne__(int argc, py_Ref argv) {
+    if(!deque__eq__(argc, argv)) return false;
+    if(py_isbool(py_retval())) {
+        bool res = py_tobool(py_retval());
+        py_newbool(py_retval(), !res);
+    }
+    return true;
+}
+
+static bool deque_append(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    Deque__append(py_touserdata(argv), py_arg(1));
+    pk__gc_barrier(argv->_obj);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_appendleft(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    Deque__appendleft(py_touserdata(argv), py_arg(1));
+    pk__gc_barrier(argv->_obj);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_pop(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Deque* self = py_touserdata(argv);
+    if(self->length == 0) return IndexError("pop from an empty deque");
+    *py_retval() = Deque__pop(self);
+    return true;
+}
+
+static bool deque_popleft(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Deque* self = py_touserdata(argv);
+    if(self->length == 0) return IndexError("pop from an empty deque");
+    *py_retval() = Deque__popleft(self);
+    return true;
+}
+
+static bool deque_extend(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Deque__extend(argv, py_arg(1), false)) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_extendleft(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Deque__extend(argv, py_arg(1), true)) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_clear(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Deque__clear(py_touserdata(argv));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_copy(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Deque* self = py_touserdata(argv);
+    Deque* ud = py_newobject(py_retval(), tp_deque, 0, sizeof(Deque));
+    Deque__ctor(ud, self->maxlen);
+    for(int i = 0; i < self->length; i++) {
+        Deque__append(ud, Deque__at(self, i));
+    }
+    return true;
+}
+
+static bool deque_count(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    Deque* self = py_touserdata(argv);
+    int count = 0;
+    for(int i = 0; i < self->length; i++) {
+        py_TValue item = *Deque__at(self, i);
+        int res = py_equal(&item, py_arg(1));
+        if(res == -1) return false;
+        count += res;
+    }
+    py_newint(py_retval(), count);
+    return true;
+}
+
+static bool deque_index(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int index = Deque__index(argv, py_arg(1));
+    if(index == -2) return false;
+    if(index == -1) return ValueError("deque.index(x): x not in deque");
+    py_newint(py_retval(), index);
+    return true;
+}
+
+static bool deque_remove(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int index = Deque__index(argv, py_arg(1));
+    if(index == -2) return false;
+    if(index == -1) return ValueError("deque.remove(x): x not in deque");
+    Deque* self = py_touserdata(argv);
+    for(int i = index; i < self->length - 1; i++) {
+        *Deque__at(self, i) = *Deque__at(self, i + 1);
+    }
+    self->length--;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_reverse(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Deque* self = py_touserdata(argv);
+    for(int i = 0, j = self->length - 1; i < j; i++, j--) {
+        py_TValue tmp = *Deque__at(self, i);
+        *Deque__at(self, i) = *Deque__at(self, j);
+        *Deque__at(self, j) = tmp;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_rotate(int argc, py_Ref argv) {
+    if(argc > 2) return TypeError("rotate() takes at most 1 argument (%d given)", argc - 1);
+    Deque* self = py_touserdata(argv);
+    py_i64 n = 1;
+    if(argc == 2) {
+        PY_CHECK_ARG_TYPE(1, tp_int);
+        n = py_toint(py_arg(1));
+    }
+    if(self->length <= 1) {
+        py_newnone(py_retval());
+        return true;
+    }
+    n %= self->length;
+    if(n < 0) n += self->length;
+    // rotating right by n is moving the last n elements to the front
+    for(py_i64 i = 0; i < n; i++) {
+        py_TValue val = Deque__pop(self);
+        Deque__appendleft(self, &val);
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool deque_maxlen(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Deque* self = py_touserdata(argv);
+    if(self->maxlen < 0) {
+        py_newnone(py_retval());
+    } else {
+        py_newint(py_retval(), self->maxlen);
+    }
+    return true;
+}
+
+static void deque__gc_mark(void* ud) {
+    Deque* self = ud;
+    for(int i = 0; i < self->length; i++) {
+        pk__mark_value(Deque__at(self, i));
+    }
+}
+
+static bool deque__clone(void* ud) {
+    Deque* self = ud;
+    py_TValue* data = PK_MALLOC(sizeof(py_TValue) * self->capacity);
+    memcpy(data, self->data, sizeof(py_TValue) * self->capacity);
+    self->data = data;
+    for(int i = 0; i < self->length; i++) {
+        pk__clone_value(Deque__at(self, i));
+    }
+    return true;
+}
+
+static bool deque_iterator__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    int* index = py_touserdata(argv);
+    Deque* self = py_touserdata(py_getslot(argv, 0));
+    if(*index >= self->length) return StopIteration();
+    py_assign(py_retval(), Deque__at(self, *index));
+    (*index)++;
+    return true;
+}
+
+void pk__add_module_collections() {
+    py_Ref mod = py_newmodule("collections");
+
+    py_Type type = pk_newtype("deque", tp_object, mod, (void (*)(void*))Deque__dtor, false, false);
+    assert(type == tp_deque);
+    pk__tp_set_marker(tp_deque, deque__gc_mark);
+    pk__tp_set_cloner(tp_deque, deque__clone);
+    py_setdict(mod, py_name("deque"), py_tpobject(tp_deque));
+
+    py_bind(py_tpobject(type), "__new__(cls, iterable=None, maxlen=None)", deque__new__);
+    py_bind(py_tpobject(type), "__init__(self, iterable=None, maxlen=None)", deque__init__);
+    py_bindmagic(tp_deque, __len__, deque__len__);
+    py_bindmagic(tp_deque, __getitem__, deque__getitem__);
+    py_bindmagic(tp_deque, __setitem__, deque__setitem__);
+    py_bindmagic(tp_deque, __contains__, deque__contains__);
+    py_bindmagic(tp_deque, __iter__, deque__iter__);
+    py_bindmagic(tp_deque, __repr__, deque__repr__);
+    py_bindmagic(tp_deque, __eq__, deque__eq__);
+    py_bindmagic(tp_deque, __ne__, deque__ne__);
+    py_setdict(py_tpobject(tp_deque), __hash__, py_None());
+
+    py_bindmethod(tp_deque, "append", deque_append);
+    py_bindmethod(tp_deque, "appendleft", deque_appendleft);
+    py_bindmethod(tp_deque, "pop", deque_pop);
+    py_bindmethod(tp_deque, "popleft", deque_popleft);
+    py_bindmethod(tp_deque, "extend", deque_extend);
+    py_bindmethod(tp_deque, "extendleft", deque_extendleft);
+    py_bindmethod(tp_deque, "clear", deque_clear);
+    py_bindmethod(tp_deque, "copy", deque_copy);
+    py_bindmethod(tp_deque, "count", deque_count);
+    py_bindmethod(tp_deque, "index", deque_index);
+    py_bindmethod(tp_deque, "remove", deque_remove);
+    py_bindmethod(tp_deque, "reverse", deque_reverse);
+    py_bindmethod(tp_deque, "rotate", deque_rotate);
+    py_bindproperty(tp_deque, "maxlen", deque_maxlen, NULL);
+
+    type = pk_newtype("deque_iterator", tp_object, mod, NULL, false, true);
+    assert(type == tp_deque_iterator);
+    py_bindmagic(tp_deque_iterator, __iter__, pk_wrapper__self);
+    py_bindmagic(tp_deque_iterator, __next__, deque_iterator__next__);
+
+    // `Counter` and `defaultdict` are still written in python
+    if(!pk_exec_pythonlib("collections", kPythonLibs_collections, "collections.py", mod)) {
+        py_printexc();
+        c11__abort("failed to execute collections.py");
+    }
+}
@@ -83,7 +83,8 @@ static bool disassemble(CodeObject* co) {
                 case OP_DELETE_ATTR:
                 case OP_BEGIN_CLASS:
                 case OP_DELETE_GLOBAL:
-                case OP_STORE_CLASS_ATTR: {
+                case OP_STORE_CLASS_ATTR:
+                case OP_LOAD_KEYWORD: {
                     pk_sprintf(&ss, " (%n)", byte.arg);
                     break;
                 }
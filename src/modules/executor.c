@@ -0,0 +1,109 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/interpreter/vm.h"
+
+typedef struct {
+    py_VMPool* pool;
+    py_Callbacks callbacks;  // copied to the worker VMs
+} executor_Executor;
+
+typedef struct {
+    py_VMFuture* future;
+} executor_Future;
+
+static void executor_Executor__init_worker(void* ctx) {
+    *py_callbacks() = *(py_Callbacks*)ctx;
+}
+
+static void executor_Executor__dtor(void* ud) {
+    executor_Executor* self = ud;
+    if(self->pool) py_vmpool_delete(self->pool);
+}
+
+static void executor_Future__dtor(void* ud) {
+    executor_Future* self = ud;
+    py_vmfuture_delete(self->future);
+}
+
+static bool executor_Executor__new__(int argc, py_Ref argv) {
+    // __new__(cls, workers)
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    py_i64 workers = py_toint(py_arg(1));
+    if(workers <= 0 || workers > 1024) return ValueError("invalid number of workers: %i", workers);
+    executor_Executor* ud =
+        py_newobject(py_retval(), py_totype(argv), 0, sizeof(executor_Executor));
+    // the userdata does not move, so workers can read the callbacks while they start
+    ud->callbacks = *py_callbacks();
+    ud->pool = py_vmpool_new((int)workers, executor_Executor__init_worker, &ud->callbacks);
+    if(ud->pool == NULL) return RuntimeError("failed to start worker threads");
+    return true;
+}
+
+static bool executor_Executor_submit(int argc, py_Ref argv) {
+    // submit(self, func_path, args=None)
+    executor_Executor* ud = py_touserdata(py_arg(0));
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    if(ud->pool == NULL) return RuntimeError("cannot submit after shutdown");
+    const char* func_path = py_tostr(py_arg(1));
+    py_VMFuture* future;
+    if(py_isnone(py_arg(2))) {
+        py_Ref args = py_pushtmp();
+        py_newtuple(args, 0);
+        future = py_vmpool_submit(ud->pool, func_path, args);
+        py_pop();
+    } else {
+        future = py_vmpool_submit(ud->pool, func_path, py_arg(2));
+    }
+    if(future == NULL) return false;
+    py_Type type = py_gettype("pkpy.executor", py_name("Future"));
+    executor_Future* fut_ud = py_newobject(py_retval(), type, 0, sizeof(executor_Future));
+    fut_ud->future = future;
+    return true;
+}
+
+static bool executor_Executor_shutdown(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    executor_Executor* ud = py_touserdata(py_arg(0));
+    if(ud->pool) {
+        py_vmpool_delete(ud->pool);
+        ud->pool = NULL;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool executor_Executor__enter__(int argc, py_Ref argv) {
+    py_assign(py_retval(), py_arg(0));
+    return true;
+}
+
+static bool executor_Future_done(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    executor_Future* ud = py_touserdata(py_arg(0));
+    py_newbool(py_retval(), py_vmfuture_done(ud->future));
+    return true;
+}
+
+static bool executor_Future_result(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    executor_Future* ud = py_touserdata(py_arg(0));
+    return py_vmfuture_result(ud->future);
+}
+
+void pk__add_module_executor() {
+    py_Ref mod = py_newmodule("pkpy.executor");
+    py_setdict(py_getmodule("pkpy"), py_name("executor"), mod);
+
+    py_Type type = py_newtype("Executor", tp_object, mod, executor_Executor__dtor);
+    py_bindmagic(type, __new__, executor_Executor__new__);
+    py_bindmagic(type, __enter__, executor_Executor__enter__);
+    py_bindmagic(type, __exit__, executor_Executor_shutdown);
+    py_bind(py_tpobject(type), "submit(self, func_path, args=None)", executor_Executor_submit);
+    py_bindmethod(type, "shutdown", executor_Executor_shutdown);
+
+    type = py_newtype("Future", tp_object, mod, executor_Future__dtor);
+    py_bindmethod(type, "done", executor_Future_done);
+    py_bindmethod(type, "result", executor_Future_result);
+}
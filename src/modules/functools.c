@@ -0,0 +1,71 @@
+#include "pocketpy/pocketpy.h"
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/_generated.h"
+#include "pocketpy/interpreter/vm.h"
+
+// cache: 2 slots (func, dict)
+static bool cache__new__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    py_newobject(py_retval(), py_totype(argv), 2, 0);
+    return true;
+}
+
+static bool cache__init__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    py_setslot(argv, 0, py_arg(1));
+    py_newdict(py_getslot(argv, 1));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool cache__call__(int argc, py_Ref argv) {
+    py_Ref func = py_getslot(argv, 0);
+    py_Ref dict = py_getslot(argv, 1);
+    py_Ref key = py_pushtmp();
+    // a single `int` or `str` argument is the key itself, otherwise it is the args tuple
+    if(argc == 2 && (py_isint(py_arg(1)) || py_isstr(py_arg(1)))) {
+        py_assign(key, py_arg(1));
+    } else {
+        py_newtuple(key, argc - 1);
+        for(int i = 1; i < argc; i++) {
+            py_tuple_setitem(key, i - 1, py_arg(i));
+        }
+    }
+    int res = py_dict_getitem(dict, key);
+    if(res == -1) return false;
+    if(res == 1) {
+        py_pop();
+        return true;
+    }
+    if(!py_call(func, argc - 1, py_arg(1))) return false;
+    py_Ref val = py_pushtmp();
+    py_assign(val, py_retval());
+    if(!py_dict_setitem(dict, key, val)) return false;
+    py_assign(py_retval(), val);
+    py_shrink(2);
+    return true;
+}
+
+static bool cache_cache_clear(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_newdict(py_getslot(argv, 1));
+    pk__gc_barrier(argv->_obj);
+    py_newnone(py_retval());
+    return true;
+}
+
+void pk__add_module_functools() {
+    py_Ref mod = py_newmodule("functools");
+
+    py_Type type = py_newtype("cache", tp_object, mod, NULL);
+    py_bindmagic(type, __new__, cache__new__);
+    py_bindmagic(type, __init__, cache__init__);
+    py_bindmagic(type, __call__, cache__call__);
+    py_bindmethod(type, "cache_clear", cache_cache_clear);
+
+    // `reduce` and `partial` are still written in python
+    if(!pk_exec_pythonlib("functools", kPythonLibs_functools, "functools.py", mod)) {
+        py_printexc();
+        c11__abort("failed to execute functools.py");
+    }
+}
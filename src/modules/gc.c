@@ -2,9 +2,15 @@
 #include "pocketpy/interpreter/vm.h"
 
 static bool gc_collect(int argc, py_Ref argv){
-    PY_CHECK_ARGC(0);
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_int);
     ManagedHeap* heap = &pk_current_vm->heap;
-    int res = ManagedHeap__collect(heap);
+    int res;
+    switch(py_toint(py_arg(0))) {
+        case 0: res = ManagedHeap__collect_young(heap); break;
+        case 1: res = ManagedHeap__collect(heap); break;
+        default: return ValueError("invalid generation");
+    }
     py_newint(py_retval(), res);
     return true;
 }
@@ -32,11 +38,54 @@ static bool gc_isenabled(int argc, py_Ref argv){
     return true;
 }
 
+static bool gc_step(int argc, py_Ref argv){
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_int);
+    py_newbool(py_retval(), py_gc_step(py_toint(py_arg(0))));
+    return true;
+}
+
+static bool gc_trim(int argc, py_Ref argv){
+    PY_CHECK_ARGC(0);
+    py_newint(py_retval(), py_gc_trim());
+    return true;
+}
+
+static bool gc_get_stats(int argc, py_Ref argv){
+    PY_CHECK_ARGC(0);
+    ManagedHeapStats* stats = &pk_current_vm->heap.stats;
+    py_Ref res = py_pushtmp();
+    py_Ref tmp = py_pushtmp();
+    py_newdict(res);
+#define SET_INT(name, val)                                                                         \
+    py_newint(tmp, val);                                                                           \
+    py_dict_setitem_by_str(res, name, tmp);
+#define SET_SECONDS(name, val)                                                                     \
+    py_newfloat(tmp, (val) / 1e9);                                                                 \
+    py_dict_setitem_by_str(res, name, tmp);
+    SET_INT("collections", stats->collections)
+    SET_INT("full_collections", stats->full_collections)
+    SET_INT("traced", stats->last_traced)
+    SET_INT("freed", stats->last_freed)
+    SET_SECONDS("mark_time", stats->last_mark_ns)
+    SET_SECONDS("sweep_time", stats->last_sweep_ns)
+    SET_SECONDS("total_mark_time", stats->total_mark_ns)
+    SET_SECONDS("total_sweep_time", stats->total_sweep_ns)
+#undef SET_INT
+#undef SET_SECONDS
+    py_assign(py_retval(), res);
+    py_shrink(2);
+    return true;
+}
+
 void pk__add_module_gc() {
     py_Ref mod = py_newmodule("gc");
 
-    py_bindfunc(mod, "collect", gc_collect);
+    py_bind(mod, "collect(generation=1)", gc_collect);
     py_bindfunc(mod, "enable", gc_enable);
     py_bindfunc(mod, "disable", gc_disable);
     py_bindfunc(mod, "isenabled", gc_isenabled);
+    py_bind(mod, "step(budget_us=1000)", gc_step);
+    py_bindfunc(mod, "trim", gc_trim);
+    py_bindfunc(mod, "get_stats", gc_get_stats);
 }
\ No newline at end of file
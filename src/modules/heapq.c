@@ -0,0 +1,139 @@
+#include "pocketpy/pocketpy.h"
+#include "pocketpy/interpreter/vm.h"
+
+/// Compare `heap[i] < heap[j]`. Returns -1 on error or if the list was resized by `__lt__`.
+static int Heap__less(py_Ref heap, int n, int i, int j) {
+    py_TValue* data = py_list_data(heap);
+    py_TValue lhs = data[i];
+    py_TValue rhs = data[j];
+    int res = py_less(&lhs, &rhs);
+    if(res == -1) return -1;
+    if(py_list_len(heap) != n) {
+        RuntimeError("list changed size during iteration");
+        return -1;
+    }
+    return res;
+}
+
+// 'heap' is a heap at all indices >= startpos, except possibly for pos.  pos
+// is the index of a leaf with a possibly out-of-order value.  Restore the
+// heap invariant.
+static bool Heap__siftdown(py_Ref heap, int startpos, int pos) {
+    int n = py_list_len(heap);
+    while(pos > startpos) {
+        int parentpos = (pos - 1) >> 1;
+        int res = Heap__less(heap, n, pos, parentpos);
+        if(res == -1) return false;
+        if(!res) break;
+        py_list_swap(heap, pos, parentpos);
+        pos = parentpos;
+    }
+    return true;
+}
+
+static bool Heap__siftup(py_Ref heap, int pos) {
+    int endpos = py_list_len(heap);
+    int startpos = pos;
+    // Bubble up the smaller child until hitting a leaf.
+    int childpos = 2 * pos + 1;
+    while(childpos < endpos) {
+        // Set childpos to index of smaller child.
+        int rightpos = childpos + 1;
+        if(rightpos < endpos) {
+            int res = Heap__less(heap, endpos, childpos, rightpos);
+            if(res == -1) return false;
+            if(!res) childpos = rightpos;
+        }
+        // Move the smaller child up.
+        py_list_swap(heap, pos, childpos);
+        pos = childpos;
+        childpos = 2 * pos + 1;
+    }
+    // The leaf at pos holds the new item now.  Bubble it up to its final
+    // resting place (by sifting its parents down).
+    return Heap__siftdown(heap, startpos, pos);
+}
+
+static bool heapq_heappush(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    py_list_append(argv, py_arg(1));
+    if(!Heap__siftdown(argv, 0, py_list_len(argv) - 1)) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool heapq_heappop(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    int n = py_list_len(argv);
+    if(n == 0) return IndexError("index out of range");
+    // keep the result on the stack while sifting
+    py_Ref item = py_pushtmp();
+    py_assign(item, py_list_getitem(argv, 0));
+    py_list_swap(argv, 0, n - 1);
+    py_list_delitem(argv, n - 1);
+    if(n > 1 && !Heap__siftup(argv, 0)) return false;
+    py_assign(py_retval(), item);
+    py_pop();
+    return true;
+}
+
+static bool heapq_heapreplace(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    if(py_list_len(argv) == 0) return IndexError("index out of range");
+    py_Ref item = py_pushtmp();
+    py_assign(item, py_list_getitem(argv, 0));
+    py_list_setitem(argv, 0, py_arg(1));
+    if(!Heap__siftup(argv, 0)) return false;
+    py_assign(py_retval(), item);
+    py_pop();
+    return true;
+}
+
+static bool heapq_heappushpop(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    if(py_list_len(argv) == 0) {
+        py_assign(py_retval(), py_arg(1));
+        return true;
+    }
+    py_Ref item = py_pushtmp();
+    py_assign(item, py_list_getitem(argv, 0));
+    int res = py_less(item, py_arg(1));
+    if(res == -1) return false;
+    if(!res) {
+        py_pop();
+        py_assign(py_retval(), py_arg(1));
+        return true;
+    }
+    py_list_setitem(argv, 0, py_arg(1));
+    if(!Heap__siftup(argv, 0)) return false;
+    py_assign(py_retval(), item);
+    py_pop();
+    return true;
+}
+
+static bool heapq_heapify(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    int n = py_list_len(argv);
+    // Transform bottom-up.  The largest index there's any point to looking at
+    // is the largest with a child index in-range, which is n//2 - 1.
+    for(int i = n / 2 - 1; i >= 0; i--) {
+        if(!Heap__siftup(argv, i)) return false;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+void pk__add_module_heapq() {
+    py_Ref mod = py_newmodule("heapq");
+
+    py_bindfunc(mod, "heappush", heapq_heappush);
+    py_bindfunc(mod, "heappop", heapq_heappop);
+    py_bindfunc(mod, "heapreplace", heapq_heapreplace);
+    py_bindfunc(mod, "heappushpop", heapq_heappushpop);
+    py_bindfunc(mod, "heapify", heapq_heapify);
+}
@@ -5,12 +5,17 @@
 #include "pocketpy/common/sstream.h"
 #include "pocketpy/interpreter/vm.h"
 #include <math.h>
+#include <stdlib.h>
 
 static bool json_loads(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    PY_CHECK_ARG_TYPE(0, tp_str);
-    const char* source = py_tostr(argv);
-    return py_json_loads(source);
+    if(py_isstr(argv)) return py_json_loadsv(py_tosv(argv));
+    if(py_istype(argv, tp_bytes)) {
+        int size;
+        unsigned char* data = py_tobytes(argv, &size);
+        return py_json_loadsv((c11_sv){(const char*)data, size});
+    }
+    return TypeError("the JSON object must be str or bytes, not '%t'", argv->type);
 }
 
 static bool json_dumps(int argc, py_Ref argv) {
@@ -21,15 +26,6 @@ static bool json_dumps(int argc, py_Ref argv) {
 void pk__add_module_json() {
     py_Ref mod = py_newmodule("json");
 
-    py_setdict(mod, py_name("null"), py_None());
-    py_setdict(mod, py_name("true"), py_True());
-    py_setdict(mod, py_name("false"), py_False());
-    py_TValue tmp;
-    py_newfloat(&tmp, NAN);
-    py_setdict(mod, py_name("NaN"), &tmp);
-    py_newfloat(&tmp, INFINITY);
-    py_setdict(mod, py_name("Infinity"), &tmp);
-
     py_bindfunc(mod, "loads", json_loads);
     py_bindfunc(mod, "dumps", json_dumps);
 }
@@ -114,9 +110,349 @@ bool py_json_dumps(py_Ref val) {
     return true;
 }
 
+typedef struct {
+    const char* begin;
+    const char* p;
+    const char* end;
+} json__parser;
+
+static bool json__error(json__parser* self, const char* msg) {
+    int line = 1;
+    const char* line_start = self->begin;
+    for(const char* c = self->begin; c < self->p; c++) {
+        if(*c == '\n') {
+            line++;
+            line_start = c + 1;
+        }
+    }
+    int column = c11__byte_index_to_unicode(line_start, self->p - line_start) + 1;
+    return ValueError("%s: line %d column %d", msg, line, column);
+}
+
+static void json__skip_ws(json__parser* self) {
+    while(self->p < self->end) {
+        switch(*self->p) {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r': self->p++; break;
+            default: return;
+        }
+    }
+}
+
+static bool json__match(json__parser* self, const char* word) {
+    int n = strlen(word);
+    if(self->end - self->p < n || memcmp(self->p, word, n) != 0) return false;
+    self->p += n;
+    return true;
+}
+
+static int json__hex4(const char* p) {
+    int code = 0;
+    for(int i = 0; i < 4; i++) {
+        char c = p[i];
+        code <<= 4;
+        if(c >= '0' && c <= '9') {
+            code |= c - '0';
+        } else if(c >= 'a' && c <= 'f') {
+            code |= c - 'a' + 10;
+        } else if(c >= 'A' && c <= 'F') {
+            code |= c - 'A' + 10;
+        } else {
+            return -1;
+        }
+    }
+    return code;
+}
+
+static void json__write_utf8(c11_sbuf* buf, int code) {
+    if(code < 0x80) {
+        c11_sbuf__write_char(buf, (char)code);
+    } else if(code < 0x800) {
+        c11_sbuf__write_char(buf, (char)(0xC0 | (code >> 6)));
+        c11_sbuf__write_char(buf, (char)(0x80 | (code & 0x3F)));
+    } else if(code < 0x10000) {
+        c11_sbuf__write_char(buf, (char)(0xE0 | (code >> 12)));
+        c11_sbuf__write_char(buf, (char)(0x80 | ((code >> 6) & 0x3F)));
+        c11_sbuf__write_char(buf, (char)(0x80 | (code & 0x3F)));
+    } else {
+        c11_sbuf__write_char(buf, (char)(0xF0 | (code >> 18)));
+        c11_sbuf__write_char(buf, (char)(0x80 | ((code >> 12) & 0x3F)));
+        c11_sbuf__write_char(buf, (char)(0x80 | ((code >> 6) & 0x3F)));
+        c11_sbuf__write_char(buf, (char)(0x80 | (code & 0x3F)));
+    }
+}
+
+// `self->p` points to the opening quote
+static bool json__parse_string(json__parser* self, py_OutRef out) {
+    const char* start = ++self->p;
+    // fast path: no escapes, the string is a slice of the source
+    while(self->p < self->end) {
+        unsigned char c = *self->p;
+        if(c == '"') {
+            py_newstrv(out, (c11_sv){start, self->p - start});
+            self->p++;
+            return true;
+        }
+        if(c == '\\') break;
+        if(c < 0x20) return json__error(self, "Invalid control character");
+        self->p++;
+    }
+
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    c11_sbuf__write_cstrn(&buf, start, self->p - start);
+    while(self->p < self->end) {
+        unsigned char c = *self->p;
+        if(c == '"') {
+            self->p++;
+            c11_sbuf__py_submit(&buf, out);
+            return true;
+        }
+        if(c < 0x20) {
+            c11_sbuf__dtor(&buf);
+            return json__error(self, "Invalid control character");
+        }
+        if(c != '\\') {
+            c11_sbuf__write_char(&buf, c);
+            self->p++;
+            continue;
+        }
+        if(self->end - self->p < 2) break;
+        const char* escape = self->p;
+        self->p += 2;
+        switch(escape[1]) {
+            case '"': c11_sbuf__write_char(&buf, '"'); break;
+            case '\\': c11_sbuf__write_char(&buf, '\\'); break;
+            case '/': c11_sbuf__write_char(&buf, '/'); break;
+            case 'b': c11_sbuf__write_char(&buf, '\b'); break;
+            case 'f': c11_sbuf__write_char(&buf, '\f'); break;
+            case 'n': c11_sbuf__write_char(&buf, '\n'); break;
+            case 'r': c11_sbuf__write_char(&buf, '\r'); break;
+            case 't': c11_sbuf__write_char(&buf, '\t'); break;
+            case 'x': {
+                // not JSON, but `json.dumps` writes non-printable bytes this way
+                int code = -1;
+                if(self->end - self->p >= 2) {
+                    char tmp[4] = {'0', '0', self->p[0], self->p[1]};
+                    code = json__hex4(tmp);
+                }
+                if(code == -1) goto __invalid_escape;
+                c11_sbuf__write_char(&buf, (char)code);
+                self->p += 2;
+                break;
+            }
+            case 'u': {
+                int code = self->end - self->p >= 4 ? json__hex4(self->p) : -1;
+                if(code == -1) goto __invalid_escape;
+                self->p += 4;
+                // combine a surrogate pair
+                if(code >= 0xD800 && code <= 0xDBFF && self->end - self->p >= 6 &&
+                   self->p[0] == '\\' && self->p[1] == 'u') {
+                    int low = json__hex4(self->p + 2);
+                    if(low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        self->p += 6;
+                    }
+                }
+                json__write_utf8(&buf, code);
+                break;
+            }
+            default: goto __invalid_escape;
+        }
+        continue;
+    __invalid_escape:
+        self->p = escape;
+        c11_sbuf__dtor(&buf);
+        return json__error(self, "Invalid \\escape");
+    }
+    self->p = start - 1;
+    c11_sbuf__dtor(&buf);
+    return json__error(self, "Unterminated string");
+}
+
+static bool json__parse_number(json__parser* self, py_OutRef out) {
+    const char* start = self->p;
+    const char* p = self->p;
+    if(p < self->end && *p == '-') p++;
+    if(self->end - p >= 8 && memcmp(p, "Infinity", 8) == 0) {
+        self->p = p + 8;
+        py_newfloat(out, p == start ? INFINITY : -INFINITY);
+        return true;
+    }
+    const char* digits = p;
+    if(p < self->end && *p == '0') {
+        p++;  // no leading zeros
+    } else {
+        while(p < self->end && *p >= '0' && *p <= '9') p++;
+    }
+    if(p == digits) return json__error(self, "Expecting value");
+    bool is_float = false;
+    if(p < self->end && *p == '.') {
+        is_float = true;
+        const char* frac = ++p;
+        while(p < self->end && *p >= '0' && *p <= '9') p++;
+        if(p == frac) return json__error(self, "Expecting value");
+    }
+    if(p < self->end && (*p == 'e' || *p == 'E')) {
+        is_float = true;
+        p++;
+        if(p < self->end && (*p == '+' || *p == '-')) p++;
+        const char* exp = p;
+        while(p < self->end && *p >= '0' && *p <= '9') p++;
+        if(p == exp) return json__error(self, "Expecting value");
+    }
+    self->p = p;
+
+    if(!is_float) {
+        // accumulate a negative value, so that INT64_MIN fits
+        int64_t val = 0;
+        const char* q = digits;
+        while(q < p) {
+            int digit = *q - '0';
+            if(val < (INT64_MIN + digit) / 10) break;
+            val = val * 10 - digit;
+            q++;
+        }
+        bool is_negative = start != digits;
+        if(q == p && (is_negative || val != INT64_MIN)) {
+            py_newint(out, is_negative ? val : -val);
+            return true;
+        }
+        // too large for an int, fall back to float
+    }
+    // `strtod` needs a null-terminated string
+    char tmp[64];
+    int size = p - start;
+    char* text = size < 64 ? tmp : PK_MALLOC(size + 1);
+    memcpy(text, start, size);
+    text[size] = '\0';
+    py_newfloat(out, strtod(text, NULL));
+    if(text != tmp) PK_FREE(text);
+    return true;
+}
+
+static bool json__parse_value(json__parser* self, py_OutRef out);
+
+static bool json__parse_array(json__parser* self, py_OutRef out) {
+    self->p++;
+    py_newlist(out);
+    json__skip_ws(self);
+    if(self->p < self->end && *self->p == ']') {
+        self->p++;
+        return true;
+    }
+    py_Ref item = py_pushtmp();
+    while(true) {
+        if(!json__parse_value(self, item)) return false;
+        py_list_append(out, item);
+        json__skip_ws(self);
+        if(self->p < self->end && *self->p == ',') {
+            self->p++;
+            continue;
+        }
+        if(self->p < self->end && *self->p == ']') {
+            self->p++;
+            py_pop();
+            return true;
+        }
+        return json__error(self, "Expecting ',' delimiter");
+    }
+}
+
+static bool json__parse_object(json__parser* self, py_OutRef out) {
+    self->p++;
+    py_newdict(out);
+    json__skip_ws(self);
+    if(self->p < self->end && *self->p == '}') {
+        self->p++;
+        return true;
+    }
+    py_Ref key = py_pushtmp();
+    py_Ref val = py_pushtmp();
+    while(true) {
+        json__skip_ws(self);
+        if(self->p == self->end || *self->p != '"') {
+            return json__error(self, "Expecting property name enclosed in double quotes");
+        }
+        if(!json__parse_string(self, key)) return false;
+        json__skip_ws(self);
+        if(self->p == self->end || *self->p != ':') {
+            return json__error(self, "Expecting ':' delimiter");
+        }
+        self->p++;
+        if(!json__parse_value(self, val)) return false;
+        if(!py_dict_setitem(out, key, val)) return false;
+        json__skip_ws(self);
+        if(self->p < self->end && *self->p == ',') {
+            self->p++;
+            continue;
+        }
+        if(self->p < self->end && *self->p == '}') {
+            self->p++;
+            py_shrink(2);
+            return true;
+        }
+        return json__error(self, "Expecting ',' delimiter");
+    }
+}
+
+static bool json__parse_value(json__parser* self, py_OutRef out) {
+    VM* vm = pk_current_vm;
+    if(vm->stack.sp >= vm->stack.end) {
+        // nest deeper on a new segment of the stack, nothing is moved
+        py_StackRef p0 = ValueStack__split(&vm->stack, vm->stack.sp, PK_MAX_CO_VARNAMES);
+        if(p0 == NULL) return false;
+        py_pushnil();  // the segment is left when `sp` is reset to its beginning
+        bool ok = json__parse_value(self, out);
+        ValueStack__reset(&vm->stack, p0);
+        return ok;
+    }
+    json__skip_ws(self);
+    if(self->p == self->end) return json__error(self, "Expecting value");
+    switch(*self->p) {
+        case '{': return json__parse_object(self, out);
+        case '[': return json__parse_array(self, out);
+        case '"': return json__parse_string(self, out);
+        case 'n':
+            if(!json__match(self, "null")) break;
+            py_newnone(out);
+            return true;
+        case 't':
+            if(!json__match(self, "true")) break;
+            py_newbool(out, true);
+            return true;
+        case 'f':
+            if(!json__match(self, "false")) break;
+            py_newbool(out, false);
+            return true;
+        case 'N':
+            if(!json__match(self, "NaN")) break;
+            py_newfloat(out, NAN);
+            return true;
+        default: return json__parse_number(self, out);
+    }
+    return json__error(self, "Expecting value");
+}
+
+bool py_json_loadsv(c11_sv source) {
+    VM* vm = pk_current_vm;
+    py_StackRef p0 = vm->stack.sp;
+    json__parser parser = {source.data, source.data, source.data + source.size};
+    py_Ref out = py_pushtmp();
+    bool ok = json__parse_value(&parser, out);
+    if(ok) {
+        json__skip_ws(&parser);
+        if(parser.p != parser.end) ok = json__error(&parser, "Extra data");
+    }
+    if(ok) py_assign(py_retval(), out);
+    vm->stack.sp = p0;
+    return ok;
+}
+
 bool py_json_loads(const char* source) {
-    py_GlobalRef mod = py_getmodule("json");
-    return py_exec(source, "<json>", EVAL_MODE, mod);
+    return py_json_loadsv((c11_sv){source, strlen(source)});
 }
 
 bool py_pusheval(const char* expr, py_GlobalRef module) {
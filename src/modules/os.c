@@ -215,6 +215,8 @@ void pk__add_module_io() {
     py_Ref mod = py_newmodule("io");
 
     py_Type FileIO = pk_newtype("FileIO", tp_object, mod, NULL, false, true);
+    // an open file can't be shared by two VMs
+    pk__tp_set_cloner(FileIO, pk__clone_unsupported);
 
     py_bindmagic(FileIO, __new__, io_FileIO__new__);
     py_bindmagic(FileIO, __enter__, io_FileIO__enter__);
@@ -372,19 +372,20 @@ static bool pkl__write_object(PickleObject* buf, py_TValue* obj) {
                 pkl__store_memo(buf, obj->_obj);
                 return true;
             }
-            if(ti->is_python) {
-                NameDict* dict = PyObject__dict(obj->_obj);
-                for(int i = dict->length - 1; i >= 0; i--) {
-                    NameDict_KV* kv = c11__at(NameDict_KV, dict, i);
-                    if(!pkl__write_object(buf, &kv->value)) return false;
+            if(ti->is_python && obj->_obj->slots <= -2) {
+                InstanceDict* dict = PyObject__instancedict(obj->_obj);
+                int length = InstanceDict__length(dict);
+                py_Name name;
+                for(int i = length - 1; i >= 0; i--) {
+                    if(!pkl__write_object(buf, InstanceDict__item(dict, i, &name))) return false;
                 }
                 pkl__emit_op(buf, PKL_OBJECT);
                 pkl__emit_int(buf, obj->type);
                 buf->used_types[obj->type] = true;
-                pkl__emit_int(buf, dict->length);
-                for(int i = 0; i < dict->length; i++) {
-                    NameDict_KV* kv = c11__at(NameDict_KV, dict, i);
-                    c11_sv field = py_name2sv(kv->key);
+                pkl__emit_int(buf, length);
+                for(int i = 0; i < length; i++) {
+                    InstanceDict__item(dict, i, &name);
+                    c11_sv field = py_name2sv(name);
                     // include '\0'
                     PickleObject__write_bytes(buf, field.data, field.size + 1);
                 }
@@ -676,13 +677,14 @@ bool py_pickle_loads_body(const unsigned char* p, int memo_length, c11_smallmap_
             case PKL_OBJECT: {
                 py_Type type = (py_Type)pkl__read_int(&p);
                 type = pkl__fix_type(type, type_mapping);
-                py_newobject(py_retval(), type, -1, 0);
-                NameDict* dict = PyObject__dict(py_retval()->_obj);
+                if(!pk__type_info(type)->is_python) return ValueError("invalid pickle data");
+                pk__newinstance(py_retval(), type);
+                InstanceDict* dict = PyObject__instancedict(py_retval()->_obj);
                 int dict_length = pkl__read_int(&p);
                 for(int i = 0; i < dict_length; i++) {
                     py_StackRef value = py_peek(-1);
                     c11_sv field = {(const char*)p, strlen((const char*)p)};
-                    NameDict__set(dict, py_namev(field), *value);
+                    InstanceDict__set(dict, py_namev(field), *value);
                     py_pop();
                     p += field.size + 1;
                 }
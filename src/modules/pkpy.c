@@ -48,7 +48,11 @@ static bool pkpy_memory_usage(int argc, py_Ref argv) {
     pk_sprintf(&buf, "len(large_objects)=%d\n", large_object_count);
     c11_sbuf__write_cstr(&buf, "== heap.gc ==\n");
     pk_sprintf(&buf, "gc_counter=%d\n", heap->gc_counter);
-    pk_sprintf(&buf, "gc_threshold=%d", heap->gc_threshold);
+    pk_sprintf(&buf, "gc_threshold=%d\n", heap->gc_threshold);
+    pk_sprintf(&buf, "len(young_objects)=%d\n", heap->young_objects.length);
+    pk_sprintf(&buf, "len(remembered)=%d\n", heap->remembered.length);
+    pk_sprintf(&buf, "old_count=%d\n", heap->old_count);
+    pk_sprintf(&buf, "old_threshold=%d", heap->old_threshold);
     // c11_sbuf__write_cstr(&buf, "== vm.pool_frame ==\n");
     c11_sbuf__py_submit(&buf, py_retval());
     c11_string__delete(small_objects_usage);
@@ -0,0 +1,33 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/sstream.h"
+
+static bool py_compile_compile(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(3);
+    PY_CHECK_ARG_TYPE(0, tp_str);
+    c11_sv file = py_tosv(py_arg(0));
+    if(py_isnone(py_arg(1))) {
+        // `x.py` -> `x.pkc`
+        if(c11_sv__endswith(file, (c11_sv){".py", 3})) file.size -= 3;
+        c11_sbuf buf;
+        c11_sbuf__ctor(&buf);
+        c11_sbuf__write_sv(&buf, file);
+        c11_sbuf__write_cstr(&buf, ".pkc");
+        c11_sbuf__py_submit(&buf, py_arg(1));
+    }
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    const char* dfile = NULL;
+    if(!py_isnone(py_arg(2))) {
+        PY_CHECK_ARG_TYPE(2, tp_str);
+        dfile = py_tostr(py_arg(2));
+    }
+    if(!py_compilefile(py_tostr(py_arg(0)), py_tostr(py_arg(1)), dfile)) return false;
+    py_assign(py_retval(), py_arg(1));
+    return true;
+}
+
+void pk__add_module_py_compile() {
+    py_Ref mod = py_newmodule("py_compile");
+
+    py_bind(mod, "compile(file, cfile=None, dfile=None)", py_compile_compile);
+}
@@ -60,7 +60,15 @@ static bool time_localtime(int argc, py_Ref argv) {
     assert(tp_struct_time);
     struct tm* ud = py_newobject(py_retval(), tp_struct_time, 0, sizeof(struct tm));
     time_t t = time(NULL);
+    // `localtime()` returns a static buffer shared by all threads
+#if defined(_WIN32)
+    localtime_s(ud, &t);
+#elif defined(_POSIX_C_SOURCE) || defined(__APPLE__)
+    localtime_r(&t, ud);
+#else
+    /* The C11 way, `localtime_r()` is not declared by a strict `-std=c11` build */
     *ud = *localtime(&t);
+#endif
     return true;
 }
 
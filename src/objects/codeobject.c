@@ -123,7 +123,7 @@ void CodeObject__ctor(CodeObject* self, SourceData_ src, c11_sv name) {
     c11_vector__ctor(&self->codes_ex, sizeof(BytecodeEx));
 
     c11_vector__ctor(&self->consts, sizeof(py_TValue));
-    c11_vector__ctor(&self->varnames, sizeof(uint16_t));
+    c11_vector__ctor(&self->varnames, sizeof(py_Name));
     self->nlocals = 0;
 
     c11_smallmap_n2i__ctor(&self->varnames_inv);
@@ -131,6 +131,9 @@ void CodeObject__ctor(CodeObject* self, SourceData_ src, c11_sv name) {
     c11_vector__ctor(&self->blocks, sizeof(CodeBlock));
     c11_vector__ctor(&self->func_decls, sizeof(FuncDecl_));
 
+    c11_vector__ctor(&self->attr_caches, sizeof(AttrCache));
+    c11_vector__ctor(&self->global_caches, sizeof(GlobalCache));
+
     self->start_line = -1;
     self->end_line = -1;
 
@@ -157,6 +160,9 @@ void CodeObject__dtor(CodeObject* self) {
         PK_DECREF(decl);
     }
     c11_vector__dtor(&self->func_decls);
+
+    c11_vector__dtor(&self->attr_caches);
+    c11_vector__dtor(&self->global_caches);
 }
 
 void Function__ctor(Function* self, FuncDecl_ decl, py_TValue* module) {
@@ -171,13 +177,43 @@ void Function__ctor(Function* self, FuncDecl_ decl, py_TValue* module) {
 int CodeObject__add_varname(CodeObject* self, py_Name name) {
     int index = c11_smallmap_n2i__get(&self->varnames_inv, name, -1);
     if(index >= 0) return index;
-    c11_vector__push(uint16_t, &self->varnames, name);
+    c11_vector__push(py_Name, &self->varnames, name);
     self->nlocals++;
     index = self->varnames.length - 1;
     c11_smallmap_n2i__set(&self->varnames_inv, name, index);
     return index;
 }
 
+void CodeObject__init_caches(CodeObject* self) {
+    c11_vector__clear(&self->attr_caches);
+    c11_vector__clear(&self->global_caches);
+    for(int i = 0; i < self->codes.length; i++) {
+        Bytecode bc = c11__getitem(Bytecode, &self->codes, i);
+        BytecodeEx* ex = c11__at(BytecodeEx, &self->codes_ex, i);
+        ex->icache = -1;
+        switch(bc.op) {
+            case OP_LOAD_ATTR:
+            case OP_LOAD_METHOD:
+            case OP_STORE_ATTR: {
+                // magic slots can be written without going through `py_setdict`
+                if(py_ismagicname(bc.arg)) break;
+                ex->icache = self->attr_caches.length;
+                AttrCache* ic = c11_vector__emplace(&self->attr_caches);
+                memset(ic, 0, sizeof(AttrCache));
+                break;
+            }
+            case OP_LOAD_GLOBAL:
+            case OP_LOAD_NONLOCAL: {
+                ex->icache = self->global_caches.length;
+                GlobalCache* ic = c11_vector__emplace(&self->global_caches);
+                memset(ic, 0, sizeof(GlobalCache));
+                break;
+            }
+            default: break;
+        }
+    }
+}
+
 void Function__dtor(Function* self) {
     // printf("%s() in %s freed!\n", self->decl->code.name->data,
     // self->decl->code.src->filename->data);
@@ -0,0 +1,452 @@
+#include "pocketpy/objects/codeobject.h"
+#include "pocketpy/common/utils.h"
+#include "pocketpy/objects/object.h"
+#include "pocketpy/pocketpy.h"
+#include <stdint.h>
+
+// bump when the layout of the blob or the meaning of an opcode changes
+#define kCodeFormatVersion 2
+#define kCodeMagic "PKC\x1A"
+
+typedef enum {
+    CodeConst_NIL,
+    CodeConst_NONE,
+    CodeConst_ELLIPSIS,
+    CodeConst_TRUE,
+    CodeConst_FALSE,
+    CodeConst_INT,
+    CodeConst_FLOAT,
+    CodeConst_STR,
+    CodeConst_TUPLE,
+} CodeConst;
+
+static bool Opcode__has_name_arg(Opcode op) {
+    switch(op) {
+        case OP_LOAD_KEYWORD:
+        case OP_LOAD_NAME:
+        case OP_LOAD_NONLOCAL:
+        case OP_LOAD_GLOBAL:
+        case OP_LOAD_ATTR:
+        case OP_LOAD_CLASS_GLOBAL:
+        case OP_LOAD_METHOD:
+        case OP_STORE_NAME:
+        case OP_STORE_GLOBAL:
+        case OP_STORE_ATTR:
+        case OP_DELETE_NAME:
+        case OP_DELETE_GLOBAL:
+        case OP_DELETE_ATTR:
+        case OP_BEGIN_CLASS:
+        case OP_END_CLASS:
+        case OP_STORE_CLASS_ATTR:
+        case OP_ADD_CLASS_ANNOTATION: return true;
+        default: return false;
+    }
+}
+
+/// 64-bit FNV-1a of a string, used to detect stale blobs.
+static uint64_t CodeObject__hash64(const char* data) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for(const unsigned char* p = (const unsigned char*)data; *p; p++) {
+        hash = (hash ^ *p) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// opcodes and magic names are emitted as fixed ids, a blob only runs if they are unchanged
+static const char kCodeIds[] =
+#define OPCODE(name) #name ","
+#include "pocketpy/xmacros/opcodes.h"
+#undef OPCODE
+#define MAGIC_METHOD(name) #name ","
+#include "pocketpy/xmacros/magics.h"
+#undef MAGIC_METHOD
+    ;
+
+/* Writer */
+
+typedef struct CodeWriter {
+    c11_vector /*T=char*/ body;
+    c11_vector /*T=py_Name*/ names;  // 1-based indices in the blob, 0 is kept for `BC_NOARG`
+    c11_smallmap_n2i names_inv;
+} CodeWriter;
+
+static void CodeWriter__write(c11_vector* buf, const void* data, int size) {
+    c11_vector__extend(char, buf, data, size);
+}
+
+static void CodeWriter__write_u8(c11_vector* buf, uint8_t val) { c11_vector__push(char, buf, val); }
+
+static void CodeWriter__write_i32(c11_vector* buf, int32_t val) {
+    CodeWriter__write(buf, &val, sizeof(val));
+}
+
+static void CodeWriter__write_sv(c11_vector* buf, c11_sv sv) {
+    CodeWriter__write_i32(buf, sv.size);
+    CodeWriter__write(buf, sv.data, sv.size);
+}
+
+static uint32_t CodeWriter__name(CodeWriter* self, py_Name name) {
+    if(name == 0) return 0;
+    int index = c11_smallmap_n2i__get(&self->names_inv, name, -1);
+    if(index >= 0) return index;
+    c11_vector__push(py_Name, &self->names, name);
+    index = self->names.length;
+    c11_smallmap_n2i__set(&self->names_inv, name, index);
+    return index;
+}
+
+static void CodeWriter__write_const(CodeWriter* self, py_TValue* val) {
+    c11_vector* buf = &self->body;
+    switch(val->type) {
+        case tp_nil: CodeWriter__write_u8(buf, CodeConst_NIL); break;
+        case tp_NoneType: CodeWriter__write_u8(buf, CodeConst_NONE); break;
+        case tp_ellipsis: CodeWriter__write_u8(buf, CodeConst_ELLIPSIS); break;
+        case tp_bool:
+            CodeWriter__write_u8(buf, val->_bool ? CodeConst_TRUE : CodeConst_FALSE);
+            break;
+        case tp_int:
+            CodeWriter__write_u8(buf, CodeConst_INT);
+            CodeWriter__write(buf, &val->_i64, sizeof(int64_t));
+            break;
+        case tp_float:
+            CodeWriter__write_u8(buf, CodeConst_FLOAT);
+            CodeWriter__write(buf, &val->_f64, sizeof(double));
+            break;
+        case tp_str:
+            CodeWriter__write_u8(buf, CodeConst_STR);
+            CodeWriter__write_sv(buf, py_tosv(val));
+            break;
+        case tp_tuple: {
+            int length = py_tuple_len(val);
+            CodeWriter__write_u8(buf, CodeConst_TUPLE);
+            CodeWriter__write_i32(buf, length);
+            for(int i = 0; i < length; i++) {
+                CodeWriter__write_const(self, py_tuple_getitem(val, i));
+            }
+            break;
+        }
+        default: c11__abort("CodeWriter__write_const(): unexpected constant type %d", val->type);
+    }
+}
+
+static void CodeWriter__write_code(CodeWriter* self, const CodeObject* co);
+
+static void CodeWriter__write_decl(CodeWriter* self, const FuncDecl* decl) {
+    c11_vector* buf = &self->body;
+    CodeWriter__write_code(self, &decl->code);
+    CodeWriter__write_i32(buf, decl->args.length);
+    c11__foreach(int, &decl->args, it) CodeWriter__write_i32(buf, *it);
+    CodeWriter__write_i32(buf, decl->kwargs.length);
+    c11__foreach(FuncDeclKwArg, &decl->kwargs, kv) {
+        CodeWriter__write_i32(buf, kv->index);
+        CodeWriter__write_i32(buf, CodeWriter__name(self, kv->key));
+        CodeWriter__write_const(self, &kv->value);
+    }
+    CodeWriter__write_i32(buf, decl->starred_arg);
+    CodeWriter__write_i32(buf, decl->starred_kwarg);
+    CodeWriter__write_u8(buf, decl->nested);
+    CodeWriter__write_u8(buf, decl->type);
+    // the docstring points into the consts of its own code
+    int docstring = -1;
+    for(int i = 0; i < decl->code.consts.length; i++) {
+        py_TValue* c = c11__at(py_TValue, &decl->code.consts, i);
+        if(decl->docstring && py_isstr(c) && py_tostr(c) == decl->docstring) docstring = i;
+    }
+    CodeWriter__write_i32(buf, docstring);
+}
+
+static void CodeWriter__write_code(CodeWriter* self, const CodeObject* co) {
+    c11_vector* buf = &self->body;
+    CodeWriter__write_sv(buf, c11_string__sv(co->name));
+    CodeWriter__write_i32(buf, co->start_line);
+    CodeWriter__write_i32(buf, co->end_line);
+
+    CodeWriter__write_i32(buf, co->codes.length);
+    for(int i = 0; i < co->codes.length; i++) {
+        Bytecode bc = c11__getitem(Bytecode, &co->codes, i);
+        uint32_t arg = Opcode__has_name_arg(bc.op) ? CodeWriter__name(self, bc.arg) : bc.arg;
+        CodeWriter__write_i32(buf, (int32_t)(bc.op | (arg << 8)));
+        BytecodeEx* ex = c11__at(BytecodeEx, &co->codes_ex, i);
+        CodeWriter__write_i32(buf, ex->lineno);
+        CodeWriter__write_i32(buf, ex->iblock);
+        CodeWriter__write_u8(buf, ex->is_virtual);
+    }
+
+    CodeWriter__write_i32(buf, co->consts.length);
+    c11__foreach(py_TValue, &co->consts, it) CodeWriter__write_const(self, it);
+
+    CodeWriter__write_i32(buf, co->varnames.length);
+    c11__foreach(py_Name, &co->varnames, it) {
+        CodeWriter__write_i32(buf, CodeWriter__name(self, *it));
+    }
+
+    CodeWriter__write_i32(buf, co->blocks.length);
+    c11__foreach(CodeBlock, &co->blocks, it) {
+        CodeWriter__write_u8(buf, it->type);
+        CodeWriter__write_i32(buf, it->parent);
+        CodeWriter__write_i32(buf, it->start);
+        CodeWriter__write_i32(buf, it->end);
+        CodeWriter__write_i32(buf, it->end2);
+    }
+
+    CodeWriter__write_i32(buf, co->func_decls.length);
+    c11__foreach(FuncDecl_, &co->func_decls, it) CodeWriter__write_decl(self, *it);
+}
+
+void CodeObject__dumps(const CodeObject* self, const char* source, c11_vector* out) {
+    CodeWriter w;
+    c11_vector__ctor(&w.body, sizeof(char));
+    c11_vector__ctor(&w.names, sizeof(py_Name));
+    c11_smallmap_n2i__ctor(&w.names_inv);
+    CodeWriter__write_code(&w, self);
+
+    // header
+    CodeWriter__write(out, kCodeMagic, 4);
+    CodeWriter__write_i32(out, kCodeFormatVersion);
+    uint64_t hash = CodeObject__hash64(kCodeIds);
+    CodeWriter__write(out, &hash, sizeof(hash));
+    hash = CodeObject__hash64(source);
+    CodeWriter__write(out, &hash, sizeof(hash));
+    CodeWriter__write_u8(out, self->src->mode);
+    CodeWriter__write_sv(out, c11_string__sv(self->src->filename));
+    // names
+    CodeWriter__write_i32(out, w.names.length);
+    c11__foreach(py_Name, &w.names, it) CodeWriter__write_sv(out, py_name2sv(*it));
+    // body
+    CodeWriter__write(out, w.body.data, w.body.length);
+
+    c11_vector__dtor(&w.body);
+    c11_vector__dtor(&w.names);
+    c11_smallmap_n2i__dtor(&w.names_inv);
+}
+
+/* Reader */
+
+// A blob is trusted as much as a source file. The checks below only reject truncated,
+// stale or foreign data, they do not verify the bytecode itself.
+typedef struct CodeReader {
+    const unsigned char* p;
+    const unsigned char* end;
+    const char* error;  // the first error, reads return zeros after it
+    py_Name* names;     // blob index -> `py_Name`, index 0 is `BC_NOARG`
+    int names_length;
+    SourceData_ src;
+} CodeReader;
+
+static bool CodeReader__read(CodeReader* self, void* out, int size) {
+    if(self->error == NULL && self->end - self->p < size) self->error = "unexpected end of data";
+    if(self->error) {
+        memset(out, 0, size);
+        return false;
+    }
+    memcpy(out, self->p, size);
+    self->p += size;
+    return true;
+}
+
+static uint8_t CodeReader__read_u8(CodeReader* self) {
+    uint8_t val;
+    CodeReader__read(self, &val, sizeof(val));
+    return val;
+}
+
+static int32_t CodeReader__read_i32(CodeReader* self) {
+    int32_t val;
+    CodeReader__read(self, &val, sizeof(val));
+    return val;
+}
+
+/// Read a length, which is also checked against the remaining data.
+static int CodeReader__read_length(CodeReader* self, int min_item_size) {
+    int32_t length = CodeReader__read_i32(self);
+    if(self->error) return 0;
+    if(length < 0 || (int64_t)length * min_item_size > self->end - self->p) {
+        self->error = "bad length";
+        return 0;
+    }
+    return length;
+}
+
+static c11_sv CodeReader__read_sv(CodeReader* self) {
+    int size = CodeReader__read_length(self, 1);
+    c11_sv sv = {(const char*)self->p, size};
+    self->p += size;
+    return sv;
+}
+
+static py_Name CodeReader__read_name(CodeReader* self, uint32_t index) {
+    if(index > (uint32_t)self->names_length) {
+        if(!self->error) self->error = "bad name index";
+        return 0;
+    }
+    return self->names[index];
+}
+
+static void CodeReader__read_const(CodeReader* self, py_OutRef out) {
+    switch(CodeReader__read_u8(self)) {
+        case CodeConst_NIL: py_newnil(out); break;
+        case CodeConst_NONE: py_newnone(out); break;
+        case CodeConst_ELLIPSIS: py_newellipsis(out); break;
+        case CodeConst_TRUE: py_newbool(out, true); break;
+        case CodeConst_FALSE: py_newbool(out, false); break;
+        case CodeConst_INT: {
+            int64_t val;
+            CodeReader__read(self, &val, sizeof(val));
+            py_newint(out, val);
+            break;
+        }
+        case CodeConst_FLOAT: {
+            double val;
+            CodeReader__read(self, &val, sizeof(val));
+            py_newfloat(out, val);
+            break;
+        }
+        case CodeConst_STR: {
+            py_newstrv(out, CodeReader__read_sv(self));
+            // constants are likely dict keys, their hashes are computed once here
+            c11_string__hash(PyObject__userdata(out->_obj));
+            break;
+        }
+        case CodeConst_TUPLE: {
+            int length = CodeReader__read_length(self, 1);
+            py_newtuple(out, length);
+            for(int i = 0; i < length; i++) {
+                CodeReader__read_const(self, py_tuple_getitem(out, i));
+            }
+            break;
+        }
+        default:
+            py_newnil(out);
+            if(!self->error) self->error = "bad constant";
+            break;
+    }
+}
+
+static void CodeReader__read_code(CodeReader* self, CodeObject* co);
+
+static FuncDecl_ CodeReader__read_decl(CodeReader* self) {
+    FuncDecl_ decl = FuncDecl__rcnew(self->src, (c11_sv){"", 0});
+    CodeReader__read_code(self, &decl->code);
+    int length = CodeReader__read_length(self, 4);
+    for(int i = 0; i < length; i++) {
+        c11_vector__push(int, &decl->args, CodeReader__read_i32(self));
+    }
+    length = CodeReader__read_length(self, 9);
+    for(int i = 0; i < length; i++) {
+        FuncDeclKwArg* kv = c11_vector__emplace(&decl->kwargs);
+        kv->index = CodeReader__read_i32(self);
+        kv->key = CodeReader__read_name(self, CodeReader__read_i32(self));
+        CodeReader__read_const(self, &kv->value);
+        c11_smallmap_n2i__set(&decl->kw_to_index, kv->key, kv->index);
+    }
+    decl->starred_arg = CodeReader__read_i32(self);
+    decl->starred_kwarg = CodeReader__read_i32(self);
+    decl->nested = CodeReader__read_u8(self);
+    decl->type = (FuncType)CodeReader__read_u8(self);
+    int docstring = CodeReader__read_i32(self);
+    if(docstring >= 0 && docstring < decl->code.consts.length) {
+        py_TValue* c = c11__at(py_TValue, &decl->code.consts, docstring);
+        if(py_isstr(c)) decl->docstring = py_tostr(c);
+    }
+    return decl;
+}
+
+static void CodeReader__read_code(CodeReader* self, CodeObject* co) {
+    c11_sv name = CodeReader__read_sv(self);
+    c11_string__delete(co->name);
+    co->name = c11_string__new2(name.data, name.size);
+    co->start_line = CodeReader__read_i32(self);
+    co->end_line = CodeReader__read_i32(self);
+
+    int length = CodeReader__read_length(self, 13);
+    c11_vector__reserve(&co->codes, length);
+    c11_vector__reserve(&co->codes_ex, length);
+    for(int i = 0; i < length; i++) {
+        uint32_t word = (uint32_t)CodeReader__read_i32(self);
+        Bytecode bc = {.op = word & 0xFF, .arg = word >> 8};
+        if(bc.op >= kOpcodeCount) {
+            if(!self->error) self->error = "bad opcode";
+            bc.op = OP_NO_OP;
+        }
+        if(Opcode__has_name_arg(bc.op)) bc.arg = CodeReader__read_name(self, bc.arg);
+        c11_vector__push(Bytecode, &co->codes, bc);
+        BytecodeEx* ex = c11_vector__emplace(&co->codes_ex);
+        ex->lineno = CodeReader__read_i32(self);
+        ex->iblock = CodeReader__read_i32(self);
+        ex->is_virtual = CodeReader__read_u8(self);
+        ex->icache = -1;
+    }
+
+    length = CodeReader__read_length(self, 1);
+    c11_vector__reserve(&co->consts, length);
+    for(int i = 0; i < length; i++) {
+        CodeReader__read_const(self, c11_vector__emplace(&co->consts));
+    }
+
+    length = CodeReader__read_length(self, 4);
+    for(int i = 0; i < length; i++) {
+        py_Name name = CodeReader__read_name(self, CodeReader__read_i32(self));
+        if(name) CodeObject__add_varname(co, name);
+    }
+
+    length = CodeReader__read_length(self, 17);
+    c11_vector__clear(&co->blocks);
+    for(int i = 0; i < length; i++) {
+        CodeBlock* block = c11_vector__emplace(&co->blocks);
+        block->type = (CodeBlockType)CodeReader__read_u8(self);
+        block->parent = CodeReader__read_i32(self);
+        block->start = CodeReader__read_i32(self);
+        block->end = CodeReader__read_i32(self);
+        block->end2 = CodeReader__read_i32(self);
+    }
+
+    length = CodeReader__read_length(self, 1);
+    for(int i = 0; i < length && !self->error; i++) {
+        c11_vector__push(FuncDecl_, &co->func_decls, CodeReader__read_decl(self));
+    }
+
+    CodeObject__init_caches(co);
+}
+
+const char* CodeObject__loads(CodeObject* out, const char* data, int size, const char* source) {
+    CodeReader r = {0};
+    r.p = (const unsigned char*)data;
+    r.end = r.p + size;
+    char magic[4];
+    CodeReader__read(&r, magic, 4);
+    if(r.error || memcmp(magic, kCodeMagic, 4) != 0) return "not a code blob";
+    int32_t version = CodeReader__read_i32(&r);
+    uint64_t ids_hash, hash;
+    CodeReader__read(&r, &ids_hash, sizeof(ids_hash));
+    CodeReader__read(&r, &hash, sizeof(hash));
+    enum py_CompileMode mode = (enum py_CompileMode)CodeReader__read_u8(&r);
+    c11_sv filename = CodeReader__read_sv(&r);
+    if(r.error) return r.error;
+    if(version != kCodeFormatVersion) return "incompatible format version";
+    if(ids_hash != CodeObject__hash64(kCodeIds)) return "incompatible opcodes";
+    if(source && hash != CodeObject__hash64(source)) return "source changed";
+
+    r.names_length = CodeReader__read_length(&r, 4);
+    r.names = PK_MALLOC(sizeof(py_Name) * (r.names_length + 1));
+    r.names[0] = 0;
+    for(int i = 1; i <= r.names_length; i++) {
+        c11_sv name = CodeReader__read_sv(&r);
+        r.names[i] = name.size > 0 ? py_namev(name) : 0;
+    }
+
+    c11_string* filename_str = c11_string__new2(filename.data, filename.size);
+    r.src = SourceData__rcnew(source ? source : "", filename_str->data, mode, false);
+    c11_string__delete(filename_str);
+    // the lexer is skipped, so line starts are indexed here for tracebacks
+    for(const char* p = r.src->source->data; *p; p++) {
+        if(*p == '\n') c11_vector__push(const char*, &r.src->line_starts, p + 1);
+    }
+
+    CodeObject__ctor(out, r.src, (c11_sv){"", 0});
+    CodeReader__read_code(&r, out);
+    PK_DECREF(r.src);
+    PK_FREE(r.names);
+    if(r.error == NULL && r.p != r.end) r.error = "trailing data";
+    if(r.error) CodeObject__dtor(out);
+    return r.error;
+}
@@ -0,0 +1,299 @@
+#include "pocketpy/objects/dict.h"
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/str.h"
+#include "pocketpy/objects/object.h"
+#include "pocketpy/pocketpy.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PK_DICT_SSE2 1
+#else
+#define PK_DICT_SSE2 0
+#endif
+
+#define kCtrlEmpty 0x80
+#define kCtrlDeleted 0xFE  // full slots have the high bit cleared
+
+/// Bit `i` is set if the control byte of slot `i` in the group equals `h2`.
+static uint32_t DictGroup__match(const uint8_t* ctrl, uint8_t h2) {
+#if PK_DICT_SSE2
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+#else
+    uint32_t mask = 0;
+    for(int i = 0; i < kDictGroupSize; i++) {
+        mask |= (uint32_t)(ctrl[i] == h2) << i;
+    }
+    return mask;
+#endif
+}
+
+/// Bit `i` is set if slot `i` in the group is empty or deleted.
+static uint32_t DictGroup__match_free(const uint8_t* ctrl) {
+#if PK_DICT_SSE2
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    uint32_t mask = 0;
+    for(int i = 0; i < kDictGroupSize; i++) {
+        mask |= (uint32_t)(ctrl[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+static int Dict__ctz(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(x);
+#else
+    int n = 0;
+    while(!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/// Hash of `key`, with inline paths for `int` and `str`.
+static bool Dict__hash(py_TValue* key, uint64_t* out) {
+    switch(key->type) {
+        case tp_int: *out = (uint64_t)key->_i64; return true;
+        case tp_str: *out = c11_string__hash(PyObject__userdata(key->_obj)); return true;
+        default: {
+            py_i64 hash;
+            if(!py_hash(key, &hash)) return false;
+            *out = (uint64_t)hash;
+            return true;
+        }
+    }
+}
+
+/// `1` if the keys are equal, `0` if not, `-1` on error.
+static int Dict__equal(py_TValue* a, py_TValue* b) {
+    if(a->type == b->type) {
+        switch(a->type) {
+            case tp_int: return a->_i64 == b->_i64;
+            case tp_str:
+                return c11_string__eq(PyObject__userdata(a->_obj), PyObject__userdata(b->_obj));
+            default: break;
+        }
+    }
+    return py_equal(a, b);
+}
+
+/// Spread the bits of `hash`, since int keys hash to themselves.
+static uint64_t Dict__mix(uint64_t hash) { return hash * 0x9E3779B97F4A7C15ull; }
+
+#define Dict__h1(mixed) ((uint32_t)((mixed) >> 7))
+#define Dict__h2(mixed) ((uint8_t)((mixed) >> 57))
+
+static void Dict__alloc_table(Dict* self, uint32_t capacity) {
+    self->capacity = capacity;
+    self->used = 0;
+    // one allocation for both arrays
+    self->ctrl = PK_MALLOC(capacity * (sizeof(uint8_t) + sizeof(int)));
+    self->indices = (int*)(self->ctrl + capacity);
+    memset(self->ctrl, kCtrlEmpty, capacity);
+}
+
+void Dict__ctor(Dict* self, uint32_t capacity, int entries_capacity) {
+    self->length = 0;
+    Dict__alloc_table(self, c11__max(capacity, kDictGroupSize));
+    c11_vector__ctor(&self->entries, sizeof(DictEntry));
+    c11_vector__reserve(&self->entries, entries_capacity);
+}
+
+void Dict__dtor(Dict* self) {
+    self->length = 0;
+    self->capacity = 0;
+    PK_FREE(self->ctrl);
+    c11_vector__dtor(&self->entries);
+}
+
+void Dict__copy(Dict* self, const Dict* other) {
+    self->length = other->length;
+    Dict__alloc_table(self, other->capacity);
+    self->used = other->used;
+    memcpy(self->ctrl, other->ctrl, other->capacity * (sizeof(uint8_t) + sizeof(int)));
+    self->entries = c11_vector__copy(&other->entries);
+}
+
+/// Find the slot of `key`. Returns `-1` on error, `0` if not found, `1` if found.
+static int Dict__find(Dict* self, py_TValue* key, uint64_t hash, uint32_t* out) {
+    uint64_t mixed = Dict__mix(hash);
+    uint8_t h2 = Dict__h2(mixed);
+    uint32_t group_mask = self->capacity / kDictGroupSize - 1;
+    uint32_t group = Dict__h1(mixed) & group_mask;
+    // triangular probing visits every group once
+    for(uint32_t step = 1;; step++) {
+        const uint8_t* ctrl = self->ctrl + group * kDictGroupSize;
+        for(uint32_t match = DictGroup__match(ctrl, h2); match; match &= match - 1) {
+            uint32_t slot = group * kDictGroupSize + Dict__ctz(match);
+            DictEntry* entry = c11__at(DictEntry, &self->entries, self->indices[slot]);
+            if(entry->hash != hash) continue;
+            int res = Dict__equal(&entry->key, key);
+            if(res == 1) {
+                *out = slot;
+                return 1;
+            }
+            if(res == -1) return -1;
+        }
+        // a group with an empty slot ends the probe sequence
+        if(DictGroup__match(ctrl, kCtrlEmpty)) return 0;
+        group = (group + step) & group_mask;
+    }
+}
+
+/// The first empty or deleted slot in the probe sequence of `hash`.
+static uint32_t Dict__find_free(Dict* self, uint64_t hash) {
+    uint64_t mixed = Dict__mix(hash);
+    uint32_t group_mask = self->capacity / kDictGroupSize - 1;
+    uint32_t group = Dict__h1(mixed) & group_mask;
+    for(uint32_t step = 1;; step++) {
+        uint32_t match = DictGroup__match_free(self->ctrl + group * kDictGroupSize);
+        if(match) return group * kDictGroupSize + Dict__ctz(match);
+        group = (group + step) & group_mask;
+    }
+}
+
+static void Dict__set_slot(Dict* self, uint32_t slot, uint64_t hash, int index) {
+    if(self->ctrl[slot] == kCtrlEmpty) self->used++;
+    self->ctrl[slot] = Dict__h2(Dict__mix(hash));
+    self->indices[slot] = index;
+}
+
+bool Dict__try_get(Dict* self, py_TValue* key, DictEntry** out) {
+    uint64_t hash;
+    if(!Dict__hash(key, &hash)) return false;
+    uint32_t slot;
+    int res = Dict__find(self, key, hash, &slot);
+    if(res == -1) return false;
+    *out = res ? c11__at(DictEntry, &self->entries, self->indices[slot]) : NULL;
+    return true;
+}
+
+void Dict__clear(Dict* self) {
+    memset(self->ctrl, kCtrlEmpty, self->capacity);
+    self->used = 0;
+    c11_vector__clear(&self->entries);
+    self->length = 0;
+}
+
+/// Drop the deleted entries and rebuild the table with `capacity` slots.
+static void Dict__rehash(Dict* self, uint32_t capacity) {
+    int n = 0;
+    for(int i = 0; i < self->entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+        if(py_isnil(&entry->key)) continue;
+        if(i != n) *c11__at(DictEntry, &self->entries, n) = *entry;
+        n++;
+    }
+    self->entries.length = n;
+    PK_FREE(self->ctrl);
+    Dict__alloc_table(self, capacity);
+    for(int i = 0; i < n; i++) {
+        uint64_t hash = c11__at(DictEntry, &self->entries, i)->hash;
+        Dict__set_slot(self, Dict__find_free(self, hash), hash, i);
+    }
+}
+
+bool Dict__rehash_keys(Dict* self, py_Type* failed) {
+    bool changed = false;
+    c11__foreach(DictEntry, &self->entries, entry) {
+        // the hash of an object may depend on its address
+        if(!entry->key.is_ptr || entry->key.type == tp_str) continue;
+        if(!Dict__hash(&entry->key, &entry->hash)) {
+            *failed = entry->key.type;
+            return false;
+        }
+        changed = true;
+    }
+    if(changed) Dict__rehash(self, self->capacity);
+    return true;
+}
+
+static void Dict__compact_entries(Dict* self) {
+    int* mappings = PK_MALLOC(self->entries.length * sizeof(int));
+
+    int n = 0;
+    for(int i = 0; i < self->entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+        if(py_isnil(&entry->key)) continue;
+        mappings[i] = n;
+        if(i != n) {
+            DictEntry* new_entry = c11__at(DictEntry, &self->entries, n);
+            *new_entry = *entry;
+        }
+        n++;
+    }
+    self->entries.length = n;
+    // update indices
+    for(uint32_t i = 0; i < self->capacity; i++) {
+        if(self->ctrl[i] & 0x80) continue;
+        self->indices[i] = mappings[self->indices[i]];
+    }
+    PK_FREE(mappings);
+}
+
+bool Dict__set(Dict* self, py_TValue* key, py_TValue* val) {
+    uint64_t hash;
+    if(!Dict__hash(key, &hash)) return false;
+    uint32_t slot;
+    int res = Dict__find(self, key, hash, &slot);
+    if(res == -1) return false;
+    if(res == 1) {
+        // update existing entry
+        c11__at(DictEntry, &self->entries, self->indices[slot])->val = *val;
+        return true;
+    }
+    // keep the load factor, including deleted slots, below 7/8
+    if((self->used + 1) * 8 > self->capacity * 7) {
+        // rehash in place if most of the used slots are deleted ones
+        bool grow = (uint32_t)(self->length + 1) * 16 > self->capacity * 7;
+        Dict__rehash(self, grow ? self->capacity * 2 : self->capacity);
+    }
+    slot = Dict__find_free(self, hash);
+    DictEntry* new_entry = c11_vector__emplace(&self->entries);
+    new_entry->hash = hash;
+    new_entry->key = *key;
+    new_entry->val = *val;
+    Dict__set_slot(self, slot, hash, self->entries.length - 1);
+    self->length++;
+    return true;
+}
+
+int Dict__pop(Dict* self, py_TValue* key) {
+    uint64_t hash;
+    if(!Dict__hash(key, &hash)) return -1;
+    uint32_t slot;
+    int res = Dict__find(self, key, hash, &slot);
+    if(res != 1) return res;
+    DictEntry* entry = c11__at(DictEntry, &self->entries, self->indices[slot]);
+    *py_retval() = entry->val;
+    py_newnil(&entry->key);
+    // no probe sequence passes a group which still has an empty slot
+    const uint8_t* group = self->ctrl + slot / kDictGroupSize * kDictGroupSize;
+    if(DictGroup__match(group, kCtrlEmpty)) {
+        self->ctrl[slot] = kCtrlEmpty;
+        self->used--;
+    } else {
+        self->ctrl[slot] = kCtrlDeleted;
+    }
+    self->length--;
+    if(self->length < self->entries.length / 2) Dict__compact_entries(self);
+    return 1;
+}
+
+void DictIterator__ctor(DictIterator* self, Dict* dict) {
+    self->curr = dict->entries.data;
+    self->end = self->curr + dict->entries.length;
+}
+
+DictEntry* DictIterator__next(DictIterator* self) {
+    DictEntry* retval;
+    do {
+        if(self->curr == self->end) return NULL;
+        retval = self->curr++;
+    } while(py_isnil(&retval->key));
+    return retval;
+}
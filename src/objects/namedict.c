@@ -1,8 +1,9 @@
 #include "pocketpy/objects/namedict.h"
 #include "pocketpy/objects/object.h"
+#include "pocketpy/interpreter/vm.h"
 
 #define SMALLMAP_T__SOURCE
-#define K uint16_t
+#define K py_Name
 #define V py_TValue
 #define NAME NameDict
 #include "pocketpy/xmacros/smallmap.h"
@@ -76,7 +77,7 @@ bool ModuleDict__contains(ModuleDict* self, const char* path) {
 }
 
 void ModuleDict__apply_mark(ModuleDict *self) {
-    if(!self->module._obj->gc_marked) PyObject__mark(self->module._obj);
+    if(!pk__is_marked(self->module._obj)) PyObject__mark(self->module._obj);
     if(self->left) ModuleDict__apply_mark(self->left);
     if(self->right) ModuleDict__apply_mark(self->right);
 }
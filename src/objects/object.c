@@ -9,6 +9,11 @@ NameDict* PyObject__dict(PyObject* self) {
     return (NameDict*)(self->flex);
 }
 
+InstanceDict* PyObject__instancedict(PyObject* self) {
+    assert(self->slots <= -2);
+    return (InstanceDict*)(self->flex);
+}
+
 py_TValue* PyObject__slots(PyObject* self) {
     assert(self->slots >= 0);
     return (py_TValue*)(self->flex);
@@ -0,0 +1,144 @@
+#include "pocketpy/objects/shape.h"
+#include "pocketpy/common/utils.h"
+#include "pocketpy/pocketpy.h"
+
+InstanceShape* InstanceShape__new(InstanceShape* parent, py_Name name) {
+    InstanceShape* self = PK_MALLOC(sizeof(InstanceShape));
+    self->parent = parent;
+    self->name = name;
+    self->max_length = 0;
+    c11_vector__ctor(&self->transitions, sizeof(InstanceShape*));
+    if(parent == NULL) {
+        self->length = 0;
+        c11_smallmap_n2i__ctor(&self->offsets);
+        return self;
+    }
+    self->length = parent->length + 1;
+    self->offsets = c11_vector__copy(&parent->offsets);
+    c11_smallmap_n2i__set(&self->offsets, name, self->length - 1);
+    c11_vector__push(InstanceShape*, &parent->transitions, self);
+    // instances allocated later reserve inline values for the longest shape
+    InstanceShape* root = parent;
+    while(root->parent) root = root->parent;
+    root->max_length = c11__max(root->max_length, self->length);
+    return self;
+}
+
+void InstanceShape__delete(InstanceShape* self) {
+    c11__foreach(InstanceShape*, &self->transitions, it) InstanceShape__delete(*it);
+    c11_vector__dtor(&self->transitions);
+    c11_smallmap_n2i__dtor(&self->offsets);
+    PK_FREE(self);
+}
+
+int InstanceShape__find(const InstanceShape* self, py_Name name) {
+    return c11_smallmap_n2i__get(&self->offsets, name, -1);
+}
+
+/// The shape after adding `name`, or NULL if the instance should fall back to a dict.
+static InstanceShape* InstanceShape__transition(InstanceShape* self, py_Name name) {
+    c11__foreach(InstanceShape*, &self->transitions, it) {
+        if((*it)->name == name) return *it;
+    }
+    if(self->length >= kShapeMaxLength) return NULL;
+    if(self->transitions.length >= kShapeMaxTransitions) return NULL;
+    return InstanceShape__new(self, name);
+}
+
+void InstanceDict__ctor(InstanceDict* self, InstanceShape* root, int capacity) {
+    self->shape = root;
+    self->overflow = NULL;
+    self->capacity = capacity;
+    self->overflow_capacity = 0;
+}
+
+void InstanceDict__dtor(InstanceDict* self) {
+    if(self->shape) {
+        PK_FREE(self->overflow);
+    } else {
+        NameDict__delete(self->dict);
+    }
+}
+
+/// Move all attributes into a `NameDict`.
+static void InstanceDict__to_dict(InstanceDict* self) {
+    NameDict* dict = NameDict__new();
+    int length = InstanceDict__length(self);
+    for(int i = 0; i < length; i++) {
+        py_Name name;
+        py_TValue* value = InstanceDict__item(self, i, &name);
+        NameDict__set(dict, name, *value);
+    }
+    PK_FREE(self->overflow);
+    self->shape = NULL;
+    self->dict = dict;
+}
+
+py_TValue* InstanceDict__try_get(InstanceDict* self, py_Name name) {
+    if(self->shape == NULL) return NameDict__try_get(self->dict, name);
+    int offset = InstanceShape__find(self->shape, name);
+    if(offset < 0) return NULL;
+    return InstanceDict__at(self, offset);
+}
+
+void InstanceDict__set(InstanceDict* self, py_Name name, py_TValue val) {
+    if(self->shape != NULL) {
+        int offset = InstanceShape__find(self->shape, name);
+        if(offset >= 0) {
+            *InstanceDict__at(self, offset) = val;
+            return;
+        }
+        InstanceShape* shape = InstanceShape__transition(self->shape, name);
+        if(shape != NULL) {
+            offset = shape->length - 1;
+            int index = offset - self->capacity;
+            if(index >= self->overflow_capacity) {
+                self->overflow_capacity = c11__max(4, self->overflow_capacity * 2);
+                self->overflow =
+                    PK_REALLOC(self->overflow, sizeof(py_TValue) * self->overflow_capacity);
+            }
+            self->shape = shape;
+            *InstanceDict__at(self, offset) = val;
+            return;
+        }
+        InstanceDict__to_dict(self);
+    }
+    NameDict__set(self->dict, name, val);
+}
+
+bool InstanceDict__del(InstanceDict* self, py_Name name) {
+    if(self->shape != NULL) {
+        // deleting the last added attribute goes back to the parent shape
+        if(self->shape->name == name) {
+            self->shape = self->shape->parent;
+            return true;
+        }
+        if(InstanceShape__find(self->shape, name) < 0) return false;
+        InstanceDict__to_dict(self);
+    }
+    return NameDict__del(self->dict, name);
+}
+
+void InstanceDict__clear(InstanceDict* self) {
+    if(self->shape == NULL) {
+        NameDict__clear(self->dict);
+        return;
+    }
+    while(self->shape->parent) self->shape = self->shape->parent;
+}
+
+int InstanceDict__length(InstanceDict* self) {
+    if(self->shape == NULL) return self->dict->length;
+    return self->shape->length;
+}
+
+py_TValue* InstanceDict__item(InstanceDict* self, int i, py_Name* name) {
+    if(self->shape == NULL) {
+        NameDict_KV* kv = c11__at(NameDict_KV, self->dict, i);
+        *name = kv->key;
+        return &kv->value;
+    }
+    c11_smallmap_n2i_KV* kv = c11__at(c11_smallmap_n2i_KV, &self->shape->offsets, i);
+    *name = kv->key;
+    return InstanceDict__at(self, kv->value);
+}
@@ -7,12 +7,19 @@
 #include "pocketpy/objects/object.h"
 #include "pocketpy/interpreter/vm.h"
 #include "pocketpy/compiler/compiler.h"
+#include "pocketpy/common/_generated.h"
 
 static void code__gc_mark(void* ud) { CodeObject__gc_mark(ud); }
 
+static bool code__clone(void* ud) {
+    pk__clone_code(ud);
+    return true;
+}
+
 py_Type pk_code__register() {
     py_Type type = pk_newtype("code", tp_object, NULL, (py_Dtor)CodeObject__dtor, false, true);
     pk__tp_set_marker(type, code__gc_mark);
+    pk__tp_set_cloner(type, code__clone);
     return type;
 }
 
@@ -75,6 +82,56 @@ bool py_exec(const char* source, const char* filename, enum py_CompileMode mode,
     return ok;
 }
 
+bool pk_exec_pythonlib(const char* name, const char* source, const char* filename, py_Ref module) {
+    int size;
+    const char* data = load_kPythonLibCode(name, &size);
+    if(data != NULL) {
+        CodeObject co;
+        // stale code is ignored, e.g. after editing `python/*.py` without precompiling again
+        if(CodeObject__loads(&co, data, size, source) == NULL) {
+            bool ok = pk_exec(&co, module);
+            CodeObject__dtor(&co);
+            return ok;
+        }
+    }
+    return py_exec(source, filename, EXEC_MODE, module);
+}
+
+bool py_execbinary(const char* data, int size, py_Ref module) {
+    CodeObject co;
+    const char* err = CodeObject__loads(&co, data, size, NULL);
+    if(err) return ValueError("invalid binary code: %s", err);
+    bool ok = pk_exec(&co, module);
+    CodeObject__dtor(&co);
+    return ok;
+}
+
+bool py_compilefile(const char* src_path, const char* dst_path, const char* filename) {
+#if PK_ENABLE_OS
+    char* source = pk_current_vm->callbacks.importfile(src_path);
+    if(source == NULL) return OSError("cannot read '%s'", src_path);
+    CodeObject co;
+    if(!_py_compile(&co, source, filename ? filename : src_path, EXEC_MODE, false)) {
+        PK_FREE(source);
+        return false;
+    }
+    c11_vector data;
+    c11_vector__ctor(&data, sizeof(char));
+    CodeObject__dumps(&co, source, &data);
+    CodeObject__dtor(&co);
+    PK_FREE(source);
+
+    FILE* f = fopen(dst_path, "wb");
+    bool ok = f != NULL && fwrite(data.data, 1, data.length, f) == (size_t)data.length;
+    if(f != NULL) ok = fclose(f) == 0 && ok;
+    c11_vector__dtor(&data);
+    if(!ok) return OSError("cannot write '%s'", dst_path);
+    return true;
+#else
+    return OSError("py_compilefile() is not supported on this platform");
+#endif
+}
+
 bool py_eval(const char* source, py_Ref module) {
     return py_exec(source, "<string>", EVAL_MODE, module);
 }
\ No newline at end of file
@@ -3,19 +3,23 @@
 #include "pocketpy/pocketpy.h"
 
 #include "pocketpy/common/utils.h"
+#include "pocketpy/common/lock.h"
 #include "pocketpy/interpreter/vm.h"
 
-VM* pk_current_vm;
+PK_THREAD_LOCAL_FAST VM* pk_current_vm;
 
+static bool pk_initialized;
 static VM pk_default_vm;
-static VM* pk_all_vm[16];
-static py_TValue _True, _False, _None, _NIL;
+static c11_vector /*T=VM* */ pk_all_vm;  // NULL for VMs not created yet
+static c11_lock pk_all_vm_lock = C11_LOCK_INIT;
+static py_TValue _True, _False, _None, _NIL;  // read-only after `py_initialize()`
 
 void py_initialize() {
-    if(pk_current_vm) {
+    if(pk_initialized) {
         // c11__abort("py_initialize() can only be called once!");
         return;
     }
+    pk_initialized = true;
 
     // check endianness
     int x = 1;
@@ -29,7 +33,9 @@ void py_initialize() {
 
     py_Name__initialize();
 
-    pk_current_vm = pk_all_vm[0] = &pk_default_vm;
+    c11_vector__ctor(&pk_all_vm, sizeof(VM*));
+    c11_vector__push(VM*, &pk_all_vm, &pk_default_vm);
+    pk_current_vm = &pk_default_vm;
 
     // initialize some convenient references
     py_newbool(&_True, true);
@@ -48,8 +54,8 @@ py_GlobalRef py_None() { return &_None; }
 py_GlobalRef py_NIL() { return &_NIL; }
 
 void py_finalize() {
-    for(int i = 1; i < 16; i++) {
-        VM* vm = pk_all_vm[i];
+    for(int i = 1; i < pk_all_vm.length; i++) {
+        VM* vm = c11__getitem(VM*, &pk_all_vm, i);
         if(vm) {
             // temp fix https://github.com/pocketpy/pocketpy/issues/315
             // TODO: refactor VM__ctor and VM__dtor
@@ -58,21 +64,69 @@ void py_finalize() {
             PK_FREE(vm);
         }
     }
+    c11_vector__dtor(&pk_all_vm);
     pk_current_vm = &pk_default_vm;
     VM__dtor(&pk_default_vm);
     pk_current_vm = NULL;
     py_Name__finalize();
+    pk_initialized = false;
 }
 
 void py_switchvm(int index) {
-    if(index < 0 || index >= 16) c11__abort("invalid vm index");
-    if(!pk_all_vm[index]) {
-        pk_current_vm = pk_all_vm[index] = PK_MALLOC(sizeof(VM));
-        memset(pk_current_vm, 0, sizeof(VM));
-        VM__ctor(pk_all_vm[index]);
-    } else {
-        pk_current_vm = pk_all_vm[index];
+    if(index < 0) c11__abort("invalid vm index");
+    c11_lock__acquire(&pk_all_vm_lock);
+    while(pk_all_vm.length <= index) {
+        c11_vector__push(VM*, &pk_all_vm, NULL);
+    }
+    VM* vm = c11__getitem(VM*, &pk_all_vm, index);
+    bool is_new = vm == NULL;
+    if(is_new) {
+        vm = PK_MALLOC(sizeof(VM));
+        memset(vm, 0, sizeof(VM));
+        c11__setitem(VM*, &pk_all_vm, index, vm);
+    }
+    c11_lock__release(&pk_all_vm_lock);
+    // other threads may create their VMs meanwhile
+    pk_current_vm = vm;
+    if(is_new) VM__ctor(vm);
+}
+
+bool py_clonevm(int index, int src) {
+    if(index < 0 || src < 0 || index == src) c11__abort("invalid vm index");
+    c11_lock__acquire(&pk_all_vm_lock);
+    VM* src_vm = src < pk_all_vm.length ? c11__getitem(VM*, &pk_all_vm, src) : NULL;
+    if(src_vm == NULL) c11__abort("vm %d does not exist", src);
+    while(pk_all_vm.length <= index) {
+        c11_vector__push(VM*, &pk_all_vm, NULL);
+    }
+    VM* vm = c11__getitem(VM*, &pk_all_vm, index);
+    bool is_new = vm == NULL;
+    if(is_new) {
+        vm = PK_MALLOC(sizeof(VM));
+        c11__setitem(VM*, &pk_all_vm, index, vm);
+    }
+    c11_lock__release(&pk_all_vm_lock);
+    if(src_vm->top_frame) c11__abort("cannot clone vm %d while it is running", src);
+    pk_current_vm = vm;
+    if(!is_new) VM__dtor(vm);
+    memset(vm, 0, sizeof(VM));
+    VM__ctor_empty(vm);
+    py_Name error;
+    if(VM__clone(vm, src_vm, &error)) return true;
+    VM__dtor(vm);
+    memset(vm, 0, sizeof(VM));
+    VM__ctor(vm);
+    return TypeError("cannot clone '%n' object", error);
+}
+
+void py_setstacksize(int size, int max_size) {
+    VM* vm = pk_current_vm;
+    ValueStack* stack = &vm->stack;
+    if(vm->top_frame || stack->sp != stack->segment->begin) {
+        c11__abort("cannot resize the stack while it is in use");
     }
+    ValueStack__dtor(stack);
+    ValueStack__ctor(stack, size, max_size);
 }
 
 void py_resetvm() {
@@ -83,10 +137,16 @@ void py_resetvm() {
 }
 
 int py_currentvm() {
-    for(int i = 0; i < 16; i++) {
-        if(pk_all_vm[i] == pk_current_vm) return i;
+    int index = -1;
+    c11_lock__acquire(&pk_all_vm_lock);
+    for(int i = 0; i < pk_all_vm.length; i++) {
+        if(c11__getitem(VM*, &pk_all_vm, i) == pk_current_vm) {
+            index = i;
+            break;
+        }
     }
-    return -1;
+    c11_lock__release(&pk_all_vm_lock);
+    return index;
 }
 
 void* py_getvmctx() { return pk_current_vm->ctx; }
@@ -106,6 +166,15 @@ void py_sys_setargv(int argc, char** argv) {
 
 py_Callbacks* py_callbacks() { return &pk_current_vm->callbacks; }
 
+bool py_gc_step(int budget_us) {
+    return ManagedHeap__step(&pk_current_vm->heap, (int64_t)budget_us * 1000);
+}
+
+int py_gc_trim() {
+    VM* vm = pk_current_vm;
+    return ManagedHeap__trim(&vm->heap) + ValueStack__trim(&vm->stack);
+}
+
 const char* pk_opname(Opcode op) {
     const static char* OP_NAMES[] = {
 #define OPCODE(name) #name,
@@ -115,7 +184,7 @@ const char* pk_opname(Opcode op) {
     return OP_NAMES[op];
 }
 
-bool py_call(py_Ref f, int argc, py_Ref argv) {
+static bool pk_call(py_Ref f, int argc, py_Ref argv) {
     if(f->type == tp_nativefunc) {
         return py_callcfunc(f->_cfunc, argc, argv);
     } else {
@@ -130,6 +199,18 @@ bool py_call(py_Ref f, int argc, py_Ref argv) {
     }
 }
 
+bool py_call(py_Ref f, int argc, py_Ref argv) {
+    ValueStack* stack = &pk_current_vm->stack;
+    if(stack->sp + argc <= stack->end) return pk_call(f, argc, argv);
+    // native code may recurse here, so continue on a new segment of the stack
+    py_StackRef p0 = ValueStack__split(stack, stack->sp, argc + PK_MAX_CO_VARNAMES);
+    if(p0 == NULL) return false;
+    py_pushnil();  // the segment is left when `sp` is reset to its beginning
+    bool ok = pk_call(f, argc, argv);
+    ValueStack__reset(stack, p0);
+    return ok;
+}
+
 #ifndef NDEBUG
 bool py_callcfunc(py_CFunction f, int argc, py_Ref argv) {
     py_StackRef p0 = py_peek(0);
@@ -200,7 +281,10 @@ bool pk_loadmethod(py_StackRef self, py_Name name) {
         type = self->type;
     }
 
-    py_Ref cls_var = py_tpfindname(type, name);
+    return pk_loadmethod_clsvar(self, type, py_tpfindname(type, name));
+}
+
+bool pk_loadmethod_clsvar(py_StackRef self, py_Type type, py_Ref cls_var) {
     if(cls_var != NULL) {
         switch(cls_var->type) {
             case tp_function:
@@ -11,9 +11,51 @@
 #include <ctype.h>
 #include <math.h>
 
+typedef struct {
+    const char* path;
+    void (*init)();
+} pk_LazyModule;
+
+/// Native modules which are created on first use by `py_getmodule()`.
+static const pk_LazyModule kLazyModules[] = {
+    {"os",            pk__add_module_os        },
+    {"sys",           pk__add_module_sys       },
+    {"math",          pk__add_module_math      },
+    {"dis",           pk__add_module_dis       },
+    {"random",        pk__add_module_random    },
+    {"json",          pk__add_module_json      },
+    {"gc",            pk__add_module_gc        },
+    {"time",          pk__add_module_time      },
+    {"easing",        pk__add_module_easing    },
+    {"traceback",     pk__add_module_traceback },
+    {"enum",          pk__add_module_enum      },
+    {"inspect",       pk__add_module_inspect   },
+    {"pickle",        pk__add_module_pickle    },
+    {"importlib",     pk__add_module_importlib },
+    {"py_compile",    pk__add_module_py_compile},
+    {"heapq",         pk__add_module_heapq     },
+    {"functools",     pk__add_module_functools },
+    {"conio",         pk__add_module_conio     },
+    {"lz4",           pk__add_module_lz4       },
+#ifdef PK_BUILD_MODULE_LIBHV
+    {"libhv",         pk__add_module_libhv     },
+#endif
+    {"pkpy",          pk__add_module_pkpy      },
+    {"pkpy.executor", pk__add_module_executor  },
+};
+
 py_Ref py_getmodule(const char* path) {
     VM* vm = pk_current_vm;
-    return ModuleDict__try_get(&vm->modules, path);
+    py_Ref mod = ModuleDict__try_get(&vm->modules, path);
+    if(mod != NULL) return mod;
+    for(int i = 0; i < c11__count_array(kLazyModules); i++) {
+        if(strcmp(kLazyModules[i].path, path) == 0) {
+            // an optional module may not be compiled in
+            kLazyModules[i].init();
+            return ModuleDict__try_get(&vm->modules, path);
+        }
+    }
+    return NULL;
 }
 
 py_Ref py_getbuiltin(py_Name name) { return py_getdict(&pk_current_vm->builtins, name); }
@@ -22,6 +64,11 @@ py_Ref py_getglobal(py_Name name) { return py_getdict(&pk_current_vm->main, name
 
 void py_setglobal(py_Name name, py_Ref val) { py_setdict(&pk_current_vm->main, name, val); }
 
+void pk__module_touch(py_Ref module) {
+    assert(module->type == tp_module);
+    pk__module_version(module) = ++pk_current_vm->module_version;
+}
+
 py_Ref py_newmodule(const char* path) {
     ManagedHeap* heap = &pk_current_vm->heap;
     if(strlen(path) > PK_MAX_MODULE_PATH_LEN) c11__abort("module path too long: %s", path);
@@ -32,8 +79,9 @@ py_Ref py_newmodule(const char* path) {
     *r0 = (py_TValue){
         .type = tp_module,
         .is_ptr = true,
-        ._obj = ManagedHeap__new(heap, tp_module, -1, 0),
+        ._obj = ManagedHeap__new(heap, tp_module, -1, sizeof(uint32_t)),
     };
+    pk__module_touch(r0);
 
     int last_dot = c11_sv__rindex((c11_sv){path, strlen(path)}, '.');
     if(last_dot == -1) {
@@ -66,6 +114,40 @@ py_Ref py_newmodule(const char* path) {
 }
 
 int load_module_from_dll_desktop_only(const char* path) PY_RAISE PY_RETURN;
+const char* map_file_desktop_only(const char* path, int* size);
+void unmap_file_desktop_only(const char* data, int size);
+
+/// Import `path` from the `.pkc` file next to `filename`. The `.pkc` file is ignored if it was
+/// compiled from another version of `source`, which may be NULL if there is no source file.
+static int import_binary_desktop_only(const char* path, c11_string* filename, const char* source)
+    PY_RAISE PY_RETURN {
+    // `x.py` -> `x.pkc`
+    c11_string* pkc_path = c11_string__new3("%vkc", (c11_sv){filename->data, filename->size - 1});
+    int size;
+    const char* data = map_file_desktop_only(pkc_path->data, &size);
+    if(data == NULL) {
+        c11_string__delete(pkc_path);
+        return 0;
+    }
+    CodeObject co;
+    const char* err = CodeObject__loads(&co, data, size, source);
+    unmap_file_desktop_only(data, size);
+    if(err) {
+        int res = 0;
+        if(source == NULL) {
+            ImportError("cannot import '%s' from '%s': %s", path, pkc_path->data, err);
+            res = -1;
+        }
+        c11_string__delete(pkc_path);
+        return res;
+    }
+    c11_string__delete(pkc_path);
+    py_GlobalRef mod = py_newmodule(path);
+    bool ok = pk_exec(&co, mod);
+    CodeObject__dtor(&co);
+    py_assign(py_retval(), mod);
+    return ok ? 1 : -1;
+}
 
 int py_import(const char* path_cstr) {
     VM* vm = pk_current_vm;
@@ -134,13 +216,24 @@ int py_import(const char* path_cstr) {
         goto __SUCCESS;
     }
 
-    data = vm->callbacks.importfile(filename->data);
-    if(data != NULL) goto __SUCCESS;
-
-    c11_string__delete(filename);
-    filename = c11_string__new3("%s%c__init__.py", slashed_path->data, PK_PLATFORM_SEP);
-    data = vm->callbacks.importfile(filename->data);
-    if(data != NULL) goto __SUCCESS;
+    // `.pkc` files are read from the disk, so they are skipped if a custom `importfile`
+    // may resolve the source from somewhere else
+    bool use_binary = vm->callbacks.importfile == pk_default_importfile;
+    for(int i = 0; i < 2; i++) {
+        if(i == 1) {
+            c11_string__delete(filename);
+            filename = c11_string__new3("%s%c__init__.py", slashed_path->data, PK_PLATFORM_SEP);
+        }
+        data = vm->callbacks.importfile(filename->data);
+        int res = use_binary ? import_binary_desktop_only(path_cstr, filename, data) : 0;
+        if(res != 0) {
+            c11_string__delete(filename);
+            c11_string__delete(slashed_path);
+            if(data != NULL) PK_FREE((void*)data);
+            return res;
+        }
+        if(data != NULL) goto __SUCCESS;
+    }
 
     c11_string__delete(filename);
     c11_string__delete(slashed_path);
@@ -151,7 +244,12 @@ __SUCCESS:
     do {
     } while(0);
     py_GlobalRef mod = py_newmodule(path_cstr);
-    bool ok = py_exec((const char*)data, filename->data, EXEC_MODE, mod);
+    bool ok;
+    if(need_free) {
+        ok = py_exec((const char*)data, filename->data, EXEC_MODE, mod);
+    } else {
+        ok = pk_exec_pythonlib(path_cstr, data, filename->data, mod);
+    }
     py_assign(py_retval(), mod);
 
     c11_string__delete(filename);
@@ -322,6 +420,394 @@ static bool builtins_round(int argc, py_Ref argv) {
     return pk_callmagic(__round__, argc, argv);
 }
 
+/// Prepare `val` for `pk__next_item()`. A list or tuple is kept as is, so that it can be
+/// indexed directly, anything else is replaced by its iterator.
+static bool pk__iter_or_array(py_Ref val, py_OutRef out) {
+    if(val->type == tp_list || val->type == tp_tuple) {
+        py_assign(out, val);
+        return true;
+    }
+    if(!py_iter(val)) return false;
+    py_assign(out, py_retval());
+    return true;
+}
+
+/// `pk__iter_or_array()` into the slot `i` of `self`.
+static bool pk__iter_or_array_slot(py_Ref val, py_Ref self, int i) {
+    // `py_iter()` may trigger a gc, so the barrier must come after the store
+    bool ok = pk__iter_or_array(val, py_getslot(self, i));
+    pk__gc_barrier(self->_obj);
+    return ok;
+}
+
+/// Fetch the next item from an object prepared by `pk__iter_or_array()`.
+/// 1: item stored in `out`, 0: exhausted, -1: error
+static int pk__next_item(py_Ref iter, int* index, py_TValue* out) {
+    py_TValue* p;
+    int length = pk_arrayview(iter, &p);
+    if(length != -1) {
+        if(*index >= length) return 0;
+        *out = p[(*index)++];
+        return 1;
+    }
+    int res = py_next(iter);
+    if(res == 1) *out = *py_retval();
+    return res;
+}
+
+static bool pk__sum_add(py_Ref acc, py_Ref item) {
+    if(acc->type == tp_int && item->type == tp_int) {
+        acc->_i64 = (py_i64)((uint64_t)acc->_i64 + (uint64_t)item->_i64);
+        return true;
+    }
+    if(acc->type == tp_float && item->type == tp_float) {
+        acc->_f64 += item->_f64;
+        return true;
+    }
+    if(acc->type == tp_float && item->type == tp_int) {
+        acc->_f64 += item->_i64;
+        return true;
+    }
+    if(acc->type == tp_int && item->type == tp_float) {
+        py_newfloat(acc, acc->_i64 + item->_f64);
+        return true;
+    }
+    if(!py_binaryadd(acc, item)) return false;
+    py_assign(acc, py_retval());
+    return true;
+}
+
+static bool builtins_sum(int argc, py_Ref argv) {
+    if(argc < 1 || argc > 2) return TypeError("sum() takes 1 or 2 arguments (%d given)", argc);
+    py_Ref acc = py_pushtmp();
+    if(argc == 2) {
+        py_assign(acc, py_arg(1));
+    } else {
+        py_newint(acc, 0);
+    }
+
+    py_i64 start, stop, step;
+    if(acc->type == tp_int && pk_rangeview(argv, &start, &stop, &step)) {
+        // closed form, wrapping around exactly like a sequence of int additions
+        uint64_t n = 0;
+        if(step > 0 && start < stop) n = ((uint64_t)stop - (uint64_t)start - 1) / step + 1;
+        if(step < 0 && start > stop) n = ((uint64_t)start - (uint64_t)stop - 1) / -(uint64_t)step + 1;
+        uint64_t tri = n % 2 == 0 ? (n / 2) * (n - 1) : n * ((n - 1) / 2);
+        acc->_i64 = (py_i64)((uint64_t)acc->_i64 + n * (uint64_t)start + tri * (uint64_t)step);
+    } else {
+        py_Ref iter = py_pushtmp();
+        py_Ref item = py_pushtmp();
+        if(!pk__iter_or_array(argv, iter)) return false;
+        int index = 0;
+        while(true) {
+            int res = pk__next_item(iter, &index, item);
+            if(res == -1) return false;
+            if(res == 0) break;
+            if(!pk__sum_add(acc, item)) return false;
+        }
+        py_shrink(2);
+    }
+    py_assign(py_retval(), acc);
+    py_pop();
+    return true;
+}
+
+static bool builtins_minmax(int argc, py_Ref argv, bool is_min) {
+    // min(*args, key=None) / max(*args, key=None)
+    py_Ref args = argv;
+    py_Ref key = py_arg(1);
+    int length = py_tuple_len(args);
+    if(length == 0) return TypeError("expected 1 arguments, got 0");
+    // [iter, res, key(res), item, key(item)]
+    py_StackRef p = py_peek(0);
+    for(int i = 0; i < 5; i++)
+        py_pushnil();
+    if(length == 1) {
+        if(!pk__iter_or_array(py_tuple_getitem(args, 0), &p[0])) return false;
+    } else {
+        py_assign(&p[0], args);
+    }
+
+    int index = 0;
+    int res = pk__next_item(&p[0], &index, &p[1]);
+    if(res == -1) return false;
+    if(res == 0) return ValueError("args is an empty sequence");
+    if(py_isnone(key)) {
+        p[2] = p[1];
+    } else {
+        if(!py_call(key, 1, &p[1])) return false;
+        p[2] = *py_retval();
+    }
+
+    while(true) {
+        res = pk__next_item(&p[0], &index, &p[3]);
+        if(res == -1) return false;
+        if(res == 0) break;
+        if(py_isnone(key)) {
+            p[4] = p[3];
+        } else {
+            if(!py_call(key, 1, &p[3])) return false;
+            p[4] = *py_retval();
+        }
+        int less = is_min ? py_less(&p[4], &p[2]) : py_less(&p[2], &p[4]);
+        if(less == -1) return false;
+        if(less) {
+            p[1] = p[3];
+            p[2] = p[4];
+        }
+    }
+    py_assign(py_retval(), &p[1]);
+    py_shrink(5);
+    return true;
+}
+
+static bool builtins_min(int argc, py_Ref argv) { return builtins_minmax(argc, argv, true); }
+
+static bool builtins_max(int argc, py_Ref argv) { return builtins_minmax(argc, argv, false); }
+
+static bool builtins_allany(int argc, py_Ref argv, bool is_all) {
+    PY_CHECK_ARGC(1);
+    py_Ref iter = py_pushtmp();
+    py_Ref item = py_pushtmp();
+    if(!pk__iter_or_array(argv, iter)) return false;
+    int index = 0;
+    while(true) {
+        int res = pk__next_item(iter, &index, item);
+        if(res == -1) return false;
+        if(res == 0) break;
+        res = py_bool(item);
+        if(res == -1) return false;
+        if(res != is_all) {
+            py_shrink(2);
+            py_newbool(py_retval(), !is_all);
+            return true;
+        }
+    }
+    py_shrink(2);
+    py_newbool(py_retval(), is_all);
+    return true;
+}
+
+static bool builtins_all(int argc, py_Ref argv) { return builtins_allany(argc, argv, true); }
+
+static bool builtins_any(int argc, py_Ref argv) { return builtins_allany(argc, argv, false); }
+
+static bool builtins_reversed(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    // NOTE: returns a list instead of an iterator
+    if(!py_tpcall(tp_list, 1, argv)) return false;
+    py_TValue* p = py_list_data(py_retval());
+    int length = py_list_len(py_retval());
+    for(int i = 0, j = length - 1; i < j; i++, j--) {
+        py_TValue tmp = p[i];
+        p[i] = p[j];
+        p[j] = tmp;
+    }
+    return true;
+}
+
+static bool builtins_sorted(int argc, py_Ref argv) {
+    // sorted(iterable, key=None, reverse=False)
+    if(!py_tpcall(tp_list, 1, argv)) return false;
+    py_push(py_retval());  // list
+    py_push(py_peek(-1));
+    if(!py_pushmethod(py_name("sort"))) c11__abort("sorted(): failed to load method 'sort'");
+    py_push(py_arg(1));
+    py_push(py_arg(2));
+    if(!py_vectorcall(2, 0)) return false;
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+/* Builtin iterators: `map`, `filter`, `zip` and `enumerate`.
+ * Each input is stored in a slot prepared by `pk__iter_or_array()`. */
+typedef struct BuiltinIterator {
+    int n;        // number of inputs
+    int index;    // index into list or tuple inputs, which advance in lockstep
+    py_i64 count; // counter of `enumerate`
+} BuiltinIterator;
+
+static BuiltinIterator* BuiltinIterator__new(py_OutRef out, py_Type type, int offset, int n) {
+    BuiltinIterator* ud = py_newobject(out, type, offset + n, sizeof(BuiltinIterator));
+    ud->n = n;
+    ud->index = 0;
+    ud->count = 0;
+    return ud;
+}
+
+/// Fetch one item from every input into `out[0..n)`. 1: ok, 0: exhausted, -1: error
+static int BuiltinIterator__next(py_Ref self, int offset, py_TValue* out) {
+    BuiltinIterator* ud = py_touserdata(self);
+    for(int i = 0; i < ud->n; i++) {
+        int index = ud->index;
+        int res = pk__next_item(py_getslot(self, offset + i), &index, &out[i]);
+        if(res != 1) return res;
+    }
+    ud->index++;
+    return 1;
+}
+
+static bool map__new__(int argc, py_Ref argv) {
+    // map(f, *iterables)
+    if(argc < 3) return TypeError("map() must have at least two arguments");
+    int n = argc - 2;
+    py_Ref out = py_pushtmp();
+    BuiltinIterator__new(out, tp_map, 1, n);
+    py_setslot(out, 0, py_arg(1));
+    for(int i = 0; i < n; i++) {
+        if(!pk__iter_or_array_slot(py_arg(2 + i), out, 1 + i)) return false;
+    }
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool map__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    BuiltinIterator* ud = py_touserdata(argv);
+    int n = ud->n;
+    py_push(py_getslot(argv, 0));
+    py_pushnil();
+    py_StackRef args = py_peek(0);
+    for(int i = 0; i < n; i++)
+        py_pushnil();
+    int res = BuiltinIterator__next(argv, 1, args);
+    if(res == 1) return py_vectorcall(n, 0);
+    py_shrink(n + 2);
+    if(res == 0) return StopIteration();
+    return false;
+}
+
+static bool filter__new__(int argc, py_Ref argv) {
+    // filter(f, iterable)
+    if(argc != 3) return TypeError("filter() expected 2 arguments, got %d", argc - 1);
+    py_Ref out = py_pushtmp();
+    BuiltinIterator__new(out, tp_filter, 1, 1);
+    py_setslot(out, 0, py_arg(1));
+    if(!pk__iter_or_array_slot(py_arg(2), out, 1)) return false;
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool filter__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    py_Ref f = py_getslot(argv, 0);
+    py_Ref item = py_pushtmp();
+    while(true) {
+        int res = BuiltinIterator__next(argv, 1, item);
+        if(res == -1) return false;
+        if(res == 0) {
+            py_pop();
+            return StopIteration();
+        }
+        if(py_isnone(f)) {
+            res = py_bool(item);
+        } else {
+            if(!py_call(f, 1, item)) return false;
+            res = py_bool(py_retval());
+        }
+        if(res == -1) return false;
+        if(res) break;
+    }
+    py_assign(py_retval(), item);
+    py_pop();
+    return true;
+}
+
+static bool zip__new__(int argc, py_Ref argv) {
+    // zip(*iterables)
+    int n = argc - 1;
+    py_Ref out = py_pushtmp();
+    BuiltinIterator__new(out, tp_zip, 0, n);
+    for(int i = 0; i < n; i++) {
+        if(!pk__iter_or_array_slot(py_arg(1 + i), out, i)) return false;
+    }
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool zip__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    BuiltinIterator* ud = py_touserdata(argv);
+    int n = ud->n;
+    if(n == 0) return StopIteration();
+    py_StackRef items = py_peek(0);
+    for(int i = 0; i < n; i++)
+        py_pushnil();
+    int res = BuiltinIterator__next(argv, 0, items);
+    if(res == 1) {
+        py_newtuple(py_retval(), n);
+        for(int i = 0; i < n; i++) {
+            py_tuple_setitem(py_retval(), i, &items[i]);
+        }
+    }
+    py_shrink(n);
+    if(res == 0) return StopIteration();
+    return res == 1;
+}
+
+static bool enumerate__new__(int argc, py_Ref argv) {
+    // enumerate(iterable, start=0)
+    PY_CHECK_ARG_TYPE(2, tp_int);
+    py_Ref out = py_pushtmp();
+    BuiltinIterator* ud = BuiltinIterator__new(out, tp_enumerate, 0, 1);
+    ud->count = py_toint(py_arg(2));
+    if(!pk__iter_or_array_slot(py_arg(1), out, 0)) return false;
+    py_assign(py_retval(), out);
+    py_pop();
+    return true;
+}
+
+static bool enumerate__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    BuiltinIterator* ud = py_touserdata(argv);
+    py_Ref item = py_pushtmp();
+    int res = BuiltinIterator__next(argv, 0, item);
+    if(res == 1) {
+        py_newtuple(py_retval(), 2);
+        py_newint(py_tuple_getitem(py_retval(), 0), ud->count++);
+        py_tuple_setitem(py_retval(), 1, item);
+    }
+    py_pop();
+    if(res == 0) return StopIteration();
+    return res == 1;
+}
+
+py_Type pk_map__register() {
+    py_Type type = pk_newtype("map", tp_object, NULL, NULL, false, true);
+    py_bindmagic(type, __new__, map__new__);
+    py_bindmagic(type, __iter__, pk_wrapper__self);
+    py_bindmagic(type, __next__, map__next__);
+    return type;
+}
+
+py_Type pk_filter__register() {
+    py_Type type = pk_newtype("filter", tp_object, NULL, NULL, false, true);
+    py_bindmagic(type, __new__, filter__new__);
+    py_bindmagic(type, __iter__, pk_wrapper__self);
+    py_bindmagic(type, __next__, filter__next__);
+    return type;
+}
+
+py_Type pk_zip__register() {
+    py_Type type = pk_newtype("zip", tp_object, NULL, NULL, false, true);
+    py_bindmagic(type, __new__, zip__new__);
+    py_bindmagic(type, __iter__, pk_wrapper__self);
+    py_bindmagic(type, __next__, zip__next__);
+    return type;
+}
+
+py_Type pk_enumerate__register() {
+    py_Type type = pk_newtype("enumerate", tp_object, NULL, NULL, false, true);
+    py_bind(py_tpobject(type), "__new__(cls, iterable, start=0)", enumerate__new__);
+    py_bindmagic(type, __iter__, pk_wrapper__self);
+    py_bindmagic(type, __next__, enumerate__next__);
+    return type;
+}
+
 static bool builtins_print(int argc, py_Ref argv) {
     // print(*args, sep=' ', end='\n')
     py_TValue* args = py_tuple_data(argv);
@@ -703,6 +1189,14 @@ py_TValue pk_builtins__register() {
 
     py_bind(builtins, "print(*args, sep=' ', end='\\n')", builtins_print);
 
+    py_bindfunc(builtins, "sum", builtins_sum);
+    py_bind(builtins, "min(*args, key=None)", builtins_min);
+    py_bind(builtins, "max(*args, key=None)", builtins_max);
+    py_bindfunc(builtins, "all", builtins_all);
+    py_bindfunc(builtins, "any", builtins_any);
+    py_bindfunc(builtins, "reversed", builtins_reversed);
+    py_bind(builtins, "sorted(iterable, key=None, reverse=False)", builtins_sorted);
+
     py_bindfunc(builtins, "isinstance", builtins_isinstance);
     py_bindfunc(builtins, "issubclass", builtins_issubclass);
     py_bindfunc(builtins, "callable", builtins_callable);
@@ -740,6 +1234,20 @@ static void function__gc_mark(void* ud) {
     FuncDecl__gc_mark(func->decl);
 }
 
+static bool function__clone(void* ud) {
+    Function* func = ud;
+    func->decl = pk__clone_funcdecl(func->decl);
+    pk__clone_value(&func->module);
+    if(func->clazz) func->clazz = pk__clone_object(func->clazz);
+    if(func->closure) {
+        NameDict* closure = PK_MALLOC(sizeof(NameDict));
+        *closure = *func->closure;
+        pk__clone_namedict(closure);
+        func->closure = closure;
+    }
+    return true;
+}
+
 static bool function__doc__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     Function* func = py_touserdata(py_arg(0));
@@ -756,6 +1264,7 @@ py_Type pk_function__register() {
         pk_newtype("function", tp_object, NULL, (void (*)(void*))Function__dtor, false, true);
 
     pk__tp_set_marker(type, function__gc_mark);
+    pk__tp_set_cloner(type, function__clone);
 
     py_bindproperty(type, "__doc__", function__doc__, NULL);
     return type;
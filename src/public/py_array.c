@@ -92,6 +92,8 @@ static bool array_iterator__next__(int argc, py_Ref argv) {
 
 py_Type pk_array_iterator__register() {
     py_Type type = pk_newtype("array_iterator", tp_object, NULL, NULL, false, true);
+    // it points into the array
+    pk__tp_set_cloner(type, pk__clone_unsupported);
     py_bindmagic(type, __iter__, array_iterator__iter__);
     py_bindmagic(type, __next__, array_iterator__next__);
     return type;
@@ -3,287 +3,21 @@
 #include "pocketpy/common/utils.h"
 #include "pocketpy/common/sstream.h"
 #include "pocketpy/objects/object.h"
+#include "pocketpy/objects/dict.h"
 #include "pocketpy/interpreter/vm.h"
 
-#define PK_DICT_MAX_COLLISION 4
-
-static uint32_t Dict__next_cap(uint32_t cap) {
-    switch(cap) {
-        case 7: return 17;
-        case 17: return 37;
-        case 37: return 79;
-        case 79: return 163;
-        case 163: return 331;
-        case 331: return 673;
-        case 673: return 1361;
-        case 1361: return 2053;
-        case 2053: return 3083;
-        case 3083: return 4637;
-        case 4637: return 6959;
-        case 6959: return 10453;
-        case 10453: return 15683;
-        case 15683: return 23531;
-        case 23531: return 35311;
-        case 35311: return 52967;
-        case 52967: return 79451;
-        case 79451: return 119179;
-        case 119179: return 178781;
-        case 178781: return 268189;
-        case 268189: return 402299;
-        case 402299: return 603457;
-        case 603457: return 905189;
-        case 905189: return 1357787;
-        case 1357787: return 2036687;
-        case 2036687: return 3055043;
-        case 3055043: return 4582577;
-        case 4582577: return 6873871;
-        case 6873871: return 10310819;
-        case 10310819: return 15466229;
-        case 15466229: return 23199347;
-        case 23199347: return 34799021;
-        case 34799021: return 52198537;
-        case 52198537: return 78297827;
-        case 78297827: return 117446801;
-        case 117446801: return 176170229;
-        case 176170229: return 264255353;
-        case 264255353: return 396383041;
-        case 396383041: return 594574583;
-        case 594574583: return 891861923;
-        default: c11__unreachable();
-    }
-}
-
-typedef struct {
-    uint64_t hash;
-    py_TValue key;
-    py_TValue val;
-} DictEntry;
-
-typedef struct {
-    int _[PK_DICT_MAX_COLLISION];
-} DictIndex;
-
-typedef struct {
-    int length;
-    uint32_t capacity;
-    DictIndex* indices;
-    c11_vector /*T=DictEntry*/ entries;
-} Dict;
-
-typedef struct {
-    DictEntry* curr;
-    DictEntry* end;
-} DictIterator;
-
-static void Dict__ctor(Dict* self, uint32_t capacity, int entries_capacity) {
-    self->length = 0;
-    self->capacity = capacity;
-    self->indices = PK_MALLOC(self->capacity * sizeof(DictIndex));
-    memset(self->indices, -1, self->capacity * sizeof(DictIndex));
-    c11_vector__ctor(&self->entries, sizeof(DictEntry));
-    c11_vector__reserve(&self->entries, entries_capacity);
-}
-
-static void Dict__dtor(Dict* self) {
-    self->length = 0;
-    self->capacity = 0;
-    PK_FREE(self->indices);
-    c11_vector__dtor(&self->entries);
-}
-
-static bool Dict__try_get(Dict* self, py_TValue* key, DictEntry** out) {
-    py_i64 hash;
-    if(!py_hash(key, &hash)) return false;
-    int idx = (uint64_t)hash % self->capacity;
-    for(int i = 0; i < PK_DICT_MAX_COLLISION; i++) {
-        int idx2 = self->indices[idx]._[i];
-        if(idx2 == -1) continue;
-        DictEntry* entry = c11__at(DictEntry, &self->entries, idx2);
-        if(entry->hash == (uint64_t)hash) {
-            int res = py_equal(&entry->key, key);
-            if(res == 1) {
-                *out = entry;
-                return true;
-            }
-            if(res == -1) return false;  // error
-        }
-    }
-    *out = NULL;
-    return true;
-}
-
-static void Dict__clear(Dict* self) {
-    memset(self->indices, -1, self->capacity * sizeof(DictIndex));
-    c11_vector__clear(&self->entries);
-    self->length = 0;
-}
-
-static void Dict__rehash_2x(Dict* self) {
-    Dict old_dict = *self;
-    uint32_t new_capacity = self->capacity;
-
-__RETRY:
-    // use next capacity
-    new_capacity = Dict__next_cap(new_capacity);
-    // create a new dict with new capacity
-    Dict__ctor(self, new_capacity, old_dict.entries.capacity);
-    // move entries from old dict to new dict
-    for(int i = 0; i < old_dict.entries.length; i++) {
-        DictEntry* old_entry = c11__at(DictEntry, &old_dict.entries, i);
-        if(py_isnil(&old_entry->key)) continue;
-        int idx = old_entry->hash % new_capacity;
-        bool success = false;
-        for(int i = 0; i < PK_DICT_MAX_COLLISION; i++) {
-            int idx2 = self->indices[idx]._[i];
-            if(idx2 == -1) {
-                // insert new entry (empty slot)
-                c11_vector__push(DictEntry, &self->entries, *old_entry);
-                self->indices[idx]._[i] = self->entries.length - 1;
-                self->length++;
-                success = true;
-                break;
-            }
-        }
-        if(!success) {
-            Dict__dtor(self);
-            goto __RETRY;
-        }
-    }
-    // done
-    Dict__dtor(&old_dict);
-}
-
-static void Dict__compact_entries(Dict* self) {
-    int* mappings = PK_MALLOC(self->entries.length * sizeof(int));
-
-    int n = 0;
-    for(int i = 0; i < self->entries.length; i++) {
-        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
-        if(py_isnil(&entry->key)) continue;
-        mappings[i] = n;
-        if(i != n) {
-            DictEntry* new_entry = c11__at(DictEntry, &self->entries, n);
-            *new_entry = *entry;
-        }
-        n++;
-    }
-    self->entries.length = n;
-    // update indices
-    for(uint32_t i = 0; i < self->capacity; i++) {
-        for(int j = 0; j < PK_DICT_MAX_COLLISION; j++) {
-            int idx = self->indices[i]._[j];
-            if(idx == -1) continue;
-            self->indices[i]._[j] = mappings[idx];
-        }
-    }
-    PK_FREE(mappings);
-}
-
-static bool Dict__set(Dict* self, py_TValue* key, py_TValue* val) {
-    py_i64 hash;
-    if(!py_hash(key, &hash)) return false;
-    int idx = (uint64_t)hash % self->capacity;
-    int bad_hash_count = 0;
-    for(int i = 0; i < PK_DICT_MAX_COLLISION; i++) {
-        int idx2 = self->indices[idx]._[i];
-        if(idx2 == -1) {
-            // insert new entry
-            DictEntry* new_entry = c11_vector__emplace(&self->entries);
-            new_entry->hash = (uint64_t)hash;
-            new_entry->key = *key;
-            new_entry->val = *val;
-            self->indices[idx]._[i] = self->entries.length - 1;
-            self->length++;
-            return true;
-        }
-        // update existing entry
-        DictEntry* entry = c11__at(DictEntry, &self->entries, idx2);
-        // check if they have the same hash
-        if(entry->hash == (uint64_t)hash) {
-            // check if they are equal
-            int res = py_equal(&entry->key, key);
-            if(res == 1) {
-                entry->val = *val;
-                return true;
-            }
-            if(res == -1) return false;  // error
-            // res == 0
-            bad_hash_count++;
-        }
-    }
-    // no empty slot found
-    if(bad_hash_count == PK_DICT_MAX_COLLISION) {
-        // all `PK_DICT_MAX_COLLISION` slots have the same hash but different keys
-        // we are unable to solve this collision via rehashing
-        return RuntimeError("dict: %d/%d/%d: maximum collision reached (hash=%i)",
-                            self->entries.length,
-                            self->entries.capacity,
-                            self->capacity,
-                            hash);
-    }
-
-    if(self->capacity >= (uint32_t)self->entries.length * 10) {
-        return RuntimeError("dict: %d/%d/%d: minimum load factor reached",
-                            self->entries.length,
-                            self->entries.capacity,
-                            self->capacity);
-    }
-    Dict__rehash_2x(self);
-    return Dict__set(self, key, val);
-}
-
-/// Delete an entry from the dict.
-/// -1: error, 0: not found, 1: found and deleted
-static int Dict__pop(Dict* self, py_Ref key) {
-    py_i64 hash;
-    if(!py_hash(key, &hash)) return -1;
-    int idx = (uint64_t)hash % self->capacity;
-    for(int i = 0; i < PK_DICT_MAX_COLLISION; i++) {
-        int idx2 = self->indices[idx]._[i];
-        if(idx2 == -1) continue;
-        DictEntry* entry = c11__at(DictEntry, &self->entries, idx2);
-        if(entry->hash == (uint64_t)hash) {
-            int res = py_equal(&entry->key, key);
-            if(res == 1) {
-                *py_retval() = entry->val;
-                py_newnil(&entry->key);
-                self->indices[idx]._[i] = -1;
-                self->length--;
-                if(self->length < self->entries.length / 2) Dict__compact_entries(self);
-                return 1;
-            }
-            if(res == -1) return -1;  // error
-        }
-    }
-    return 0;
-}
-
-static void DictIterator__ctor(DictIterator* self, Dict* dict) {
-    self->curr = dict->entries.data;
-    self->end = self->curr + dict->entries.length;
-}
-
-static DictEntry* DictIterator__next(DictIterator* self) {
-    DictEntry* retval;
-    do {
-        if(self->curr == self->end) return NULL;
-        retval = self->curr++;
-    } while(py_isnil(&retval->key));
-    return retval;
-}
-
 ///////////////////////////////
 static bool dict__new__(int argc, py_Ref argv) {
     py_Type cls = py_totype(argv);
     int slots = cls == tp_dict ? 0 : -1;
     Dict* ud = py_newobject(py_retval(), cls, slots, sizeof(Dict));
-    Dict__ctor(ud, 7, 8);
+    Dict__ctor(ud, kDictGroupSize, 8);
     return true;
 }
 
 void py_newdict(py_Ref out) {
     Dict* ud = py_newobject(out, tp_dict, 0, sizeof(Dict));
-    Dict__ctor(ud, 7, 8);
+    Dict__ctor(ud, kDictGroupSize, 8);
 }
 
 static bool dict__init__(int argc, py_Ref argv) {
@@ -304,7 +38,9 @@ static bool dict__init__(int argc, py_Ref argv) {
         }
         py_Ref key = py_tuple_getitem(tuple, 0);
         py_Ref val = py_tuple_getitem(tuple, 1);
-        if(!Dict__set(self, key, val)) return false;
+        bool ok = Dict__set(self, key, val);
+        pk__gc_barrier(argv->_obj);
+        if(!ok) return false;
     }
     return true;
 }
@@ -327,7 +63,10 @@ static bool dict__getitem__(int argc, py_Ref argv) {
 static bool dict__setitem__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(3);
     Dict* self = py_touserdata(argv);
-    return Dict__set(self, py_arg(1), py_arg(2));
+    bool ok = Dict__set(self, py_arg(1), py_arg(2));
+    pk__gc_barrier(argv->_obj);
+    py_newnone(py_retval());
+    return ok;
 }
 
 static bool dict__delitem__(int argc, py_Ref argv) {
@@ -441,12 +180,7 @@ static bool dict_copy(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     Dict* self = py_touserdata(argv);
     Dict* new_dict = py_newobject(py_retval(), tp_dict, 0, sizeof(Dict));
-    new_dict->capacity = self->capacity;
-    new_dict->length = self->length;
-    new_dict->entries = c11_vector__copy(&self->entries);
-    // copy indices
-    new_dict->indices = PK_MALLOC(new_dict->capacity * sizeof(DictIndex));
-    memcpy(new_dict->indices, self->indices, new_dict->capacity * sizeof(DictIndex));
+    Dict__copy(new_dict, self);
     return true;
 }
 
@@ -458,7 +192,9 @@ static bool dict_update(int argc, py_Ref argv) {
     for(int i = 0; i < other->entries.length; i++) {
         DictEntry* entry = c11__at(DictEntry, &other->entries, i);
         if(py_isnil(&entry->key)) continue;
-        if(!Dict__set(self, &entry->key, &entry->val)) return false;
+        bool ok = Dict__set(self, &entry->key, &entry->val);
+        pk__gc_barrier(argv->_obj);
+        if(!ok) return false;
     }
     py_newnone(py_retval());
     return true;
@@ -535,10 +271,16 @@ static void dict__gc_mark(void* ud) {
     }
 }
 
+static bool dict__clone(void* ud) {
+    pk__clone_dict(ud, false);
+    return true;
+}
+
 py_Type pk_dict__register() {
     py_Type type = pk_newtype("dict", tp_object, NULL, (void (*)(void*))Dict__dtor, false, false);
 
     pk__tp_set_marker(type, dict__gc_mark);
+    pk__tp_set_cloner(type, dict__clone);
 
     py_bindmagic(type, __new__, dict__new__);
     py_bindmagic(type, __init__, dict__init__);
@@ -580,6 +322,8 @@ static bool dict_items__next__(int argc, py_Ref argv) {
 
 py_Type pk_dict_items__register() {
     py_Type type = pk_newtype("dict_items", tp_object, NULL, NULL, false, true);
+    // it points into the entries of the dict
+    pk__tp_set_cloner(type, pk__clone_unsupported);
     py_bindmagic(type, __iter__, pk_wrapper__self);
     py_bindmagic(type, __next__, dict_items__next__);
     return type;
@@ -602,7 +346,9 @@ int py_dict_getitem(py_Ref self, py_Ref key) {
 bool py_dict_setitem(py_Ref self, py_Ref key, py_Ref val) {
     assert(py_isdict(self));
     Dict* ud = py_touserdata(self);
-    return Dict__set(ud, key, val);
+    bool ok = Dict__set(ud, key, val);
+    pk__gc_barrier(self->_obj);
+    return ok;
 }
 
 int py_dict_delitem(py_Ref self, py_Ref key) {
@@ -32,6 +32,7 @@ py_Ref py_list_getitem(py_Ref self, int i) {
 void py_list_setitem(py_Ref self, int i, py_Ref val) {
     List* ud = py_touserdata(self);
     c11__setitem(py_TValue, ud, i, *val);
+    pk__gc_barrier(self->_obj);
 }
 
 void py_list_delitem(py_Ref self, int i) {
@@ -54,11 +55,13 @@ void py_list_swap(py_Ref self, int i, int j) {
 void py_list_append(py_Ref self, py_Ref val) {
     List* ud = py_touserdata(self);
     c11_vector__push(py_TValue, ud, *val);
+    pk__gc_barrier(self->_obj);
 }
 
 py_ItemRef py_list_emplace(py_Ref self) {
     List* ud = py_touserdata(self);
     c11_vector__emplace(ud);
+    pk__gc_barrier(self->_obj);
     return &c11_vector__back(py_TValue, ud);
 }
 
@@ -70,6 +73,7 @@ void py_list_clear(py_Ref self) {
 void py_list_insert(py_Ref self, int i, py_Ref val) {
     List* ud = py_touserdata(self);
     c11_vector__insert(py_TValue, ud, i, *val);
+    pk__gc_barrier(self->_obj);
 }
 
 ////////////////////////////////
@@ -162,6 +166,7 @@ static bool list__setitem__(int argc, py_Ref argv) {
     int index = py_toint(py_arg(1));
     if(!pk__normalize_index(&index, self->length)) return false;
     c11__setitem(py_TValue, self, index, *py_arg(2));
+    pk__gc_barrier(argv->_obj);
     py_newnone(py_retval());
     return true;
 }
@@ -248,6 +253,7 @@ static bool list_extend(int argc, py_Ref argv) {
     int length = pk_arrayview(py_arg(1), &p);
     if(length == -1) return TypeError("extend() argument must be a list or tuple");
     c11_vector__extend(py_TValue, self, p, length);
+    pk__gc_barrier(argv->_obj);
     py_newnone(py_retval());
     return true;
 }
@@ -347,6 +353,7 @@ static bool list_insert(int argc, py_Ref argv) {
     if(index < 0) index = 0;
     if(index > self->length) index = self->length;
     c11_vector__insert(py_TValue, self, index, *py_arg(2));
+    pk__gc_barrier(argv->_obj);
     py_newnone(py_retval());
     return true;
 }
@@ -411,11 +418,21 @@ static void list__gc_mark(void* ud) {
     }
 }
 
+static bool list__clone(void* ud) {
+    List* self = ud;
+    *self = c11_vector__copy(self);
+    for(int i = 0; i < self->length; i++) {
+        pk__clone_value(c11__at(py_TValue, self, i));
+    }
+    return true;
+}
+
 py_Type pk_list__register() {
     py_Type type =
         pk_newtype("list", tp_object, NULL, (void (*)(void*))c11_vector__dtor, false, true);
 
     pk__tp_set_marker(type, list__gc_mark);
+    pk__tp_set_cloner(type, list__clone);
 
     py_bindmagic(type, __len__, list__len__);
     py_bindmagic(type, __eq__, list__eq__);
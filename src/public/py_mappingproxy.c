@@ -7,7 +7,7 @@
 
 void pk_mappingproxy__namedict(py_Ref out, py_Ref object) {
     py_newobject(out, tp_namedict, 1, 0);
-    assert(object->is_ptr && object->_obj->slots == -1);
+    assert(object->is_ptr && object->_obj->slots < 0);
     py_setslot(out, 0, object);
 }
 
@@ -48,10 +48,17 @@ static bool namedict__contains__(int argc, py_Ref argv) {
     return true;
 }
 
+static bool namedict_items__append(py_Name name, py_Ref value, void* ctx) {
+    py_Ref slot = py_list_emplace(py_retval());
+    py_newtuple(slot, 2);
+    py_newstr(py_tuple_getitem(slot, 0), py_name2str(name));
+    py_assign(py_tuple_getitem(slot, 1), value);
+    return true;
+}
+
 static bool namedict_items(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     py_Ref object = py_getslot(argv, 0);
-    NameDict* dict = PyObject__dict(object->_obj);
     py_newlist(py_retval());
     if(object->type == tp_type) {
         py_TypeInfo* ti = pk__type_info(py_totype(object));
@@ -72,20 +79,20 @@ static bool namedict_items(int argc, py_Ref argv) {
             }
         }
     }
-    for(int i = 0; i < dict->length; i++) {
-        py_Ref slot = py_list_emplace(py_retval());
-        py_newtuple(slot, 2);
-        NameDict_KV* kv = c11__at(NameDict_KV, dict, i);
-        py_newstr(py_tuple_getitem(slot, 0), py_name2str(kv->key));
-        py_assign(py_tuple_getitem(slot, 1), &kv->value);
-    }
-    return true;
+    return py_applydict(object, namedict_items__append, NULL);
 }
 
 static bool namedict_clear(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
     py_Ref object = py_getslot(argv, 0);
+    if(object->_obj->slots <= -2) {
+        InstanceDict__clear(PyObject__instancedict(object->_obj));
+        py_newnone(py_retval());
+        return true;
+    }
     NameDict* dict = PyObject__dict(object->_obj);
+    if(object->type == tp_type) pk_current_vm->type_version++;
+    if(object->type == tp_module) pk__module_touch(object);
     NameDict__clear(dict);
     py_newnone(py_retval());
     return true;
@@ -159,6 +166,8 @@ static bool locals__contains__(int argc, py_Ref argv) {
 
 py_Type pk_locals__register() {
     py_Type type = pk_newtype("locals", tp_object, NULL, NULL, false, true);
+    // it points to a frame
+    pk__tp_set_cloner(type, pk__clone_unsupported);
 
     py_bindmagic(type, __getitem__, locals__getitem__);
     py_bindmagic(type, __setitem__, locals__setitem__);
@@ -9,7 +9,56 @@ bool pk__object_new(int argc, py_Ref argv) {
     if(!ti->is_python) {
         return TypeError("object.__new__(%t) is not safe, use %t.__new__() instead", cls, cls);
     }
-    py_newobject(py_retval(), cls, -1, 0);
+    pk__newinstance(py_retval(), cls);
+    return true;
+}
+
+void pk__newinstance(py_OutRef out, py_Type type) {
+    py_TypeInfo* ti = pk__type_info(type);
+    if(ti->slots >= 0) {
+        py_newobject(out, type, ti->slots, 0);
+        return;
+    }
+    int capacity = c11__min(ti->shape->max_length, kShapeMaxInline);
+    py_newobject(out, type, -2 - capacity, 0);
+}
+
+bool pk__tp_init_slots(py_Type type) {
+    py_TypeInfo* ti = pk__type_info(type);
+    py_TypeInfo* base_ti = ti->base_ti;
+    // a subclass without `__slots__` inherits the layout of its base class
+    ti->slots = base_ti->slots;
+    py_Ref slots = py_getdict(&ti->self, py_name("__slots__"));
+    if(slots == NULL || !ti->is_python) return true;
+    // instances keep their `__dict__` if the base class has one
+    if(ti->base != tp_object && base_ti->slots < 0) return true;
+
+    py_Ref names;
+    int length;
+    if(py_isstr(slots)) {
+        names = slots;
+        length = 1;
+    } else if(py_istuple(slots)) {
+        names = py_tuple_data(slots);
+        length = py_tuple_len(slots);
+    } else if(py_islist(slots)) {
+        names = py_list_data(slots);
+        length = py_list_len(slots);
+    } else {
+        return TypeError("'__slots__' must be a str, tuple or list, not '%t'", slots->type);
+    }
+
+    int offset = c11__max(base_ti->slots, 0);
+    for(int i = 0; i < length; i++) {
+        if(!py_checkstr(names + i)) return false;
+        py_Name name = py_namev(py_tosv(names + i));
+        if(py_getdict(&ti->self, name)) {
+            return ValueError("'%n' in __slots__ conflicts with class variable", name);
+        }
+        py_Ref member = py_emplacedict(&ti->self, name);
+        *(int*)py_newobject(member, tp_member_descriptor, 0, sizeof(int)) = offset + i;
+    }
+    ti->slots = offset + length;
     return true;
 }
 
@@ -46,7 +95,7 @@ static bool object__repr__(int argc, py_Ref argv) {
 
 static bool object__dict__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    if(argv->is_ptr && argv->_obj->slots == -1) {
+    if(argv->is_ptr && argv->_obj->slots < 0) {
         pk_mappingproxy__namedict(py_retval(), argv);
     } else {
         py_newnone(py_retval());
@@ -85,18 +85,38 @@ int py_next(py_Ref val) {
 }
 
 bool py_getattr(py_Ref self, py_Name name) {
+    return pk_getattr_clsvar(self, name, py_tpfindname(self->type, name));
+}
+
+/// The slot of `self` described by the member descriptor `member`, or `NULL` with an error set.
+static py_Ref pk_member__slot(py_Ref self, py_Name name, py_Ref member) {
+    int index = *(int*)py_touserdata(member);
+    if(!self->is_ptr || index >= self->_obj->slots) {
+        TypeError("descriptor '%n' doesn't apply to a '%t' object", name, self->type);
+        return NULL;
+    }
+    return PyObject__slots(self->_obj) + index;
+}
+
+bool pk_getattr_clsvar(py_Ref self, py_Name name, py_Ref cls_var) {
     // https://docs.python.org/3/howto/descriptor.html#invocation-from-an-instance
     py_Type type = self->type;
-    py_Ref cls_var = py_tpfindname(type, name);
     if(cls_var) {
         // handle descriptor
         if(py_istype(cls_var, tp_property)) {
             py_Ref getter = py_getslot(cls_var, 0);
             return py_call(getter, 1, self);
         }
+        if(py_istype(cls_var, tp_member_descriptor)) {
+            py_Ref slot = pk_member__slot(self, name, cls_var);
+            if(!slot) return false;
+            if(py_isnil(slot)) return AttributeError(self, name);
+            py_assign(py_retval(), slot);
+            return true;
+        }
     }
     // handle instance __dict__
-    if(self->is_ptr && self->_obj->slots == -1) {
+    if(self->is_ptr && self->_obj->slots < 0) {
         if(!py_istype(self, tp_type)) {
             py_Ref res = py_getdict(self, name);
             if(res) {
@@ -176,8 +196,10 @@ bool py_getattr(py_Ref self, py_Name name) {
 }
 
 bool py_setattr(py_Ref self, py_Name name, py_Ref val) {
-    py_Type type = self->type;
-    py_Ref cls_var = py_tpfindname(type, name);
+    return pk_setattr_clsvar(self, name, val, py_tpfindname(self->type, name));
+}
+
+bool pk_setattr_clsvar(py_Ref self, py_Name name, py_Ref val, py_Ref cls_var) {
     if(cls_var) {
         // handle descriptor
         if(py_istype(cls_var, tp_property)) {
@@ -191,22 +213,40 @@ bool py_setattr(py_Ref self, py_Name name, py_Ref val) {
                 return TypeError("readonly attribute: '%n'", name);
             }
         }
+        if(py_istype(cls_var, tp_member_descriptor)) {
+            py_Ref slot = pk_member__slot(self, name, cls_var);
+            if(!slot) return false;
+            *slot = *val;
+            pk__gc_barrier(self->_obj);
+            return true;
+        }
     }
 
     // handle instance __dict__
-    if(self->is_ptr && self->_obj->slots == -1) {
+    if(self->is_ptr && self->_obj->slots < 0) {
         py_setdict(self, name, val);
         return true;
     }
 
+    // not declared by `__slots__`
+    if(pk__type_info(self->type)->slots >= 0) return AttributeError(self, name);
     return TypeError("cannot set attribute");
 }
 
 bool py_delattr(py_Ref self, py_Name name) {
-    if(self->is_ptr && self->_obj->slots == -1) {
+    if(self->is_ptr && self->_obj->slots < 0) {
         if(py_deldict(self, name)) return true;
         return AttributeError(self, name);
     }
+    py_Ref cls_var = py_tpfindname(self->type, name);
+    if(cls_var && py_istype(cls_var, tp_member_descriptor)) {
+        py_Ref slot = pk_member__slot(self, name, cls_var);
+        if(!slot) return false;
+        if(py_isnil(slot)) return AttributeError(self, name);
+        py_newnil(slot);
+        return true;
+    }
+    if(pk__type_info(self->type)->slots >= 0) return AttributeError(self, name);
     return TypeError("cannot delete attribute");
 }
 
@@ -242,6 +282,9 @@ int py_equal(py_Ref lhs, py_Ref rhs) {
 }
 
 int py_less(py_Ref lhs, py_Ref rhs) {
+    // fast path for numbers, used heavily by `heapq` and `list.sort()`
+    if(lhs->type == tp_int && rhs->type == tp_int) return lhs->_i64 < rhs->_i64;
+    if(lhs->type == tp_float && rhs->type == tp_float) return lhs->_f64 < rhs->_f64;
     if(!py_lt(lhs, rhs)) return -1;
     return py_bool(py_retval());
 }
\ No newline at end of file
@@ -39,6 +39,11 @@ static bool property_fset(int argc, py_Ref argv) {
     return true;
 }
 
+py_Type pk_member_descriptor__register() {
+    // created by `__slots__`, see `pk__tp_init_slots()`
+    return pk_newtype("member_descriptor", tp_object, NULL, NULL, false, true);
+}
+
 py_Type pk_property__register() {
     py_Type type = pk_newtype("property", tp_object, NULL, NULL, false, true);
 
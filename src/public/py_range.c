@@ -54,6 +54,15 @@ py_Type pk_range__register() {
     return type;
 }
 
+bool pk_rangeview(py_Ref self, py_i64* start, py_i64* stop, py_i64* step) {
+    if(self->type != tp_range) return false;
+    Range* ud = py_touserdata(self);
+    *start = ud->start;
+    *stop = ud->stop;
+    *step = ud->step;
+    return true;
+}
+
 typedef struct RangeIterator {
     Range range;
     py_i64 current;
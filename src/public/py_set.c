@@ -0,0 +1,648 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/utils.h"
+#include "pocketpy/common/sstream.h"
+#include "pocketpy/objects/object.h"
+#include "pocketpy/objects/dict.h"
+#include "pocketpy/interpreter/vm.h"
+
+static bool Set__is_set(py_Ref val) {
+    if(val->type == tp_set || val->type == tp_frozenset) return true;
+    return py_isinstance(val, tp_set) || py_isinstance(val, tp_frozenset);
+}
+
+/// The builtin type of a set-like object, used as the type of derived results.
+static py_Type Set__kind(py_Ref val) {
+    return py_isinstance(val, tp_frozenset) ? tp_frozenset : tp_set;
+}
+
+static Dict* Set__new(py_OutRef out, py_Type type) {
+    int slots = (type == tp_set || type == tp_frozenset) ? 0 : -1;
+    Dict* ud = py_newobject(out, type, slots, sizeof(Dict));
+    Dict__ctor(ud, kDictGroupSize, 8);
+    return ud;
+}
+
+/// Add `key` into the set object `self`.
+static bool Set__add(py_Ref self, py_TValue* key) {
+    py_TValue nil = *py_NIL();
+    bool ok = Dict__set(py_touserdata(self), key, &nil);
+    pk__gc_barrier(self->_obj);
+    return ok;
+}
+
+static int Set__contains(Dict* self, py_TValue* key) {
+    DictEntry* entry;
+    if(!Dict__try_get(self, key, &entry)) return -1;
+    return entry != NULL;
+}
+
+/// Add all elements of `iterable` into the set object `self`.
+static bool Set__update(py_Ref self, py_Ref iterable) {
+    if(Set__is_set(iterable) || py_isdict(iterable)) {
+        Dict* ud = py_touserdata(self);
+        Dict* other = py_touserdata(iterable);
+        if(other == ud) return true;
+        if(ud->length == 0) {
+            Dict__dtor(ud);
+            Dict__copy(ud, other);
+            for(int i = 0; i < ud->entries.length; i++) {
+                c11__at(DictEntry, &ud->entries, i)->val = *py_NIL();
+            }
+            pk__gc_barrier(self->_obj);
+            return true;
+        }
+        DictIterator iter;
+        DictIterator__ctor(&iter, other);
+        while(1) {
+            DictEntry* entry = DictIterator__next(&iter);
+            if(!entry) break;
+            if(!Set__add(self, &entry->key)) return false;
+        }
+        return true;
+    }
+
+    py_TValue* p;
+    int length = pk_arrayview(iterable, &p);
+    if(length != -1) {
+        for(int i = 0; i < length; i++) {
+            if(!Set__add(self, &p[i])) return false;
+        }
+        return true;
+    }
+
+    if(!py_iter(iterable)) return false;
+    py_push(py_retval());
+    while(true) {
+        int res = py_next(py_peek(-1));
+        if(res == -1) return false;
+        if(!res) break;
+        py_TValue key = *py_retval();  // `py_hash` may overwrite `py_retval()`
+        if(!Set__add(self, &key)) return false;
+    }
+    py_pop();
+    return true;
+}
+
+/// Push a set view of `iterable` onto the stack, building a temporary `frozenset` if needed.
+/// The caller should pop it after use.
+static Dict* Set__push_view(py_Ref iterable) {
+    py_Ref tmp = py_pushtmp();
+    if(Set__is_set(iterable)) {
+        *tmp = *iterable;
+        return py_touserdata(tmp);
+    }
+    Dict* ud = Set__new(tmp, tp_frozenset);
+    if(!Set__update(tmp, iterable)) return NULL;
+    return ud;
+}
+
+/// Discard all elements of `other` from `self`.
+static bool Set__difference_update(Dict* self, Dict* other) {
+    if(other == self) {
+        Dict__clear(self);
+        return true;
+    }
+    DictIterator iter;
+    DictIterator__ctor(&iter, other);
+    while(1) {
+        DictEntry* entry = DictIterator__next(&iter);
+        if(!entry) break;
+        if(Dict__pop(self, &entry->key) == -1) return false;
+    }
+    return true;
+}
+
+/// Store the elements of `a` which are also in `b` into the set object `out`.
+static bool Set__intersection(py_Ref out, Dict* a, Dict* b) {
+    // iterate over the smaller one
+    if(a->length > b->length) {
+        Dict* tmp = a;
+        a = b;
+        b = tmp;
+    }
+    DictIterator iter;
+    DictIterator__ctor(&iter, a);
+    while(1) {
+        DictEntry* entry = DictIterator__next(&iter);
+        if(!entry) break;
+        int res = Set__contains(b, &entry->key);
+        if(res == -1) return false;
+        if(res && !Set__add(out, &entry->key)) return false;
+    }
+    return true;
+}
+
+/// Toggle the elements of `other` in the set object `self`.
+static bool Set__symmetric_difference_update(py_Ref self, Dict* other) {
+    Dict* ud = py_touserdata(self);
+    if(other == ud) {
+        Dict__clear(ud);
+        return true;
+    }
+    DictIterator iter;
+    DictIterator__ctor(&iter, other);
+    while(1) {
+        DictEntry* entry = DictIterator__next(&iter);
+        if(!entry) break;
+        int res = Dict__pop(ud, &entry->key);
+        if(res == -1) return false;
+        if(res == 0 && !Set__add(self, &entry->key)) return false;
+    }
+    return true;
+}
+
+/// 1 if every element of `a` is in `b`, 0 if not, -1 on error.
+static int Set__issubset(Dict* a, Dict* b) {
+    if(a->length > b->length) return 0;
+    DictIterator iter;
+    DictIterator__ctor(&iter, a);
+    while(1) {
+        DictEntry* entry = DictIterator__next(&iter);
+        if(!entry) break;
+        int res = Set__contains(b, &entry->key);
+        if(res != 1) return res;
+    }
+    return 1;
+}
+
+///////////////////////////////
+static bool set__new__(int argc, py_Ref argv) {
+    Set__new(py_retval(), py_totype(argv));
+    return true;
+}
+
+static bool set__init__(int argc, py_Ref argv) {
+    if(argc > 2) return TypeError("set() takes at most 1 argument (%d given)", argc - 1);
+    if(argc == 2) {
+        Dict__clear(py_touserdata(argv));
+        if(!Set__update(argv, py_arg(1))) return false;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool frozenset__init__(int argc, py_Ref argv) {
+    if(argc > 2) return TypeError("frozenset() takes at most 1 argument (%d given)", argc - 1);
+    if(argc == 2) {
+        Dict* self = py_touserdata(argv);
+        if(self->length != 0) return TypeError("frozenset is immutable");
+        if(!Set__update(argv, py_arg(1))) return false;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set__len__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    py_newint(py_retval(), self->length);
+    return true;
+}
+
+static bool set__contains__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = Set__contains(py_touserdata(argv), py_arg(1));
+    if(res == -1) return false;
+    py_newbool(py_retval(), res);
+    return true;
+}
+
+static bool set__iter__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    int* index = py_newobject(py_retval(), tp_set_iterator, 1, sizeof(int));
+    *index = 0;
+    py_setslot(py_retval(), 0, argv);  // keep a reference to the set
+    return true;
+}
+
+static bool set__repr__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    bool is_frozen = Set__kind(argv) == tp_frozenset;
+    if(self->length == 0) {
+        py_newstr(py_retval(), is_frozen ? "frozenset()" : "set()");
+        return true;
+    }
+    c11_sbuf buf;
+    c11_sbuf__ctor(&buf);
+    if(is_frozen) c11_sbuf__write_cstr(&buf, "frozenset(");
+    c11_sbuf__write_char(&buf, '{');
+    bool is_first = true;
+    DictIterator iter;
+    DictIterator__ctor(&iter, self);
+    while(1) {
+        DictEntry* entry = DictIterator__next(&iter);
+        if(!entry) break;
+        if(!is_first) c11_sbuf__write_cstr(&buf, ", ");
+        if(!py_repr(&entry->key)) {
+            c11_sbuf__dtor(&buf);
+            return false;
+        }
+        c11_sbuf__write_sv(&buf, py_tosv(py_retval()));
+        is_first = false;
+    }
+    c11_sbuf__write_char(&buf, '}');
+    if(is_frozen) c11_sbuf__write_char(&buf, ')');
+    c11_sbuf__py_submit(&buf, py_retval());
+    return true;
+}
+
+static bool frozenset__hash__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    // order-independent, so equal sets always have the same hash
+    uint64_t x = 1927868237ULL * (self->length + 1);
+    DictIterator iter;
+    DictIterator__ctor(&iter, self);
+    while(1) {
+        DictEntry* entry = DictIterator__next(&iter);
+        if(!entry) break;
+        uint64_t y = entry->hash;
+        x ^= (y ^ (y << 16) ^ 89869747ULL) * 3644798167ULL;
+    }
+    py_newint(py_retval(), x);
+    return true;
+}
+
+#define DEF_SET_COMPARE(name, a, b, strict)                                                        \
+    static bool set##name(int argc, py_Ref argv) {                                                 \
+        PY_CHECK_ARGC(2);                                                                          \
+        if(!Set__is_set(py_arg(1))) {                                                              \
+            py_newnotimplemented(py_retval());                                                     \
+            return true;                                                                           \
+        }                                                                                          \
+        Dict* lhs = py_touserdata(a);                                                              \
+        Dict* rhs = py_touserdata(b);                                                              \
+        if(strict && lhs->length == rhs->length) {                                                 \
+            py_newbool(py_retval(), false);                                                        \
+            return true;                                                                           \
+        }                                                                                          \
+        int res = Set__issubset(lhs, rhs);                                                         \
+        if(res == -1) return false;                                                                \
+        py_newbool(py_retval(), res);                                                              \
+        return true;                                                                               \
+    }
+
+DEF_SET_COMPARE(__le__, py_arg(0), py_arg(1), false)
+DEF_SET_COMPARE(__lt__, py_arg(0), py_arg(1), true)
+DEF_SET_COMPARE(__ge__, py_arg(1), py_arg(0), false)
+DEF_SET_COMPARE(__gt__, py_arg(1), py_arg(0), true)
+
+#undef DEF_SET_COMPARE
+
+static bool set__eq__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Set__is_set(py_arg(1))) {
+        py_newnotimplemented(py_retval());
+        return true;
+    }
+    Dict* self = py_touserdata(py_arg(0));
+    Dict* other = py_touserdata(py_arg(1));
+    if(self->length != other->length) {
+        py_newbool(py_retval(), false);
+        return true;
+    }
+    int res = Set__issubset(self, other);
+    if(res == -1) return false;
+    py_newbool(py_retval(), res);
+    return true;
+}
+
+static bool set__ne__(int argc, py_Ref argv) {
+    if(!set__eq__(argc, argv)) return false;
+    if(py_isbool(py_retval())) {
+        bool res = py_tobool(py_retval());
+        py_newbool(py_retval(), !res);
+    }
+    return true;
+}
+
+/* set algebra */
+static bool set_copy(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    Dict* ud = py_newobject(py_retval(), Set__kind(argv), 0, sizeof(Dict));
+    Dict__copy(ud, self);
+    return true;
+}
+
+static bool set_union(int argc, py_Ref argv) {
+    if(!set_copy(1, argv)) return false;
+    py_push(py_retval());
+    for(int i = 1; i < argc; i++) {
+        if(!Set__update(py_peek(-1), py_arg(i))) return false;
+    }
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+static bool set_intersection(int argc, py_Ref argv) {
+    if(argc == 1) return set_copy(1, argv);
+    py_push(argv);
+    for(int i = 1; i < argc; i++) {
+        Dict* other = Set__push_view(py_arg(i));
+        if(!other) return false;
+        py_Ref curr = py_peek(-2);
+        Set__new(py_pushtmp(), Set__kind(argv));
+        if(!Set__intersection(py_peek(-1), py_touserdata(curr), other)) return false;
+        *curr = *py_peek(-1);
+        py_shrink(2);
+    }
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+static bool set_difference(int argc, py_Ref argv) {
+    if(!set_copy(1, argv)) return false;
+    py_push(py_retval());
+    Dict* ud = py_touserdata(py_peek(-1));
+    for(int i = 1; i < argc; i++) {
+        Dict* other = Set__push_view(py_arg(i));
+        if(!other) return false;
+        if(!Set__difference_update(ud, other)) return false;
+        py_pop();
+    }
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+static bool set_symmetric_difference(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!set_copy(1, argv)) return false;
+    py_push(py_retval());
+    Dict* other = Set__push_view(py_arg(1));
+    if(!other) return false;
+    if(!Set__symmetric_difference_update(py_peek(-2), other)) return false;
+    py_pop();
+    py_assign(py_retval(), py_peek(-1));
+    py_pop();
+    return true;
+}
+
+static bool set_isdisjoint(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    Dict* other = Set__push_view(py_arg(1));
+    if(!other) return false;
+    Dict* self = py_touserdata(argv);
+    Dict* ud = Set__new(py_pushtmp(), tp_frozenset);
+    if(!Set__intersection(py_peek(-1), self, other)) return false;
+    py_newbool(py_retval(), ud->length == 0);
+    py_shrink(2);
+    return true;
+}
+
+static bool set_issubset(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    Dict* other = Set__push_view(py_arg(1));
+    if(!other) return false;
+    int res = Set__issubset(py_touserdata(argv), other);
+    if(res == -1) return false;
+    py_newbool(py_retval(), res);
+    py_pop();
+    return true;
+}
+
+static bool set_issuperset(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    Dict* other = Set__push_view(py_arg(1));
+    if(!other) return false;
+    int res = Set__issubset(other, py_touserdata(argv));
+    if(res == -1) return false;
+    py_newbool(py_retval(), res);
+    py_pop();
+    return true;
+}
+
+#define DEF_SET_BINARY_OP(name, f)                                                                 \
+    static bool set##name(int argc, py_Ref argv) {                                                 \
+        PY_CHECK_ARGC(2);                                                                          \
+        if(!Set__is_set(py_arg(1))) {                                                              \
+            py_newnotimplemented(py_retval());                                                     \
+            return true;                                                                           \
+        }                                                                                          \
+        return f(argc, argv);                                                                      \
+    }
+
+DEF_SET_BINARY_OP(__or__, set_union)
+DEF_SET_BINARY_OP(__and__, set_intersection)
+DEF_SET_BINARY_OP(__sub__, set_difference)
+DEF_SET_BINARY_OP(__xor__, set_symmetric_difference)
+
+#undef DEF_SET_BINARY_OP
+
+/* mutating methods (set only) */
+static bool set_add(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(!Set__add(argv, py_arg(1))) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_discard(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(Dict__pop(py_touserdata(argv), py_arg(1)) == -1) return false;
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_remove(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    int res = Dict__pop(py_touserdata(argv), py_arg(1));
+    if(res == -1) return false;
+    if(res == 0) return KeyError(py_arg(1));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_pop(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict* self = py_touserdata(argv);
+    DictIterator iter;
+    DictIterator__ctor(&iter, self);
+    DictEntry* entry = DictIterator__next(&iter);
+    if(!entry) {
+        py_Ref msg = py_pushtmp();
+        py_newstr(msg, "pop from an empty set");
+        bool ok = KeyError(msg);
+        py_pop();
+        return ok;
+    }
+    py_TValue key = entry->key;
+    if(Dict__pop(self, &key) == -1) return false;
+    py_assign(py_retval(), &key);
+    return true;
+}
+
+static bool set_clear(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    Dict__clear(py_touserdata(argv));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_update(int argc, py_Ref argv) {
+    for(int i = 1; i < argc; i++) {
+        if(!Set__update(argv, py_arg(i))) return false;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_intersection_update(int argc, py_Ref argv) {
+    if(!set_intersection(argc, argv)) return false;
+    Dict* self = py_touserdata(argv);
+    Dict* res = py_touserdata(py_retval());
+    // swap the contents so that `res` owns (and later frees) the old buffers
+    Dict tmp = *self;
+    *self = *res;
+    *res = tmp;
+    pk__gc_barrier(argv->_obj);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_difference_update(int argc, py_Ref argv) {
+    Dict* self = py_touserdata(argv);
+    for(int i = 1; i < argc; i++) {
+        Dict* other = Set__push_view(py_arg(i));
+        if(!other) return false;
+        if(!Set__difference_update(self, other)) return false;
+        py_pop();
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool set_symmetric_difference_update(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    Dict* other = Set__push_view(py_arg(1));
+    if(!other) return false;
+    if(!Set__symmetric_difference_update(argv, other)) return false;
+    py_pop();
+    py_newnone(py_retval());
+    return true;
+}
+
+static void set__gc_mark(void* ud) {
+    Dict* self = ud;
+    for(int i = 0; i < self->entries.length; i++) {
+        DictEntry* entry = c11__at(DictEntry, &self->entries, i);
+        if(py_isnil(&entry->key)) continue;
+        pk__mark_value(&entry->key);
+    }
+}
+
+static bool set__clone(void* ud) {
+    pk__clone_dict(ud, true);
+    return true;
+}
+
+static void pk__bind_set_common(py_Type type) {
+    pk__tp_set_marker(type, set__gc_mark);
+    pk__tp_set_cloner(type, set__clone);
+
+    py_bindmagic(type, __new__, set__new__);
+    py_bindmagic(type, __len__, set__len__);
+    py_bindmagic(type, __contains__, set__contains__);
+    py_bindmagic(type, __iter__, set__iter__);
+    py_bindmagic(type, __repr__, set__repr__);
+    py_bindmagic(type, __eq__, set__eq__);
+    py_bindmagic(type, __ne__, set__ne__);
+    py_bindmagic(type, __le__, set__le__);
+    py_bindmagic(type, __lt__, set__lt__);
+    py_bindmagic(type, __ge__, set__ge__);
+    py_bindmagic(type, __gt__, set__gt__);
+    py_bindmagic(type, __or__, set__or__);
+    py_bindmagic(type, __and__, set__and__);
+    py_bindmagic(type, __sub__, set__sub__);
+    py_bindmagic(type, __xor__, set__xor__);
+
+    py_bindmethod(type, "copy", set_copy);
+    py_bindmethod(type, "union", set_union);
+    py_bindmethod(type, "intersection", set_intersection);
+    py_bindmethod(type, "difference", set_difference);
+    py_bindmethod(type, "symmetric_difference", set_symmetric_difference);
+    py_bindmethod(type, "isdisjoint", set_isdisjoint);
+    py_bindmethod(type, "issubset", set_issubset);
+    py_bindmethod(type, "issuperset", set_issuperset);
+}
+
+py_Type pk_set__register() {
+    py_Type type = pk_newtype("set", tp_object, NULL, (void (*)(void*))Dict__dtor, false, false);
+    pk__bind_set_common(type);
+
+    py_bindmagic(type, __init__, set__init__);
+
+    py_bindmethod(type, "add", set_add);
+    py_bindmethod(type, "discard", set_discard);
+    py_bindmethod(type, "remove", set_remove);
+    py_bindmethod(type, "pop", set_pop);
+    py_bindmethod(type, "clear", set_clear);
+    py_bindmethod(type, "update", set_update);
+    py_bindmethod(type, "intersection_update", set_intersection_update);
+    py_bindmethod(type, "difference_update", set_difference_update);
+    py_bindmethod(type, "symmetric_difference_update", set_symmetric_difference_update);
+
+    py_setdict(py_tpobject(type), __hash__, py_None());
+    return type;
+}
+
+py_Type pk_frozenset__register() {
+    py_Type type =
+        pk_newtype("frozenset", tp_object, NULL, (void (*)(void*))Dict__dtor, false, false);
+    pk__bind_set_common(type);
+
+    py_bindmagic(type, __init__, frozenset__init__);
+    py_bindmagic(type, __hash__, frozenset__hash__);
+    return type;
+}
+
+//////////////////////////
+static bool set_iterator__next__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(1);
+    int* index = py_touserdata(argv);
+    Dict* set = py_touserdata(py_getslot(argv, 0));
+    while(*index < set->entries.length) {
+        DictEntry* entry = c11__at(DictEntry, &set->entries, *index);
+        (*index)++;
+        if(py_isnil(&entry->key)) continue;
+        py_assign(py_retval(), &entry->key);
+        return true;
+    }
+    return StopIteration();
+}
+
+py_Type pk_set_iterator__register() {
+    py_Type type = pk_newtype("set_iterator", tp_object, NULL, NULL, false, true);
+    py_bindmagic(type, __iter__, pk_wrapper__self);
+    py_bindmagic(type, __next__, set_iterator__next__);
+    return type;
+}
+
+//////////////////////////
+void py_newset(py_OutRef out) { Set__new(out, tp_set); }
+
+int py_set_contains(py_Ref self, py_Ref key) {
+    assert(Set__is_set(self));
+    return Set__contains(py_touserdata(self), key);
+}
+
+bool py_set_add(py_Ref self, py_Ref key) {
+    assert(py_isinstance(self, tp_set));
+    return Set__add(self, key);
+}
+
+int py_set_discard(py_Ref self, py_Ref key) {
+    assert(py_isinstance(self, tp_set));
+    return Dict__pop(py_touserdata(self), key);
+}
+
+int py_set_len(py_Ref self) {
+    assert(Set__is_set(self));
+    Dict* ud = py_touserdata(self);
+    return ud->length;
+}
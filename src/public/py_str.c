@@ -104,13 +104,8 @@ static bool str__new__(int argc, py_Ref argv) {
 
 static bool str__hash__(int argc, py_Ref argv) {
     PY_CHECK_ARGC(1);
-    int size;
-    const char* data = py_tostrn(&argv[0], &size);
-    uint64_t res = 0;
-    for(int i = 0; i < size; i++) {
-        res = res * 31 + data[i];
-    }
-    py_newint(py_retval(), res);
+    c11_string* self = py_touserdata(&argv[0]);
+    py_newint(py_retval(), c11_string__hash(self));
     return true;
 }
 
@@ -131,6 +126,7 @@ static bool str__add__(int argc, py_Ref argv) {
         int total_size = sizeof(c11_string) + self->size + other->size + 1;
         c11_string* res = py_newobject(py_retval(), tp_str, 0, total_size);
         res->size = self->size + other->size;
+        res->hash = 0;
         char* p = res->data;
         memcpy(p, self->data, self->size);
         memcpy(p + self->size, other->data, other->size);
@@ -152,6 +148,7 @@ static bool str__mul__(int argc, py_Ref argv) {
             int total_size = sizeof(c11_string) + self->size * n + 1;
             c11_string* res = py_newobject(py_retval(), tp_str, 0, total_size);
             res->size = self->size * n;
+            res->hash = 0;
             char* p = res->data;
             for(int i = 0; i < n; i++) {
                 memcpy(p + i * self->size, self->data, self->size);
@@ -237,8 +234,22 @@ static bool str__getitem__(int argc, py_Ref argv) {
         return true;                                                                               \
     }
 
-DEF_STR_CMP_OP(__eq__, c11__sveq, res)
-DEF_STR_CMP_OP(__ne__, c11__sveq, !res)
+static bool str__eq__(int argc, py_Ref argv) {
+    PY_CHECK_ARGC(2);
+    if(py_arg(1)->type != tp_str) {
+        py_newnotimplemented(py_retval());
+    } else {
+        py_newbool(py_retval(), c11_string__eq(py_touserdata(&argv[0]), py_touserdata(&argv[1])));
+    }
+    return true;
+}
+
+static bool str__ne__(int argc, py_Ref argv) {
+    if(!str__eq__(argc, argv)) return false;
+    if(py_isbool(py_retval())) py_newbool(py_retval(), !py_tobool(py_retval()));
+    return true;
+}
+
 DEF_STR_CMP_OP(__lt__, c11_sv__cmp, res < 0)
 DEF_STR_CMP_OP(__le__, c11_sv__cmp, res <= 0)
 DEF_STR_CMP_OP(__gt__, c11_sv__cmp, res > 0)
@@ -252,6 +263,7 @@ static bool str_lower(int argc, py_Ref argv) {
     int total_size = sizeof(c11_string) + self->size + 1;
     c11_string* res = py_newobject(py_retval(), tp_str, 0, total_size);
     res->size = self->size;
+    res->hash = 0;
     char* p = res->data;
     for(int i = 0; i < self->size; i++) {
         char c = self->data[i];
@@ -267,6 +279,7 @@ static bool str_upper(int argc, py_Ref argv) {
     int total_size = sizeof(c11_string) + self->size + 1;
     c11_string* res = py_newobject(py_retval(), tp_str, 0, total_size);
     res->size = self->size;
+    res->hash = 0;
     char* p = res->data;
     for(int i = 0; i < self->size; i++) {
         char c = self->data[i];
@@ -13,7 +13,10 @@ void py_newtuple(py_Ref out, int n) {
     out->_obj = obj;
 }
 
-py_Ref py_tuple_getitem(py_Ref self, int i) { return py_getslot(self, i); }
+py_Ref py_tuple_getitem(py_Ref self, int i) {
+    assert(i >= 0 && i < self->_obj->slots);
+    return PyObject__slots(self->_obj) + i;
+}
 
 py_Ref py_tuple_data(py_Ref self) { return PyObject__slots(self->_obj); }
 
@@ -11,6 +11,9 @@ void py_setreg(int i, py_Ref val) { pk_current_vm->reg[i] = *val; }
 py_Ref py_getdict(py_Ref self, py_Name name) {
     assert(self && self->is_ptr);
     if(!py_ismagicname(name) || self->type != tp_type) {
+        if(self->_obj->slots <= -2) {
+            return InstanceDict__try_get(PyObject__instancedict(self->_obj), name);
+        }
         return NameDict__try_get(PyObject__dict(self->_obj), name);
     } else {
         py_Type* ud = py_touserdata(self);
@@ -21,8 +24,18 @@ py_Ref py_getdict(py_Ref self, py_Name name) {
 
 void py_setdict(py_Ref self, py_Name name, py_Ref val) {
     assert(self && self->is_ptr);
+    if(self->type == tp_type) pk_current_vm->type_version++;
     if(!py_ismagicname(name) || self->type != tp_type) {
-        NameDict__set(PyObject__dict(self->_obj), name, *val);
+        if(self->_obj->slots <= -2) {
+            InstanceDict__set(PyObject__instancedict(self->_obj), name, *val);
+            pk__gc_barrier(self->_obj);
+            return;
+        }
+        NameDict* dict = PyObject__dict(self->_obj);
+        int length = dict->length;
+        NameDict__set(dict, name, *val);
+        pk__gc_barrier(self->_obj);
+        if(self->type == tp_module && dict->length != length) pk__module_touch(self);
     } else {
         py_Type* ud = py_touserdata(self);
         *py_tpgetmagic(*ud, name) = *val;
@@ -36,6 +49,15 @@ py_ItemRef py_emplacedict(py_Ref self, py_Name name){
 
 bool py_applydict(py_Ref self, bool (*f)(py_Name, py_Ref, void *), void *ctx){
     assert(self && self->is_ptr);
+    if(self->_obj->slots <= -2) {
+        InstanceDict* dict = PyObject__instancedict(self->_obj);
+        for(int i = 0; i < InstanceDict__length(dict); i++) {
+            py_Name name;
+            py_Ref value = InstanceDict__item(dict, i, &name);
+            if(!f(name, value, ctx)) return false;
+        }
+        return true;
+    }
     NameDict* dict = PyObject__dict(self->_obj);
     for(int i = 0; i < dict->length; i++){
         NameDict_KV* kv = c11__at(NameDict_KV, dict, i);
@@ -47,8 +69,14 @@ bool py_applydict(py_Ref self, bool (*f)(py_Name, py_Ref, void *), void *ctx){
 
 bool py_deldict(py_Ref self, py_Name name) {
     assert(self && self->is_ptr);
+    if(self->type == tp_type) pk_current_vm->type_version++;
     if(!py_ismagicname(name) || self->type != tp_type) {
-        return NameDict__del(PyObject__dict(self->_obj), name);
+        if(self->_obj->slots <= -2) {
+            return InstanceDict__del(PyObject__instancedict(self->_obj), name);
+        }
+        bool ok = NameDict__del(PyObject__dict(self->_obj), name);
+        if(ok && self->type == tp_module) pk__module_touch(self);
+        return ok;
     } else {
         py_Type* ud = py_touserdata(self);
         py_newnil(py_tpgetmagic(*ud, name));
@@ -66,6 +94,7 @@ void py_setslot(py_Ref self, int i, py_Ref val) {
     assert(self && self->is_ptr);
     assert(i >= 0 && i < self->_obj->slots);
     PyObject__slots(self->_obj)[i] = *val;
+    pk__gc_barrier(self->_obj);
 }
 
 py_StackRef py_inspect_currentfunction(){
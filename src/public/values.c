@@ -40,7 +40,10 @@ void py_newellipsis(py_Ref out) {
     out->is_ptr = false;
 }
 
-void py_newnil(py_Ref out) { out->type = 0; }
+void py_newnil(py_Ref out) {
+    out->type = 0;
+    out->is_ptr = false;
+}
 
 void py_newnativefunc(py_Ref out, py_CFunction f) {
     out->type = tp_nativefunc;
@@ -0,0 +1,240 @@
+#include "pocketpy/pocketpy.h"
+
+#include "pocketpy/common/threads.h"
+#include "pocketpy/common/utils.h"
+#include "pocketpy/interpreter/vm.h"
+
+#if PK_ENABLE_THREADS
+
+struct py_VMFuture {
+    c11_mutex mutex;
+    c11_cond cond;        // signaled when the task is done
+    int refcount;         // held by the submitter and by the pool until the task is done
+    bool done;
+    char* func_path;
+    unsigned char* data;  // the pickled args, then the pickled result
+    int size;
+    char* error;          // the formatted exception if the call failed
+    py_VMFuture* next;    // the next task in the queue
+};
+
+typedef struct {
+    py_VMPool* pool;
+    VM* vm;
+    c11_thrd thrd;
+} VMPool_Worker;
+
+struct py_VMPool {
+    c11_mutex mutex;
+    c11_cond cond;  // signaled when a task is queued or the pool is stopping
+    py_VMFuture* head;
+    py_VMFuture* tail;
+    bool stopping;
+    void (*init)(void* ctx);
+    void* ctx;
+    int size;
+    VMPool_Worker workers[];
+};
+
+static void py_VMFuture__decref(py_VMFuture* self) {
+    c11_mutex__lock(&self->mutex);
+    bool is_last = --self->refcount == 0;
+    c11_mutex__unlock(&self->mutex);
+    if(!is_last) return;
+    c11_cond__dtor(&self->cond);
+    c11_mutex__dtor(&self->mutex);
+    PK_FREE(self->func_path);
+    PK_FREE(self->data);
+    PK_FREE(self->error);
+    PK_FREE(self);
+}
+
+/// Call `func_path(*args)` in the current VM and pickle the result into `py_retval()`.
+static bool VMPool__call(py_VMFuture* task) {
+    // `func_path` is checked by `py_vmpool_submit()`
+    const char* dot = strrchr(task->func_path, '.');
+    char path[PK_MAX_MODULE_PATH_LEN + 1];
+    int path_len = (int)(dot - task->func_path);
+    memcpy(path, task->func_path, path_len);
+    path[path_len] = '\0';
+
+    int res = py_import(path);
+    if(res == -1) return false;
+    if(res == 0) return ImportError("module '%s' not found", path);
+    py_Ref func = py_pushtmp();
+    if(!py_getattr(py_retval(), py_name(dot + 1))) return false;
+    py_assign(func, py_retval());
+    if(!py_pickle_loads(task->data, task->size)) return false;
+    py_Ref args = py_pushtmp();
+    py_assign(args, py_retval());
+    if(!py_call(func, py_tuple_len(args), py_tuple_data(args))) return false;
+    if(!py_pickle_dumps(py_retval())) return false;
+    py_shrink(2);
+    return true;
+}
+
+static void VMPool__run(py_VMFuture* task) {
+    py_StackRef p0 = py_peek(0);
+    unsigned char* data = NULL;
+    int size = 0;
+    char* error = NULL;
+    if(VMPool__call(task)) {
+        unsigned char* bytes = py_tobytes(py_retval(), &size);
+        data = PK_MALLOC(size);
+        memcpy(data, bytes, size);
+    } else {
+        error = py_formatexc();
+        py_clearexc(p0);
+    }
+    c11_mutex__lock(&task->mutex);
+    PK_FREE(task->data);
+    task->data = data;
+    task->size = size;
+    task->error = error;
+    task->done = true;
+    c11_cond__broadcast(&task->cond);
+    c11_mutex__unlock(&task->mutex);
+}
+
+static void VMPool__worker(void* arg) {
+    VMPool_Worker* self = arg;
+    py_VMPool* pool = self->pool;
+    pk_current_vm = self->vm;
+    VM__ctor(self->vm);
+    if(pool->init) pool->init(pool->ctx);
+    while(true) {
+        c11_mutex__lock(&pool->mutex);
+        while(pool->head == NULL && !pool->stopping) {
+            c11_cond__wait(&pool->cond, &pool->mutex);
+        }
+        py_VMFuture* task = pool->head;
+        if(task != NULL) {
+            pool->head = task->next;
+            if(pool->head == NULL) pool->tail = NULL;
+        }
+        c11_mutex__unlock(&pool->mutex);
+        // the queue is drained before stopping
+        if(task == NULL) break;
+        VMPool__run(task);
+        py_VMFuture__decref(task);
+    }
+    VM__dtor(self->vm);
+    pk_current_vm = NULL;
+}
+
+py_VMPool* py_vmpool_new(int size, void (*init)(void* ctx), void* ctx) {
+    if(size <= 0) c11__abort("invalid pool size");
+    py_VMPool* self = PK_MALLOC(sizeof(py_VMPool) + sizeof(VMPool_Worker) * size);
+    c11_mutex__ctor(&self->mutex);
+    c11_cond__ctor(&self->cond);
+    self->head = NULL;
+    self->tail = NULL;
+    self->stopping = false;
+    self->init = init;
+    self->ctx = ctx;
+    self->size = 0;
+    for(int i = 0; i < size; i++) {
+        VMPool_Worker* worker = &self->workers[i];
+        worker->pool = self;
+        worker->vm = PK_MALLOC(sizeof(VM));
+        memset(worker->vm, 0, sizeof(VM));
+        if(!c11_thrd__create(&worker->thrd, VMPool__worker, worker)) {
+            PK_FREE(worker->vm);
+            py_vmpool_delete(self);
+            return NULL;
+        }
+        self->size++;
+    }
+    return self;
+}
+
+void py_vmpool_delete(py_VMPool* self) {
+    c11_mutex__lock(&self->mutex);
+    self->stopping = true;
+    c11_cond__broadcast(&self->cond);
+    c11_mutex__unlock(&self->mutex);
+    for(int i = 0; i < self->size; i++) {
+        c11_thrd__join(&self->workers[i].thrd);
+        PK_FREE(self->workers[i].vm);
+    }
+    c11_cond__dtor(&self->cond);
+    c11_mutex__dtor(&self->mutex);
+    PK_FREE(self);
+}
+
+py_VMFuture* py_vmpool_submit(py_VMPool* self, const char* func_path, py_Ref args) {
+    const char* dot = strrchr(func_path, '.');
+    if(dot == NULL || dot == func_path || dot[1] == '\0') {
+        ValueError("expected 'module.func', got '%s'", func_path);
+        return NULL;
+    }
+    if(dot - func_path > PK_MAX_MODULE_PATH_LEN) {
+        ValueError("module path too long: %s", func_path);
+        return NULL;
+    }
+    if(!py_checktype(args, tp_tuple)) return NULL;
+    if(!py_pickle_dumps(args)) return NULL;
+
+    py_VMFuture* task = PK_MALLOC(sizeof(py_VMFuture));
+    c11_mutex__ctor(&task->mutex);
+    c11_cond__ctor(&task->cond);
+    task->refcount = 2;
+    task->done = false;
+    int func_path_size = (int)strlen(func_path) + 1;
+    task->func_path = PK_MALLOC(func_path_size);
+    memcpy(task->func_path, func_path, func_path_size);
+    unsigned char* bytes = py_tobytes(py_retval(), &task->size);
+    task->data = PK_MALLOC(task->size);
+    memcpy(task->data, bytes, task->size);
+    task->error = NULL;
+    task->next = NULL;
+
+    c11_mutex__lock(&self->mutex);
+    if(self->tail == NULL) {
+        self->head = task;
+    } else {
+        self->tail->next = task;
+    }
+    self->tail = task;
+    c11_cond__signal(&self->cond);
+    c11_mutex__unlock(&self->mutex);
+    return task;
+}
+
+bool py_vmfuture_done(py_VMFuture* self) {
+    c11_mutex__lock(&self->mutex);
+    bool done = self->done;
+    c11_mutex__unlock(&self->mutex);
+    return done;
+}
+
+bool py_vmfuture_result(py_VMFuture* self) {
+    c11_mutex__lock(&self->mutex);
+    while(!self->done) {
+        c11_cond__wait(&self->cond, &self->mutex);
+    }
+    c11_mutex__unlock(&self->mutex);
+    if(self->error) return RuntimeError("%s", self->error);
+    return py_pickle_loads(self->data, self->size);
+}
+
+void py_vmfuture_delete(py_VMFuture* self) { py_VMFuture__decref(self); }
+
+#else
+
+py_VMPool* py_vmpool_new(int size, void (*init)(void* ctx), void* ctx) { return NULL; }
+
+void py_vmpool_delete(py_VMPool* self) {}
+
+py_VMFuture* py_vmpool_submit(py_VMPool* self, const char* func_path, py_Ref args) {
+    RuntimeError("threads are not supported");
+    return NULL;
+}
+
+bool py_vmfuture_done(py_VMFuture* self) { return false; }
+
+bool py_vmfuture_result(py_VMFuture* self) { return RuntimeError("threads are not supported"); }
+
+void py_vmfuture_delete(py_VMFuture* self) {}
+
+#endif
@@ -0,0 +1,61 @@
+#include "pocketpy.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Measures the cost of a fresh VM, e.g. one per sandboxed script.
+// Usage: vm_startup [count]
+
+static double now_us() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000;
+    if(count <= 0) return 1;
+
+    py_initialize();
+    double t0 = now_us();
+    for(int i = 1; i <= count; i++) {
+        py_switchvm(i);
+    }
+    double t1 = now_us();
+    // a VM which runs a little code
+    py_switchvm(0);
+    for(int i = 0; i < count; i++) {
+        py_resetvm();
+        bool ok = py_exec("import math\nx = math.sqrt(4)", "<vm_startup>", EXEC_MODE, NULL);
+        if(!ok) {
+            py_printexc();
+            return 1;
+        }
+    }
+    double t2 = now_us();
+    // clones of a VM which imported the same module
+    py_resetvm();
+    if(!py_exec("import math", "<vm_startup>", EXEC_MODE, NULL)) {
+        py_printexc();
+        return 1;
+    }
+    for(int i = 1; i <= count; i++) {
+        bool ok = py_clonevm(count + i, 0) &&
+                  py_exec("x = math.sqrt(4)", "<vm_startup>", EXEC_MODE, NULL);
+        if(!ok) {
+            py_printexc();
+            return 1;
+        }
+    }
+    py_switchvm(0);
+    double t3 = now_us();
+    py_finalize();
+    double t4 = now_us();
+
+    printf("create:        %.1f us/vm\n", (t1 - t0) / count);
+    printf("reset + run:   %.1f us/vm\n", (t2 - t1) / count);
+    printf("clone + run:   %.1f us/vm\n", (t3 - t2) / count);
+    printf("destroy:       %.1f us/vm\n", (t4 - t3) / (count * 2 + 1));
+    return 0;
+}
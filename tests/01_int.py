@@ -871,4 +871,27 @@ assert 9 // 7 == 1
 assert 9 % 8 == 1
 assert 9 // 8 == 1
 assert 9 % 9 == 0
-assert 9 // 9 == 1
\ No newline at end of file
+assert 9 // 9 == 1
+# test int/float fast paths and their fallbacks
+assert 1 + 2.5 == 3.5
+assert 2.5 - 1 == 1.5
+assert 3 / 2 == 1.5
+assert 7 & 3 == 3 and 4 | 1 == 5 and 6 ^ 3 == 5
+assert 1 << 3 == 8 and -16 >> 2 == -4
+assert (2 < 2.5) and (2.5 >= 2) and not (3 == 3.5)
+x = 0
+for i in range(100):
+    x += i
+assert x == 4950
+
+try:
+    1 // 0
+    exit(1)
+except ZeroDivisionError:
+    pass
+
+try:
+    1 % 0
+    exit(1)
+except ZeroDivisionError:
+    pass
@@ -218,3 +218,10 @@ assert "{{abc}}".format() == "{abc}"
 
 # test f-string
 # stack=[1,2,3,4]; assert f"{stack[2:]}" == '[3, 4]'
+
+# hashes are cached, equal strings built in different ways agree
+s = 'a_rather_long_key_' * 3
+t = 'a_rather_long_key_a_rather_long_key_' + 'a_rather_long_key_'
+assert s is not t and s == t and hash(s) == hash(t) and hash(s) == hash(s)
+assert hash('') == hash(''.join([])) and hash('abc') != hash('abd')
+assert {s: 1}[t] == 1 and {'ABC'.lower(): 2}['abc'] == 2
@@ -147,4 +147,19 @@ for i in range(-1000, 1000):
 e = {}
 for i in range(-10000, 10000, 3):
     e[i] = i
-    assert e[i] == i
\ No newline at end of file
+    assert e[i] == i
+# growth, deletion and reinsertion keep the insertion order
+d = {}
+for i in range(10000):
+    d[i * 1024] = i
+    d[str(i)] = i
+for i in range(0, 10000, 2):
+    del d[i * 1024]
+    del d[str(i)]
+assert len(d) == 10000
+for i in range(0, 10000, 2):
+    d[i * 1024] = -i
+assert d[2048] == -2 and d[1024] == 1 and d['9999'] == 9999 and '0' not in d
+assert list(d.keys())[:3] == [1024, '1', 3 * 1024]
+assert list(d.keys())[-1] == 9998 * 1024
+assert d.get(1.5) is None and d.get((1, 2)) is None
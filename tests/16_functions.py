@@ -185,3 +185,28 @@ assert f(1, 2) == 3
 #         pass
     
 # assert A().f(1, 2, 3) == None
+
+# global name caches must observe new, shadowing and deleted globals
+def use_len():
+    return len([1, 2, 3])
+
+def use_g():
+    return g
+
+for _ in range(3):
+    assert use_len() == 3
+len = lambda x: 42
+assert use_len() == 42
+del len
+assert use_len() == 3
+
+g = 1
+assert use_g() == 1
+g = 2
+assert use_g() == 2
+del g
+try:
+    use_g()
+    exit(1)
+except NameError:
+    pass
@@ -0,0 +1,130 @@
+import gc
+import json
+
+# the value stack starts small and grows by segments
+def depth(n):
+    if n == 0:
+        return 0
+    return depth(n - 1) + 1
+
+assert depth(1000) == 1000
+assert depth(1000) == 1000
+
+# locals on older segments are kept alive by gc
+def build(n):
+    a = [n, str(n)]
+    if n == 0:
+        gc.collect()
+        return 0
+    res = build(n - 1)
+    assert a == [n, str(n)]
+    return res + a[0]
+
+assert build(500) == 500 * 501 // 2
+
+# infinite recursion is still an error and the stack is usable afterwards
+def forever(n):
+    return forever(n + 1)
+
+try:
+    forever(0)
+    exit(1)
+except StackOverflowError:
+    pass
+
+assert depth(1000) == 1000
+
+# exceptions unwind through the segments
+def fail(n):
+    if n == 0:
+        raise ValueError(n)
+    return fail(n - 1)
+
+try:
+    fail(800)
+    exit(1)
+except ValueError:
+    pass
+
+def catch(n):
+    if n == 0:
+        try:
+            fail(800)
+        except ValueError:
+            return 'caught'
+    return catch(n - 1)
+
+assert catch(400) == 'caught'
+
+# generators are resumed on any segment
+def counter():
+    i = 0
+    while True:
+        yield i
+        i += 1
+
+def gen_at(g, n):
+    if n == 0:
+        return next(g)
+    return gen_at(g, n - 1)
+
+g = counter()
+assert next(g) == 0
+assert gen_at(g, 700) == 1
+assert next(g) == 2
+assert gen_at(g, 300) == 3
+
+def walk(n):
+    if n == 0:
+        yield 'leaf'
+        return
+    yield n
+    for x in walk(n - 1):
+        yield x
+
+res = list(walk(200))
+assert res[0] == 200 and res[-1] == 'leaf' and len(res) == 201
+
+# a frame which grows by itself is moved to a larger segment
+items = ', '.join([str(i) for i in range(600)])
+
+def big_literal(n):
+    x = n
+    if n == 0:
+        a = eval('[' + items + ']')
+        return a[-1] + x
+    return big_literal(n - 1)
+
+assert big_literal(100) == 599
+
+def class_at(n):
+    if n == 0:
+        exec('class A:\n    x = [' + items + ']\n    y = 1', globals())
+        return A
+    return class_at(n - 1)
+
+A = class_at(50)
+assert len(A.x) == 600 and A.y == 1
+
+assert json.loads('[' * 1000 + ']' * 1000) == json.loads('[' * 1000 + ']' * 1000)
+assert isinstance(gc.trim(), int)
+
+# gc runs while the segments are entered, after big blocks were freed
+def churn():
+    for i in range(20):
+        b = ('x' * 100000).encode()
+        del b
+
+def ping(n):
+    if n == 0:
+        churn()
+        gc.collect()
+        return 0
+    return pong(n - 1) + 1
+
+def pong(n):
+    return ping(n - 1) + 1
+
+for i in range(3):
+    churn()
+    assert ping(400 + i * 100) == 400 + i * 100
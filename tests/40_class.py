@@ -130,3 +130,79 @@ assert MyClass.a == (1, 2, 3)
 assert MyClass.b == 1
 assert MyClass.c == 2
 assert MyClass.d == 3
+
+# attribute inline caches must observe class mutations
+class Base:
+    def f(self):
+        return 1
+
+class Derived(Base):
+    pass
+
+def call_f(obj):
+    return obj.f()
+
+def get_g(obj):
+    return obj.g
+
+d = Derived()
+for _ in range(3):
+    assert call_f(d) == 1
+Base.f = lambda self: 2
+assert call_f(d) == 2
+Derived.f = lambda self: 3
+assert call_f(d) == 3
+del Derived.f
+assert call_f(d) == 2
+
+d.g = 10
+assert get_g(d) == 10
+Base.g = property(lambda self: 20)
+assert get_g(d) == 20
+del Base.g
+assert get_g(d) == 10
+assert call_f(Base()) == 2
+
+# instance attributes stored by shape
+class Point:
+    def __init__(self, x, y):
+        self.x = x
+        self.y = y
+
+def get_x(p):
+    return p.x
+
+pts = [Point(i, -i) for i in range(100)]
+pts.append(Point('a', 'b'))
+pts[50].z = 1
+assert [get_x(p) for p in pts[:3]] == [0, 1, 2]
+assert get_x(pts[50]) == 50 and pts[50].z == 1
+assert get_x(pts[-1]) == 'a'
+assert sorted(pts[50].__dict__.items()) == [('x', 50), ('y', -50), ('z', 1)]
+
+# delete the last added attribute, then one in the middle
+del pts[50].z
+assert not hasattr(pts[50], 'z')
+del pts[50].x
+assert pts[50].__dict__.items() == [('y', -50)]
+pts[50].x = 5
+assert get_x(pts[50]) == 5 and pts[50].y == -50
+assert get_x(pts[49]) == 49
+
+# many attributes, and many different attributes added to the same shape
+p = Point(0, 0)
+for i in range(100):
+    setattr(p, 'a' + str(i), i)
+assert p.a99 == 99 and len(p.__dict__.items()) == 102
+for i in range(40):
+    q = Point(0, 0)
+    setattr(q, 'b' + str(i), i)
+    assert getattr(q, 'b' + str(i)) == i
+    assert len(q.__dict__.items()) == 3
+
+p.__dict__.clear()
+assert not hasattr(p, 'x')
+q.__dict__.clear()
+assert not hasattr(q, 'x')
+q.x = 1
+assert get_x(q) == 1
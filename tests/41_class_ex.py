@@ -167,4 +167,77 @@ class DerivedClass(BaseClass):
         return super().f()
 
     
-assert DerivedClass.f() == 'BaseClass'
\ No newline at end of file
+assert DerivedClass.f() == 'BaseClass'
+# __slots__
+class Vec:
+    __slots__ = ('x', 'y')
+
+    def __init__(self, x, y):
+        self.x = x
+        self.y = y
+
+    def __add__(self, other):
+        return Vec(self.x + other.x, self.y + other.y)
+
+class Vec3(Vec):
+    __slots__ = 'z'
+
+    def __init__(self, x, y, z):
+        super().__init__(x, y)
+        self.z = z
+
+class Vec3Sub(Vec3):
+    pass
+
+v = Vec(1, 2) + Vec(3, 4)
+assert (v.x, v.y) == (4, 6)
+assert v.__dict__ is None
+assert type(Vec.x).__name__ == 'member_descriptor'
+v.x = 'a'
+assert v.x == 'a'
+
+try:
+    v.z = 1
+    exit(1)
+except AttributeError:
+    pass
+
+del v.y
+assert not hasattr(v, 'y')
+try:
+    del v.y
+    exit(1)
+except AttributeError:
+    pass
+v.y = 0
+assert v.y == 0
+
+u = Vec3Sub(1, 2, 3)
+assert (u.x, u.y, u.z) == (1, 2, 3)
+u.z += 1
+assert u.z == 4
+try:
+    u.w = 1
+    exit(1)
+except AttributeError:
+    pass
+
+# a base class with __dict__ keeps it in subclasses
+class Plain:
+    pass
+
+class PlainSub(Plain):
+    __slots__ = ('x',)
+
+p = PlainSub()
+p.x = 1
+p.w = 2
+assert p.x == 1 and p.w == 2
+
+try:
+    class Bad:
+        __slots__ = ('x',)
+        x = 1
+    exit(1)
+except ValueError:
+    pass
@@ -87,4 +87,82 @@ assert not {1,2,3}.isdisjoint({2,3,4})
 
 # a = set()
 # b = {*a, 1, 2, 3, *a, *a}
-# assert b == {1, 2, 3}
\ No newline at end of file
+# assert b == {1, 2, 3}
+
+# native set
+a = {1, 2, 3}
+assert repr(a) == '{1, 2, 3}'
+assert repr(set()) == 'set()'
+assert sorted(list(a)) == [1, 2, 3]
+assert a.pop() in (1, 2, 3)
+assert len(a) == 2
+try:
+    set().pop()
+    exit(1)
+except KeyError:
+    pass
+try:
+    {1}.remove(2)
+    exit(1)
+except KeyError:
+    pass
+try:
+    hash({1, 2})
+    exit(1)
+except TypeError:
+    pass
+
+assert set('abca') == {'a', 'b', 'c'}
+assert set({1: 2, 3: 4}) == {1, 3}
+assert set(range(3)) == {0, 1, 2}
+assert {1, 2}.union([2, 3], (4,)) == {1, 2, 3, 4}
+assert {1, 2, 3}.intersection([2, 3, 4], {3}) == {3}
+assert {1, 2, 3}.difference([1], [2]) == {3}
+assert {1, 2}.symmetric_difference([2, 3, 3]) == {1, 3}
+assert {1, 2}.issubset([1, 2, 3])
+assert {1, 2, 3}.issuperset(range(3)) == False
+
+a = {1, 2, 3}
+a.intersection_update({2, 3, 4})
+assert a == {2, 3}
+a.difference_update([3])
+assert a == {2}
+a.symmetric_difference_update([2, 5])
+assert a == {5}
+a.update([1], [2])
+assert a == {1, 2, 5}
+a.difference_update(a)
+assert a == set()
+
+assert {1, 2} <= {1, 2}
+assert not {1, 2} < {1, 2}
+assert {1} < {1, 2}
+assert {1, 2} >= {2}
+assert {1, 2} > {2}
+assert {1, 2} != {1, 3}
+assert ({1} == [1]) == False
+
+class MySet(set):
+    pass
+
+s = MySet([1, 2])
+assert isinstance(s, set)
+assert s == {1, 2}
+s.x = 1
+assert s.x == 1
+
+# frozenset
+f = frozenset([1, 2, 2])
+assert f == {1, 2}
+assert {1, 2} == f
+assert repr(f) == 'frozenset({1, 2})'
+assert repr(frozenset()) == 'frozenset()'
+assert hash(f) == hash(frozenset([2, 1]))
+assert type(f | {3}) is frozenset
+assert type({3} | f) is set
+assert f & {2, 3} == {2}
+assert 1 in f and 3 not in f
+d = {f: 1}
+assert d[frozenset({1, 2})] == 1
+assert not hasattr(f, 'add')
+assert {frozenset([1]), frozenset([1])} == {frozenset([1])}
@@ -50,3 +50,12 @@ assert hasattr(a, 'zzz')
 
 assert not hasattr(a, '')
 
+
+# names are not limited to 65535
+class Names: pass
+o = Names()
+for i in range(70000):
+    setattr(o, 'name_' + str(i), i)
+assert getattr(o, 'name_69999') == 69999
+exec('name_70000 = 1')
+assert eval('name_70000 + 1') == 2
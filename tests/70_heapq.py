@@ -6,4 +6,33 @@ b = sorted(a)
 
 heapify(a)
 for x in b:
-    assert heappop(a) == x
\ No newline at end of file
+    assert heappop(a) == x
+
+from heapq import heapreplace, heappushpop
+
+h = []
+for x in [5, 1, 4, 2, 3]:
+    heappush(h, x)
+assert h[0] == 1
+assert heapreplace(h, 6) == 1
+assert heappushpop(h, 0) == 0
+assert heappushpop(h, 7) == 2
+assert [heappop(h) for _ in range(len(h))] == [3, 4, 5, 6, 7]
+
+try:
+    heappop([])
+    exit(1)
+except IndexError:
+    pass
+
+# priority queue of tuples
+h = []
+heappush(h, (2, 'b'))
+heappush(h, (1, 'a'))
+heappush(h, (3, 'c'))
+assert heappop(h) == (1, 'a')
+assert heappop(h) == (2, 'b')
+
+a = [3.5, 1, 2.5, 0]
+heapify(a)
+assert heappop(a) == 0 and heappop(a) == 1 and heappop(a) == 2.5
@@ -9,4 +9,76 @@ gc.collect()
 
 create_garbage()
 create_garbage()
-create_garbage()
\ No newline at end of file
+create_garbage()
+# old objects pointing to young ones must survive minor collections
+old = [[], {}, set()]
+gc.collect()
+for i in range(1000):
+    old[0].append([i])
+    old[1][i] = (i, i)
+    old[2].add(str(i))
+    if i % 100 == 0:
+        gc.collect(0)
+gc.collect(0)
+assert old[0][999] == [999]
+assert old[1][500] == (500, 500)
+assert '123' in old[2]
+gc.collect()
+assert sum([x[0] for x in old[0]]) == 499500
+
+try:
+    gc.collect(2)
+    exit(1)
+except ValueError:
+    pass
+
+# marking is iterative, so deep structures can't overflow the C stack
+deep = []
+for i in range(1000000):
+    deep = [deep]
+gc.collect()
+del deep
+gc.collect()
+
+stats = gc.get_stats()
+assert stats['full_collections'] > 0
+assert stats['freed'] >= 1000000
+assert stats['mark_time'] >= 0 and stats['sweep_time'] >= 0
+assert stats['total_mark_time'] >= stats['mark_time']
+
+# incremental collection
+keep = [[i] for i in range(40000)]
+gc.collect()
+n = gc.get_stats()['full_collections']
+i = 0
+while not gc.step(1):
+    keep[i] = [i, i]    # young values stored into traced objects during the cycle
+    i += 1
+assert i > 0
+assert gc.get_stats()['full_collections'] == n + 1
+gc.collect()
+assert keep[0] == [0, 0] and keep[i-1] == [i-1, i-1] and keep[i] == [i]
+
+# empty arenas are released after a load spike
+burst = [[i] for i in range(200000)]
+del burst
+assert gc.trim() > 0
+assert gc.trim() >= 0
+
+# subclasses of native types keep their items alive
+from collections import deque
+
+class Items(dict): pass
+class Queue(deque): pass
+
+items = Items()
+queue = Queue()
+for i in range(100):
+    items[i] = [str(i)]
+    queue.append([str(i)])
+gc.collect()
+junk = [[str(i)] for i in range(10000)]
+del junk
+gc.collect()
+assert items[0] == ['0'] and items[99] == ['99']
+assert queue[0] == ['0'] and queue[99] == ['99']
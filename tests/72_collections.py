@@ -516,3 +516,39 @@ d = deque()
 for i in range(100):
     d.append(1)
     gc.collect()
+
+d = deque([1, 2, 3], 2)
+assert d == deque([2, 3]) and d.maxlen == 2
+d.appendleft(1)
+assert list(d) == [1, 2]
+assert repr(d) == 'deque([1, 2], maxlen=2)'
+assert deque().maxlen is None
+
+d = deque([1, 2, 3], maxlen=3)
+assert list(d) == [1, 2, 3] and d.maxlen == 3
+d = deque(maxlen=1)
+d.append(1)
+d.append(2)
+assert list(d) == [2]
+assert deque(iterable='ab', maxlen=None) == deque('ab')
+
+class MyDeque(deque):
+    pass
+
+d = MyDeque([1, 2], maxlen=1)
+assert list(d) == [2] and d.maxlen == 1
+
+try:
+    deque([], -1)
+    exit(1)
+except ValueError:
+    pass
+
+d = deque(range(5))
+assert d[0] == 0 and d[-1] == 4
+d[1] = 10
+assert d.index(10) == 1
+d.remove(10)
+assert list(d) == [0, 2, 3, 4]
+d.reverse()
+assert list(d) == [4, 3, 2, 0]
@@ -25,7 +25,7 @@ assert json.loads("true") == True
 assert json.loads("false") == False
 assert json.loads("{}") == {}
 
-# assert json.loads(b"false") == False
+assert json.loads(b"false") == False
 
 _j = json.dumps(a)
 _a = json.loads(_j)
@@ -79,3 +79,45 @@ try:
     assert False
 except TypeError:
     assert True
+
+assert json.loads(' { "a" : [1, -2, 3.5, -0.25, 1e3, 2E-2] , "b": {} }\n') == {'a': [1, -2, 3.5, -0.25, 1000.0, 0.02], 'b': {}}
+assert json.loads(b'[true, false, null]') == [True, False, None]
+assert json.loads('"a\\"b\\\\c\\/d\\n\\t"') == 'a"b\\c/d\n\t'
+assert json.loads('"\\u4f60\\u597d"') == '你好'
+assert json.loads('"\\ud83d\\ude00"') == b'\xf0\x9f\x98\x80'.decode()
+assert json.loads('"你好"') == '你好'
+assert json.loads('[Infinity, -Infinity]') == [float('inf'), float('-inf')]
+assert json.loads(json.dumps('\x01\x02')) == '\x01\x02'
+assert json.loads('[[[[]]]]') == [[[[]]]]
+
+# the int64 range parses as int, anything larger as float
+x = json.loads('[9223372036854775807, -9223372036854775808, 0, -0]')
+assert x == [9223372036854775807, -9223372036854775807 - 1, 0, 0]
+assert all([type(v) is int for v in x])
+assert type(json.loads('9223372036854775808')) is float
+assert type(json.loads('-9223372036854775809')) is float
+
+def _check_error(s, msg):
+    try:
+        json.loads(s)
+        exit(1)
+    except ValueError as e:
+        assert str(e) == msg, str(e)
+
+_check_error('', 'Expecting value: line 1 column 1')
+_check_error('[1, 2,]', 'Expecting value: line 1 column 7')
+_check_error('{"a": 1,\n "b" 2}', "Expecting ':' delimiter: line 2 column 6")
+_check_error("{'a': 1}", 'Expecting property name enclosed in double quotes: line 1 column 2')
+_check_error('[1 2]', "Expecting ',' delimiter: line 1 column 4")
+_check_error('"abc', 'Unterminated string: line 1 column 1')
+_check_error('"\\q"', 'Invalid \\escape: line 1 column 2')
+_check_error('1 2', 'Extra data: line 1 column 3')
+_check_error('01', 'Extra data: line 1 column 2')
+_check_error('tru', 'Expecting value: line 1 column 1')
+_check_error('1 + 1', 'Extra data: line 1 column 3')
+
+try:
+    json.loads(1)
+    exit(1)
+except TypeError:
+    pass
@@ -23,3 +23,43 @@ sub_10 = partial(sub, b=10)
 assert sub_10(20) == 10
 assert sub_10(30) == 20
 
+
+# test cache
+from functools import cache
+
+calls = 0
+
+@cache
+def fib(n):
+    global calls
+    calls += 1
+    return n if n < 2 else fib(n - 1) + fib(n - 2)
+
+assert fib(60) == 1548008755920
+assert calls == 61
+assert fib(60) == 1548008755920
+assert calls == 61
+
+@cache
+def add(a, b):
+    global calls
+    calls += 1
+    return a + b
+
+assert add(1, 2) == 3
+assert add(1, 2) == 3
+assert calls == 62
+add.cache_clear()
+assert add(1, 2) == 3
+assert calls == 63
+
+# the new cache of an old function survives a minor collection
+import gc
+gc.collect()
+add.cache_clear()
+assert add(3, 4) == 7
+gc.collect(0)
+junk = [[str(i)] for i in range(10000)]
+del junk
+assert add(3, 4) == 7
+assert calls == 64
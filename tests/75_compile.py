@@ -3,3 +3,39 @@ assert eval("1+2") == 3
 code = compile("1+2", "<eval>", "eval")
 # print(code)
 assert eval(code) == 3
+
+# binary code files
+try:
+    import os
+    import py_compile
+except ImportError:
+    print('os is not enabled, skipping test...')
+    exit(0)
+
+with open('_pkc_test.py', 'wt') as f:
+    f.write('def f(a, *args, b=(1, "x"), c=None, **kw):\n    """doc"""\n    return [a, b, c, len(kw)]\n\nclass A:\n    x: int = 1\n    def g(self, **kw): return kw\nvalue = f(1, c=2.5, d=3)\n')
+
+assert py_compile.compile('_pkc_test.py') == '_pkc_test.pkc'
+import _pkc_test
+assert _pkc_test.value == [1, (1, 'x'), 2.5, 1]
+assert _pkc_test.f.__doc__ == 'doc'
+assert _pkc_test.A().g(key=1) == {'key': 1}
+os.remove('_pkc_test.py')
+os.remove('_pkc_test.pkc')
+
+# a stale .pkc file is ignored
+with open('_pkc_test2.py', 'wt') as f:
+    f.write('value = 1\n')
+py_compile.compile('_pkc_test2.py')
+with open('_pkc_test2.py', 'wt') as f:
+    f.write('value = 2\n')
+import _pkc_test2
+assert _pkc_test2.value == 2
+
+# a .pkc file without its source is imported as is
+py_compile.compile('_pkc_test2.py', '_pkc_test3.pkc')
+import _pkc_test3
+assert _pkc_test3.value == 2
+os.remove('_pkc_test2.py')
+os.remove('_pkc_test2.pkc')
+os.remove('_pkc_test3.pkc')
@@ -585,6 +585,42 @@ assert min([
 assert min(1, 2) == 1
 assert max(1, 2) == 2
 
+# native sum/min/max/map/filter/zip/enumerate
+assert sum([0.5, 1.5, 2]) == 4.0
+assert sum((1, 2, 3), 10) == 16
+assert sum(range(101)) == 5050
+assert sum(range(10, 0, -3)) == 10 + 7 + 4 + 1
+assert sum(range(5, 5)) == 0
+def gen(a):
+    for x in a:
+        yield x
+
+assert sum(gen([1, 2])) == 3
+assert sum([[1], [2]], []) == [1, 2]
+
+assert min([3, 1, 2]) == 1 and max([3, 1, 2]) == 3
+assert min(3, 1.5) == 1.5 and max(1, 2, 3) == 3
+assert min(['aa', 'b', 'ccc'], key=len) == 'b'
+assert max(['aa', 'b', 'ccc'], key=len) == 'ccc'
+assert max(iter([2, 5, 1])) == 5
+try:
+    max([])
+    exit(1)
+except ValueError:
+    pass
+
+assert list(map(lambda x, y: x * y, [1, 2, 3], (4, 5))) == [4, 10]
+assert list(filter(None, [0, 1, '', 'a'])) == [1, 'a']
+assert list(zip([1, 2, 3], 'ab', range(10))) == [(1, 'a', 0), (2, 'b', 1)]
+assert list(zip()) == []
+assert list(enumerate('ab', start=1)) == [(1, 'a'), (2, 'b')]
+assert list(enumerate(gen('ab'))) == [(0, 'a'), (1, 'b')]
+assert isinstance(zip([], []), zip)
+it = map(str, [1, 2])
+assert iter(it) is it and next(it) == '1'
+assert all([1, True]) and not all([1, 0]) and any(gen([0, 2])) and not any([])
+assert sorted((3, 1, 2), reverse=True) == [3, 2, 1]
+
 exit()
 
 dir_int = dir(int)
@@ -0,0 +1,54 @@
+try:
+    import os
+except ImportError:
+    print('os is not enabled, skipping test...')
+    exit(0)
+
+from pkpy.executor import Executor
+
+with open('_executor_test.py', 'wt') as f:
+    f.write('def work(i, n):\n    s = 0\n    for k in range(n):\n        s += k % (i + 1)\n    return {"i": i, "s": s}\n\ndef fail():\n    raise ValueError("boom")\n')
+
+def work(i, n):
+    s = 0
+    for k in range(n):
+        s += k % (i + 1)
+    return {"i": i, "s": s}
+
+with Executor(4) as ex:
+    futures = [ex.submit('_executor_test.work', (i, 1000)) for i in range(10)]
+    for i in range(10):
+        assert futures[i].result() == work(i, 1000)
+        assert futures[i].done()
+    assert ex.submit('math.gcd', (12, 18)).result() == 6
+
+    try:
+        ex.submit('_executor_test.fail').result()
+        exit(1)
+    except RuntimeError as e:
+        assert 'ValueError: boom' in str(e)
+
+    try:
+        ex.submit('_executor_test.missing').result()
+        exit(1)
+    except RuntimeError as e:
+        assert 'AttributeError' in str(e)
+
+    try:
+        ex.submit('work', ())
+        exit(1)
+    except ValueError:
+        pass
+
+# tasks submitted before shutdown are done
+ex = Executor(2)
+futures = [ex.submit('_executor_test.work', (i, 100)) for i in range(4)]
+ex.shutdown()
+assert [f.result() for f in futures] == [work(i, 100) for i in range(4)]
+try:
+    ex.submit('math.gcd', (1, 2))
+    exit(1)
+except RuntimeError:
+    pass
+
+os.remove('_executor_test.py')
@@ -112,9 +112,7 @@ class A:
 
 bad_dict = {A(): 1, A(): 2, A(): 3, A(): 4}
 assert len(bad_dict) == 4
-try:
-    bad_dict[A()] = 5   # error
-    exit(1)
-except RuntimeError as e:
-    assert 'maximum collision reached' in str(e)
+for i in range(100):
+    bad_dict[A()] = i   # every key collides, probing still finds a slot
+assert len(bad_dict) == 104
 